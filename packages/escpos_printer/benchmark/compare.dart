@@ -0,0 +1,68 @@
+// Compares two escpos_benchmark.dart reports stage by stage.
+//
+//   dart run benchmark/compare.dart before.json after.json [--threshold=10]
+//
+// Prints the change in ops/s for every stage and corpus found in both files
+// and exits with code 1 when any of them got slower by more than the
+// threshold (in percent).
+
+import 'dart:convert';
+import 'dart:io';
+
+void main(List<String> arguments) {
+  var threshold = 10.0;
+  final paths = <String>[];
+  for (final argument in arguments) {
+    if (argument.startsWith('--threshold=')) {
+      threshold = double.parse(argument.substring('--threshold='.length));
+    } else {
+      paths.add(argument);
+    }
+  }
+  if (paths.length != 2) {
+    stderr.writeln(
+      'usage: dart run benchmark/compare.dart before.json after.json '
+      '[--threshold=percent]',
+    );
+    exitCode = 64;
+    return;
+  }
+
+  final before = _load(paths[0]);
+  final after = _load(paths[1]);
+  var regressions = 0;
+  for (final entry in after.entries) {
+    final baseline = before[entry.key];
+    if (baseline == null) {
+      stdout.writeln('${entry.key.padRight(44)}        new');
+      continue;
+    }
+    final change = (entry.value - baseline) / baseline * 100;
+    final regressed = change < -threshold;
+    if (regressed) {
+      regressions++;
+    }
+    stdout.writeln(
+      '${entry.key.padRight(44)} '
+      '${baseline.toStringAsFixed(1).padLeft(10)} -> '
+      '${entry.value.toStringAsFixed(1).padLeft(10)} ops/s '
+      '${change >= 0 ? '+' : ''}${change.toStringAsFixed(1)}%'
+      '${regressed ? '  REGRESSION' : ''}',
+    );
+  }
+  if (regressions > 0) {
+    stdout.writeln('$regressions stage(s) slower by more than $threshold%.');
+    exitCode = 1;
+  }
+}
+
+/// ops/s keyed by "stage corpus".
+Map<String, double> _load(String path) {
+  final report = jsonDecode(File(path).readAsStringSync());
+  final results = (report as Map<String, Object?>)['results'] as List<Object?>;
+  return <String, double>{
+    for (final result in results.cast<Map<String, Object?>>())
+      '${result['stage']} ${result['corpus']}':
+          (result['opsPerSecond'] as num).toDouble(),
+  };
+}
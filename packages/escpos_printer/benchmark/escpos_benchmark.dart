@@ -0,0 +1,136 @@
+// Throughput of the template pipeline (render, parse, encode) and of jobs
+// through EscPosClient, on the corpora in src/corpus.dart.
+//
+//   flutter test benchmark/escpos_benchmark.dart
+//   ESCPOS_BENCHMARK_OUT=after.json flutter test benchmark/escpos_benchmark.dart
+//   dart run benchmark/compare.dart before.json after.json
+//
+// Results are printed as JSON and, with ESCPOS_BENCHMARK_OUT, written to that
+// file. `flutter test` runs in JIT mode, so compare runs from the same machine
+// rather than reading the numbers as absolute.
+
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:escpos_printer/escpos_printer.dart';
+import 'package:escpos_printer/src/encoding/escpos_encoder.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+import 'src/corpus.dart';
+import 'src/harness.dart';
+import 'src/memory_transport.dart';
+
+/// Jobs per `printBatch` call in the batch stage.
+const int _batchSize = 20;
+
+const PrintOptions _printOptions = PrintOptions(
+  statusStrategy: StatusStrategy.skip,
+);
+
+void main() {
+  test('escpos_printer benchmarks', () async {
+    final harness = BenchmarkHarness();
+    const renderer = MustacheRenderer();
+    const parser = EscTplParser();
+    const encoder = EscPosEncoder();
+
+    final factory = MemoryTransportFactory();
+    final client = EscPosClient(transportFactory: factory);
+    await client.connect(const WifiEndpoint('memory'));
+
+    for (final corpus in buildCorpora()) {
+      final compiled = renderer.compile(corpus.template);
+      final rendered = compiled.render(corpus.variables);
+      final ops = parser.parse(rendered);
+
+      _report(
+        harness.measure('render', corpus.name, () {
+          return compiled.render(corpus.variables).length;
+        }, outputUnit: 'chars'),
+      );
+      _report(
+        harness.measure('parse', corpus.name, () {
+          return parser.parse(rendered).length;
+        }, outputUnit: 'ops'),
+      );
+      _report(
+        harness.measure('encode', corpus.name, () {
+          return encoder.encode(ops).length;
+        }),
+      );
+      _report(
+        await harness.measureAsync('client_print', corpus.name, () async {
+          final result = await client.printFromString(
+            template: corpus.template,
+            variables: corpus.variables,
+            printOptions: _printOptions,
+          );
+          return result.bytesSent;
+        }),
+      );
+    }
+
+    final receipt = buildCorpora().first;
+    final jobs = List<PrintJob>.filled(
+      _batchSize,
+      PrintJob(
+        template: ReceiptTemplate.string(receipt.template),
+        variables: receipt.variables,
+      ),
+    );
+    _report(
+      await harness.measureAsync(
+        'client_batch_$_batchSize',
+        receipt.name,
+        () async {
+          final result = await client.printBatch(
+            jobs,
+            printOptions: _printOptions,
+          );
+          return result.bytesSent;
+        },
+      ),
+    );
+    await client.disconnect();
+
+    final report = const JsonEncoder.withIndent('  ').convert(
+      <String, Object?>{
+        'schemaVersion': 1,
+        'generatedAt': DateTime.now().toUtc().toIso8601String(),
+        'commit': _gitCommit(),
+        'dartVersion': Platform.version,
+        'operatingSystem': Platform.operatingSystem,
+        'processors': Platform.numberOfProcessors,
+        'results': harness.results.map((result) => result.toJson()).toList(),
+      },
+    );
+    // ignore: avoid_print
+    print(report);
+    final outPath = Platform.environment['ESCPOS_BENCHMARK_OUT'];
+    if (outPath != null && outPath.isNotEmpty) {
+      File(outPath).writeAsStringSync('$report\n');
+    }
+  }, timeout: Timeout.none);
+}
+
+void _report(StageResult result) {
+  // ignore: avoid_print
+  print(
+    '${result.stage.padRight(16)} ${result.corpus.padRight(26)} '
+    '${result.opsPerSecond.toStringAsFixed(1).padLeft(10)} ops/s '
+    '${result.outputSize} ${result.outputUnit}',
+  );
+}
+
+String? _gitCommit() {
+  final fromEnvironment = Platform.environment['ESCPOS_BENCHMARK_COMMIT'];
+  if (fromEnvironment != null && fromEnvironment.isNotEmpty) {
+    return fromEnvironment;
+  }
+  try {
+    final result = Process.runSync('git', <String>['rev-parse', 'HEAD']);
+    return result.exitCode == 0 ? (result.stdout as String).trim() : null;
+  } on ProcessException {
+    return null;
+  }
+}
@@ -0,0 +1,173 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+/// A template and the variables it is rendered with.
+final class BenchmarkCorpus {
+  const BenchmarkCorpus(this.name, this.template, this.variables);
+
+  final String name;
+
+  /// Mustache + EscTpl source, as passed to `printFromString`.
+  final String template;
+  final Map<String, Object?> variables;
+}
+
+/// Inputs shaped like real print traffic, from a short counter receipt to
+/// label-sized rasters.
+List<BenchmarkCorpus> buildCorpora() {
+  return <BenchmarkCorpus>[
+    _receipt(10),
+    _receipt(100),
+    _receipt(1000),
+    _wideTable(rows: 200, columns: 8),
+    _qrCodes(50),
+    _raster(widthBytes: 72, heightDots: 2000),
+    _nestedEach(orders: 20, itemsPerOrder: 10, modifiersPerItem: 3),
+  ];
+}
+
+const String _receiptTemplate = '''
+@text align=center bold=true width=2 height=2 {{store}}
+@text align=center {{address}}
+@text Order {{orderId}} - {{date}}
+{{#each items}}@row
+  @col flex=3 {{name}}
+  @col flex=1 align=right {{qty}}
+  @col flex=1 align=right {{price}}
+@endrow
+{{/each}}@row
+  @col flex=4 bold=true TOTAL
+  @col flex=1 align=right bold=true {{total}}
+@endrow
+@qrcode size=6 align=center {{receiptUrl}}
+@barcode type=code128 height=80 align=center {{orderId}}
+@feed lines=3
+@cut mode=partial
+''';
+
+BenchmarkCorpus _receipt(int lines) {
+  var totalCents = 0;
+  final items = <Map<String, Object?>>[];
+  for (var index = 0; index < lines; index++) {
+    final cents = 150 + (index * 37) % 2500;
+    totalCents += cents;
+    items.add(<String, Object?>{
+      'name': 'Item ${index + 1} ${_words[index % _words.length]}',
+      'qty': '${1 + index % 4}',
+      'price': _money(cents),
+    });
+  }
+  return BenchmarkCorpus('receipt_$lines', _receiptTemplate, <String, Object?>{
+    'store': 'Corner Store',
+    'address': '12 Market Street, Springfield',
+    'orderId': 'A${100000 + lines}',
+    'date': '2026-10-18 12:30',
+    'items': items,
+    'total': _money(totalCents),
+    'receiptUrl': 'https://example.com/r/A${100000 + lines}',
+  });
+}
+
+BenchmarkCorpus _wideTable({required int rows, required int columns}) {
+  final header = StringBuffer('@row\n');
+  final cells = StringBuffer('{{#each rows}}@row\n');
+  for (var column = 0; column < columns; column++) {
+    final align = column == 0 ? 'left' : 'right';
+    header.writeln('  @col flex=1 align=$align bold=true C$column');
+    cells.writeln('  @col flex=1 align=$align {{c$column}}');
+  }
+  header.writeln('@endrow');
+  cells.write('@endrow\n{{/each}}@cut mode=full\n');
+
+  final data = <Map<String, Object?>>[];
+  for (var row = 0; row < rows; row++) {
+    data.add(<String, Object?>{
+      for (var column = 0; column < columns; column++)
+        'c$column': '${row * columns + column}',
+    });
+  }
+  return BenchmarkCorpus(
+    'wide_table_${rows}x$columns',
+    '$header$cells',
+    <String, Object?>{'rows': data},
+  );
+}
+
+BenchmarkCorpus _qrCodes(int count) {
+  final codes = <Map<String, Object?>>[];
+  for (var index = 0; index < count; index++) {
+    codes.add(<String, Object?>{
+      'label': 'Ticket ${index + 1}',
+      'payload': 'https://example.com/t/${index.toString().padLeft(6, '0')}'
+          '?sig=${'ab12cd34' * 20}',
+    });
+  }
+  return BenchmarkCorpus(
+    'qr_codes_$count',
+    '{{#each codes}}@text align=center {{label}}\n'
+        '@qrcode size=8 align=center {{payload}}\n'
+        '@feed lines=1\n{{/each}}@cut mode=partial\n',
+    <String, Object?>{'codes': codes},
+  );
+}
+
+BenchmarkCorpus _raster({required int widthBytes, required int heightDots}) {
+  final raster = Uint8List(widthBytes * heightDots);
+  for (var index = 0; index < raster.length; index++) {
+    // Diagonal stripes: neither blank nor solid, like a logo or label art.
+    final row = index ~/ widthBytes;
+    raster[index] = ((index + row) & 0x08) != 0 ? 0xF0 : 0x0F;
+  }
+  return BenchmarkCorpus(
+    'raster_${widthBytes * 8}x$heightDots',
+    '@image widthBytes=$widthBytes heightDots=$heightDots align=center '
+        '{{image}}\n@cut mode=full\n',
+    <String, Object?>{'image': base64Encode(raster)},
+  );
+}
+
+BenchmarkCorpus _nestedEach({
+  required int orders,
+  required int itemsPerOrder,
+  required int modifiersPerItem,
+}) {
+  final data = <Map<String, Object?>>[];
+  for (var order = 0; order < orders; order++) {
+    data.add(<String, Object?>{
+      'id': 'T${order + 1}',
+      'items': <Map<String, Object?>>[
+        for (var item = 0; item < itemsPerOrder; item++)
+          <String, Object?>{
+            'name': _words[(order + item) % _words.length],
+            'modifiers': <String>[
+              for (var modifier = 0; modifier < modifiersPerItem; modifier++)
+                'no ${_words[(item + modifier) % _words.length]}',
+            ],
+          },
+      ],
+    });
+  }
+  return BenchmarkCorpus(
+    'nested_each_${orders}x${itemsPerOrder}x$modifiersPerItem',
+    '{{#each orders}}@text bold=true Table {{id}}\n'
+        '{{#each items}}@text {{name}}\n'
+        '{{#each modifiers}}@text   - {{this}}\n{{/each}}'
+        '{{/each}}@feed lines=1\n{{/each}}@cut mode=partial\n',
+    <String, Object?>{'orders': data},
+  );
+}
+
+String _money(int cents) {
+  return '${cents ~/ 100}.${(cents % 100).toString().padLeft(2, '0')}';
+}
+
+const List<String> _words = <String>[
+  'espresso',
+  'croissant',
+  'sparkling water',
+  'club sandwich',
+  'onion',
+  'caesar salad',
+  'brownie',
+  'iced tea',
+];
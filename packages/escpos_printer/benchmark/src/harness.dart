@@ -0,0 +1,151 @@
+import 'dart:io';
+
+/// Measurement of one stage on one corpus.
+final class StageResult {
+  const StageResult({
+    required this.stage,
+    required this.corpus,
+    required this.iterations,
+    required this.elapsed,
+    required this.outputSize,
+    required this.outputUnit,
+    required this.rssGrowthBytes,
+  });
+
+  final String stage;
+  final String corpus;
+  final int iterations;
+  final Duration elapsed;
+
+  /// What one iteration produced, in [outputUnit]s.
+  final int outputSize;
+  final String outputUnit;
+
+  /// Resident set growth over the measured iterations. The VM does not
+  /// expose allocation counts without the service protocol, so this is the
+  /// portable stand-in: stages that keep allocating past what the GC
+  /// reclaims show up here.
+  final int rssGrowthBytes;
+
+  double get opsPerSecond {
+    return iterations * Duration.microsecondsPerSecond / elapsed.inMicroseconds;
+  }
+
+  double get microsPerOp => elapsed.inMicroseconds / iterations;
+
+  Map<String, Object?> toJson() {
+    return <String, Object?>{
+      'stage': stage,
+      'corpus': corpus,
+      'iterations': iterations,
+      'elapsedMicros': elapsed.inMicroseconds,
+      'opsPerSecond': double.parse(opsPerSecond.toStringAsFixed(2)),
+      'microsPerOp': double.parse(microsPerOp.toStringAsFixed(2)),
+      'outputSize': outputSize,
+      'outputUnit': outputUnit,
+      'rssGrowthBytes': rssGrowthBytes,
+    };
+  }
+}
+
+/// Runs stages for a minimum time each, after a warm-up, so short and long
+/// corpora get comparable confidence.
+final class BenchmarkHarness {
+  BenchmarkHarness({
+    this.warmUp = const Duration(milliseconds: 200),
+    this.minDuration = const Duration(seconds: 1),
+    this.minIterations = 5,
+  });
+
+  final Duration warmUp;
+  final Duration minDuration;
+  final int minIterations;
+
+  final List<StageResult> results = <StageResult>[];
+
+  /// Measures [body], which returns the size of what it produced.
+  StageResult measure(
+    String stage,
+    String corpus,
+    int Function() body, {
+    String outputUnit = 'bytes',
+  }) {
+    final warmUpWatch = Stopwatch()..start();
+    while (warmUpWatch.elapsed < warmUp) {
+      body();
+    }
+
+    final rssBefore = ProcessInfo.currentRss;
+    final watch = Stopwatch()..start();
+    var iterations = 0;
+    var outputSize = 0;
+    while (iterations < minIterations || watch.elapsed < minDuration) {
+      outputSize = body();
+      iterations++;
+    }
+    watch.stop();
+    return _record(
+      stage,
+      corpus,
+      iterations,
+      watch.elapsed,
+      outputSize,
+      outputUnit,
+      rssBefore,
+    );
+  }
+
+  /// [measure] for asynchronous work such as jobs through `EscPosClient`.
+  Future<StageResult> measureAsync(
+    String stage,
+    String corpus,
+    Future<int> Function() body, {
+    String outputUnit = 'bytes',
+  }) async {
+    final warmUpWatch = Stopwatch()..start();
+    while (warmUpWatch.elapsed < warmUp) {
+      await body();
+    }
+
+    final rssBefore = ProcessInfo.currentRss;
+    final watch = Stopwatch()..start();
+    var iterations = 0;
+    var outputSize = 0;
+    while (iterations < minIterations || watch.elapsed < minDuration) {
+      outputSize = await body();
+      iterations++;
+    }
+    watch.stop();
+    return _record(
+      stage,
+      corpus,
+      iterations,
+      watch.elapsed,
+      outputSize,
+      outputUnit,
+      rssBefore,
+    );
+  }
+
+  StageResult _record(
+    String stage,
+    String corpus,
+    int iterations,
+    Duration elapsed,
+    int outputSize,
+    String outputUnit,
+    int rssBefore,
+  ) {
+    final result = StageResult(
+      stage: stage,
+      corpus: corpus,
+      iterations: iterations,
+      elapsed: elapsed,
+      outputSize: outputSize,
+      outputUnit: outputUnit,
+      rssGrowthBytes: ProcessInfo.currentRss - rssBefore,
+    );
+    results.add(result);
+    return result;
+  }
+}
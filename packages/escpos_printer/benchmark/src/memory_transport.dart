@@ -0,0 +1,67 @@
+import 'dart:typed_data';
+
+import 'package:escpos_printer/escpos_printer.dart';
+
+/// Transport that only counts bytes, so client benchmarks measure the
+/// queue, rendering and encoding rather than an I/O device.
+final class MemoryTransport implements BatchWriteTransport {
+  int bytesWritten = 0;
+  int writes = 0;
+  String? _sessionId;
+
+  @override
+  String? get sessionId => _sessionId;
+
+  @override
+  bool get isConnected => _sessionId != null;
+
+  @override
+  PrinterCapabilities get capabilities => const PrinterCapabilities();
+
+  @override
+  Future<void> connect() async {
+    _sessionId = 'memory';
+  }
+
+  @override
+  Future<void> disconnect() async {
+    _sessionId = null;
+  }
+
+  @override
+  Future<void> write(List<int> data) async {
+    bytesWritten += data.length;
+    writes++;
+  }
+
+  @override
+  Future<List<BatchJobResult>> writeBatch(List<Uint8List> jobs) async {
+    var offset = 0;
+    final results = <BatchJobResult>[];
+    for (final job in jobs) {
+      results.add(
+        BatchJobResult(
+          offset: offset,
+          length: job.length,
+          state: BatchJobState.written,
+        ),
+      );
+      offset += job.length;
+    }
+    bytesWritten += offset;
+    writes++;
+    return results;
+  }
+
+  @override
+  Future<PrinterStatus> getStatus() async => const PrinterStatus();
+}
+
+final class MemoryTransportFactory implements TransportFactory {
+  final MemoryTransport transport = MemoryTransport();
+
+  @override
+  Future<PrinterTransport> create(PrinterEndpoint endpoint) async {
+    return transport;
+  }
+}
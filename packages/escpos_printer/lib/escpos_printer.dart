@@ -1,12 +1,17 @@
 library;
 
 export 'src/client/escpos_client.dart';
+export 'src/client/worker_pool.dart';
 export 'src/model/discovery.dart';
 export 'src/model/endpoints.dart';
 export 'src/model/exceptions.dart';
 export 'src/model/options.dart';
+export 'src/model/print_job.dart';
+export 'src/model/printer_profile.dart';
+export 'src/model/queue_stats.dart';
 export 'src/model/result.dart';
 export 'src/model/status.dart';
+export 'src/template/compiled_template.dart';
 export 'src/template/esctpl_parser.dart';
 export 'src/template/mustache_renderer.dart';
 export 'src/template/operations.dart';
@@ -17,5 +22,6 @@ export 'src/transport/native_transport_bridge.dart';
 export 'src/transport/platform_bluetooth_transport.dart';
 export 'src/transport/platform_channel_transport.dart';
 export 'src/transport/platform_usb_transport.dart';
+export 'src/transport/platform_wifi_transport.dart';
 export 'src/transport/transport.dart';
 export 'src/transport/wifi_socket_transport.dart';
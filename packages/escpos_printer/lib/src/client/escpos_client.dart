@@ -1,20 +1,29 @@
 import 'dart:async';
 import 'dart:math';
+import 'dart:typed_data';
 
 import '../discovery/printer_discovery_service.dart';
 import '../encoding/escpos_encoder.dart';
+import '../encoding/op_optimizer.dart';
 import '../model/discovery.dart';
 import '../model/endpoints.dart';
 import '../model/exceptions.dart';
 import '../model/options.dart';
+import '../model/print_job.dart';
 import '../model/result.dart';
 import '../model/status.dart';
+import '../template/compiled_template.dart';
 import '../template/esctpl_parser.dart';
 import '../template/mustache_renderer.dart';
 import '../template/operations.dart';
 import '../template/receipt_template.dart';
+import '../template/template_resolver.dart';
 import '../transport/default_transport_factory.dart';
 import '../transport/transport.dart';
+import 'priority_lane.dart';
+import 'serial_lane.dart';
+import 'worker_pool.dart';
+import 'write_pipeline.dart';
 
 final class EscPosClient {
   EscPosClient({
@@ -23,21 +32,53 @@ final class EscPosClient {
     ReconnectPolicy reconnectPolicy = const ReconnectPolicy(),
     MustacheRenderer renderer = const MustacheRenderer(),
     EscTplParser parser = const EscTplParser(),
+    TemplateCache? templateCache,
+    EscPosWorkerPool? workerPool,
   }) : _transportFactory = transportFactory ?? DefaultTransportFactory(),
        _discoveryService = discoveryService ?? PrinterDiscoveryService(),
        _defaultReconnectPolicy = reconnectPolicy,
-       _renderer = renderer,
-       _parser = parser;
+       _resolver = TemplateResolver(
+         templateCache: templateCache ?? TemplateCache(renderer: renderer),
+         parser: parser,
+       ),
+       _workerPool = workerPool;
 
   final TransportFactory _transportFactory;
   final PrinterDiscoveryService _discoveryService;
   final ReconnectPolicy _defaultReconnectPolicy;
-  final MustacheRenderer _renderer;
-  final EscTplParser _parser;
+  final TemplateResolver _resolver;
+
+  /// When set, non-streaming prints are rendered and encoded off this
+  /// isolate. The pool is not closed by [disconnect].
+  final EscPosWorkerPool? _workerPool;
 
   final Random _random = Random();
 
-  Future<void> _queueTail = Future<void>.value();
+  /// Connection changes and everything that writes to the printer.
+  ///
+  /// Connection changes are barriers, so prints never move across them.
+  final PriorityLane _sessionLane = PriorityLane();
+
+  /// Status reads on a connected session; they do not wait behind writes.
+  final SerialLane _statusLane = SerialLane();
+
+  /// Discovery touches no session state and never blocks printing.
+  final SerialLane _discoveryLane = SerialLane();
+
+  final StreamController<PrinterStatus> _statusUpdates =
+      StreamController<PrinterStatus>.broadcast();
+  PrinterStatus? _lastStatus;
+
+  final StreamController<PrintCopyProgress> _copyProgress =
+      StreamController<PrintCopyProgress>.broadcast();
+
+  /// Platform events are only subscribed to while someone listens.
+  late final StreamController<PrinterConnectionEvent> _connectionEvents =
+      StreamController<PrinterConnectionEvent>.broadcast(
+        onListen: _listenToTransport,
+        onCancel: _stopListeningToTransport,
+      );
+  StreamSubscription<PrinterConnectionEvent>? _connectionSubscription;
 
   PrinterEndpoint? _endpoint;
   PrinterTransport? _transport;
@@ -47,20 +88,41 @@ final class EscPosClient {
   PrinterCapabilities? get transportCapabilities => _transport?.capabilities;
   String? get transportSessionId => _transport?.sessionId;
 
+  /// Every status the client reads, including deferred post-print reads.
+  Stream<PrinterStatus> get statusUpdates => _statusUpdates.stream;
+
+  /// Link state of the current session: [PrinterConnectionState.connected]
+  /// after every connect, then whatever the transport reports. Only
+  /// [ConnectionStateTransport]s report changes; the client does not
+  /// reconnect on [PrinterConnectionState.lost] until the next write.
+  Stream<PrinterConnectionEvent> get connectionEvents =>
+      _connectionEvents.stream;
+
+  /// One event per copy written, for jobs printed with
+  /// [PrintOptions.copies].
+  Stream<PrintCopyProgress> get copyProgress => _copyProgress.stream;
+
+  /// Last status read from the printer, if any.
+  PrinterStatus? get lastStatus => _lastStatus;
+
+  /// Waiting depth and queue wait times per [PrintPriority] of session work.
+  Map<PrintPriority, QueueClassStats> get queueStats => _sessionLane.stats;
+
   Future<void> connect(PrinterEndpoint endpoint, {ReconnectPolicy? policy}) {
-    return _enqueue<void>(() async {
+    return _sessionLane.run<void>(() async {
       await _disconnectInternal();
       _endpoint = endpoint;
       _sessionReconnectPolicy = policy ?? _defaultReconnectPolicy;
       _transport = await _transportFactory.create(endpoint);
       await _transport!.connect();
-    });
+      _watchConnection(_transport!);
+    }, barrier: true);
   }
 
   Future<void> disconnect() {
-    return _enqueue<void>(() async {
+    return _sessionLane.run<void>(() async {
       await _disconnectInternal();
-    });
+    }, barrier: true);
   }
 
   Future<PrintResult> print({
@@ -69,14 +131,14 @@ final class EscPosClient {
     TemplateRenderOptions renderOptions = const TemplateRenderOptions(),
     PrintOptions printOptions = const PrintOptions(),
   }) {
-    return _enqueue<PrintResult>(() async {
+    return _sessionLane.run<PrintResult>(() async {
       return _printInternal(
         template: template,
         variables: variables,
         renderOptions: renderOptions,
         printOptions: printOptions,
       );
-    });
+    }, priority: printOptions.priority);
   }
 
   Future<PrintResult> printFromString({
@@ -93,6 +155,24 @@ final class EscPosClient {
     );
   }
 
+  /// Prints [jobs] back to back as one queue entry.
+  ///
+  /// Every job is encoded first (in parallel when a worker pool is set),
+  /// then all of them go out in one transport call and status is read once
+  /// at the end. [PrintPriority.bulk] batches are instead sent in groups of
+  /// about [PrintOptions.chunkSizeBytes], and more urgent work runs between
+  /// groups. Template errors are thrown before anything is sent. A
+  /// transport failure that outlasts the reconnect policy is reported in
+  /// [BatchPrintResult.error] and in the per-job states instead.
+  Future<BatchPrintResult> printBatch(
+    List<PrintJob> jobs, {
+    PrintOptions printOptions = const PrintOptions(),
+  }) {
+    return _sessionLane.run<BatchPrintResult>(() async {
+      return _printBatchInternal(jobs, printOptions);
+    }, priority: printOptions.priority);
+  }
+
   Future<PrintResult> printOnce({
     required PrinterEndpoint endpoint,
     required ReceiptTemplate template,
@@ -101,12 +181,13 @@ final class EscPosClient {
     PrintOptions printOptions = const PrintOptions(),
     ReconnectPolicy? reconnectPolicy,
   }) {
-    return _enqueue<PrintResult>(() async {
+    return _sessionLane.run<PrintResult>(() async {
       await _disconnectInternal();
       _endpoint = endpoint;
       _sessionReconnectPolicy = reconnectPolicy ?? _defaultReconnectPolicy;
       _transport = await _transportFactory.create(endpoint);
       await _transport!.connect();
+      _watchConnection(_transport!);
 
       try {
         return await _printInternal(
@@ -118,35 +199,54 @@ final class EscPosClient {
       } finally {
         await _disconnectInternal();
       }
-    });
+    }, barrier: true);
   }
 
   Future<void> feed(int lines) {
-    return _enqueue<void>(() async {
+    return _sessionLane.run<void>(() async {
       await _sendOps(<PrintOp>[FeedOp(lines)]);
     });
   }
 
   Future<void> cut([CutMode mode = CutMode.partial]) {
-    return _enqueue<void>(() async {
+    return _sessionLane.run<void>(() async {
       await _sendOps(<PrintOp>[CutOp(mode)]);
     });
   }
 
+  /// Kicks the cash drawer.
+  ///
+  /// At [PrintPriority.realtime] (the default) the kick runs before queued
+  /// prints and may go out between chunks of a streaming or bulk print.
   Future<void> openCashDrawer({
     DrawerPin pin = DrawerPin.pin2,
     int onMs = 120,
     int offMs = 240,
+    PrintPriority priority = PrintPriority.realtime,
   }) {
-    return _enqueue<void>(() async {
-      await _sendOps(<PrintOp>[
-        DrawerKickOp(pin: pin, onMs: onMs, offMs: offMs),
-      ]);
-    });
+    return _sessionLane.run<void>(
+      () async {
+        await _sendOps(<PrintOp>[
+          DrawerKickOp(pin: pin, onMs: onMs, offMs: offMs),
+        ]);
+      },
+      priority: priority,
+      safeMidJob: true,
+    );
   }
 
+  /// Reads realtime status.
+  ///
+  /// On a connected session this runs alongside queued prints. When the
+  /// session has dropped it waits its turn on the session lane, since
+  /// reconnecting changes the session.
   Future<PrinterStatus> getStatus() {
-    return _enqueue<PrinterStatus>(() async {
+    final transport = _transport;
+    if (transport != null && transport.isConnected) {
+      return _statusLane.run<PrinterStatus>(() => _readStatus(transport));
+    }
+
+    return _sessionLane.run<PrinterStatus>(() async {
       final transport = _transport;
       if (transport == null) {
         throw ConnectionException(
@@ -158,22 +258,83 @@ final class EscPosClient {
         await _reconnect();
       }
 
-      try {
-        return await _transport!.getStatus();
-      } catch (_) {
-        return const PrinterStatus.unknown();
+      return _readStatus(_transport!);
+    });
+  }
+
+  Future<PrinterStatus> _readStatus(PrinterTransport transport) async {
+    try {
+      final status = await transport.getStatus();
+      _lastStatus = status;
+      _statusUpdates.add(status);
+      return status;
+    } catch (_) {
+      return const PrinterStatus.unknown();
+    }
+  }
+
+  /// Reads bytes the printer sent back, e.g. replies to `GS I` or
+  /// `GS r`. Runs beside in-progress writes, like [getStatus].
+  Future<Uint8List> readBytes({
+    int maxBytes = 256,
+    Duration timeout = const Duration(seconds: 1),
+  }) {
+    return _statusLane.run<Uint8List>(() async {
+      final transport = _transport;
+      if (transport == null || !transport.isConnected) {
+        throw ConnectionException(
+          'No active session. Call connect() before readBytes().',
+        );
       }
+      if (transport is! ReadableTransport) {
+        throw TransportException('The transport cannot read from the printer.');
+      }
+      return transport.read(maxBytes: maxBytes, timeout: timeout);
+    });
+  }
+
+  /// Asks the platform for the session's current capabilities and updates
+  /// [transportCapabilities]. Transports without native sessions keep
+  /// their fixed capabilities.
+  Future<PrinterCapabilities> refreshCapabilities() {
+    return _statusLane.run<PrinterCapabilities>(() async {
+      final transport = _transport;
+      if (transport == null || !transport.isConnected) {
+        throw ConnectionException(
+          'No active session. Call connect() before refreshCapabilities().',
+        );
+      }
+      if (transport is CapabilityProbingTransport) {
+        return transport.refreshCapabilities();
+      }
+      return transport.capabilities;
     });
   }
 
   Future<List<DiscoveredPrinter>> searchPrinters({
     PrinterDiscoveryOptions options = const PrinterDiscoveryOptions(),
   }) {
-    return _enqueue<List<DiscoveredPrinter>>(() async {
+    return _discoveryLane.run<List<DiscoveredPrinter>>(() async {
       return _discoveryService.search(options);
     });
   }
 
+  /// Printers as they are found, for setup screens that list results while
+  /// the search runs. Transports are searched concurrently and the stream
+  /// closes at [PrinterDiscoveryOptions.timeout] at the latest. Unlike
+  /// [searchPrinters] it does not queue behind other searches.
+  Stream<DiscoveredPrinter> discoverPrinters({
+    PrinterDiscoveryOptions options = const PrinterDiscoveryOptions(),
+  }) {
+    return _discoveryService.discover(options);
+  }
+
+  /// Image format preferred by the connected printer's profile.
+  BitImageFormat get _profileImageFormat {
+    return _transport?.capabilities.profile?.imageFormat ??
+        BitImageFormat.raster;
+  }
+
   Future<PrintResult> _printInternal({
     required ReceiptTemplate template,
     required Map<String, Object?> variables,
@@ -181,96 +342,424 @@ final class EscPosClient {
     required PrintOptions printOptions,
   }) async {
     final startedAt = DateTime.now();
-    final resolvedOps = _resolveTemplate(
-      template: template,
-      variables: variables,
-      renderOptions: renderOptions,
-    );
+    final streamed =
+        printOptions.copies == 1 &&
+        (printOptions.streaming ||
+            printOptions.priority == PrintPriority.bulk);
+    final workerPool = _workerPool;
+    if (workerPool != null && !streamed) {
+      final encoded = await workerPool.encode(
+        template: template,
+        variables: variables,
+        renderOptions: renderOptions,
+        printOptions: printOptions,
+        imageFormat: _profileImageFormat,
+      );
+      return _sendEncoded(encoded, printOptions, startedAt);
+    }
 
+    final resolvedOps = _resolver.resolve(template, variables, renderOptions);
     final encoder = EscPosEncoder(
       paperWidthChars: printOptions.paperWidthChars,
       codeTable: printOptions.codeTable,
+      imageFormat: printOptions.imageFormat ?? _profileImageFormat,
     );
-    final bytes = encoder.encode(
+    if (streamed) {
+      return _printStreaming(encoder, resolvedOps, printOptions, startedAt);
+    }
+
+    final encoded = encoder.encodeJob(
       resolvedOps,
       initializePrinter: printOptions.initializePrinter,
+      optimize: printOptions.optimize,
     );
+    return _sendEncoded(encoded, printOptions, startedAt);
+  }
 
-    await _sendBytes(bytes);
+  Future<PrintResult> _sendEncoded(
+    EncodeResult encoded,
+    PrintOptions printOptions,
+    DateTime startedAt,
+  ) async {
+    final bytesSent = await _sendCopies(encoded.bytes, printOptions);
 
-    final status = await _readStatusBestEffort();
+    final (status, deferredStatus) = await _postPrintStatus(
+      printOptions.statusStrategy,
+    );
     return PrintResult(
-      bytesSent: bytes.length,
+      bytesSent: bytesSent,
       duration: DateTime.now().difference(startedAt),
       status: status,
+      styleBytesSaved: encoded.styleBytesSaved,
+      opBytesSaved: encoded.opBytesSaved,
+      deferredStatus: deferredStatus,
     );
   }
 
-  List<PrintOp> _resolveTemplate({
-    required ReceiptTemplate template,
-    required Map<String, Object?> variables,
-    required TemplateRenderOptions renderOptions,
-  }) {
-    return switch (template) {
-      DslReceiptTemplate(:final ops) => _resolveDslOps(
-        ops,
-        variables,
-        renderOptions,
-      ),
-      StringReceiptTemplate(:final template) => _resolveStringTemplate(
-        template,
-        variables,
-        renderOptions,
-      ),
-    };
-  }
-
-  List<PrintOp> _resolveDslOps(
-    List<PrintOp> rawOps,
-    Map<String, Object?> variables,
-    TemplateRenderOptions renderOptions,
-  ) {
-    final result = <PrintOp>[];
-
-    for (final op in rawOps) {
-      switch (op) {
-        case TextTemplateOp(:final template, :final vars, :final style):
-          final mergedVars = <String, Object?>{...variables, ...vars};
-          final rendered = _renderer.render(
-            template,
-            mergedVars,
-            strictMissingVariables: renderOptions.strictMissingVariables,
-          );
-          result.add(TextOp(rendered, style: style));
-
-        case TemplateBlockOp(:final template, :final vars):
-          final mergedVars = <String, Object?>{...variables, ...vars};
-          final rendered = _renderer.render(
-            template,
-            mergedVars,
-            strictMissingVariables: renderOptions.strictMissingVariables,
-          );
-          result.addAll(_parser.parse(rendered));
+  /// Writes [job] [PrintOptions.copies] times and returns the bytes sent.
+  ///
+  /// A [RetainedJobTransport] gets the bytes once and replays them. When it
+  /// cannot retain the job, or a replay fails, the copy is sent in full
+  /// through [_sendBytes], which reconnects as needed; the job is retained
+  /// again on the new session for the copies after it. A replay cut off
+  /// after the platform reconnected by itself is reported, not resent.
+  Future<int> _sendCopies(Uint8List job, PrintOptions printOptions) async {
+    final copies = printOptions.copies;
+    if (copies == 1) {
+      await _sendBytes(job);
+      return job.length;
+    }
+
+    final cut = printOptions.cutBetweenCopies;
+    final separator = cut == null
+        ? null
+        : Uint8List.fromList(<int>[0x1D, 0x56, cut == CutMode.full ? 0 : 1]);
 
-        default:
-          result.add(op);
+    RetainedJobTransport? retainedOn;
+    String? retainedJobId;
+    var bytesSent = 0;
+    try {
+      for (var copy = 1; copy <= copies; copy++) {
+        final trailer = copy < copies ? separator : null;
+        final transport = _transport;
+        var replayed = false;
+        if (transport is RetainedJobTransport && transport.isConnected) {
+          try {
+            if (retainedOn != transport) {
+              retainedOn = transport;
+              retainedJobId = await transport.retainJob(
+                job,
+                separator: separator,
+              );
+            }
+            if (retainedJobId != null) {
+              await transport.writeRetainedJob(
+                retainedJobId,
+                withSeparator: trailer != null,
+              );
+              replayed = true;
+            }
+          } on WriteInterruptedException catch (error) {
+            throw ConnectionException('Copy $copy was cut off.', error);
+          } on EscPosException {
+            retainedOn = null;
+            retainedJobId = null;
+          }
+        }
+        if (!replayed) {
+          final bytes = BytesBuilder(copy: false)..add(job);
+          if (trailer != null) {
+            bytes.add(trailer);
+          }
+          await _sendBytes(bytes.takeBytes());
+        }
+
+        bytesSent += job.length + (trailer?.length ?? 0);
+        _copyProgress.add(
+          PrintCopyProgress(copy: copy, copies: copies, bytesSent: bytesSent),
+        );
+        if (copy < copies &&
+            _sessionLane.hasWaiting(PrintPriority.realtime, midJob: true)) {
+          await _sessionLane.yieldTo(PrintPriority.realtime, midJob: true);
+        }
+      }
+    } finally {
+      final transport = retainedOn;
+      final jobId = retainedJobId;
+      if (transport != null &&
+          jobId != null &&
+          transport == _transport &&
+          transport.isConnected) {
+        await transport.releaseJob(jobId).catchError((Object _) {});
       }
     }
+    return bytesSent;
+  }
+
+  /// Sends the job chunk by chunk while encoding it.
+  ///
+  /// On a [JobStreamTransport] the chunks go through one platform job
+  /// stream, whose bounded buffer holds the encoder back while the printer
+  /// catches up; the stream is committed before urgent work runs between
+  /// chunks and reopened after it. Other transports get one write per
+  /// chunk.
+  Future<PrintResult> _printStreaming(
+    EscPosEncoder encoder,
+    List<PrintOp> ops,
+    PrintOptions printOptions,
+    DateTime startedAt,
+  ) async {
+    final optimized = printOptions.optimize
+        ? PrintOpOptimizer(encoder: encoder).optimize(
+            ops,
+            initializePrinter: printOptions.initializePrinter,
+          )
+        : OptimizedOps(ops);
+    final job = encoder.startJob(
+      initializePrinter: printOptions.initializePrinter,
+    );
+    var stream = await _beginJobStream();
+    final pipeline = WritePipeline((chunk) {
+      final current = stream;
+      return current == null
+          ? _sendBytes(chunk)
+          : current.$1.appendChunk(current.$2, chunk);
+    }, maxInFlight: printOptions.maxInFlightChunks);
 
-    return List<PrintOp>.unmodifiable(result);
+    try {
+      for (final op in optimized.ops) {
+        job.add(op);
+        if (job.pendingBytes >= printOptions.chunkSizeBytes) {
+          await pipeline.add(job.takeBytes());
+          if (_sessionLane.hasWaiting(PrintPriority.realtime, midJob: true)) {
+            // Chunks end between ops, so a non-printing command can go out
+            // here once the chunks already queued have been written.
+            await pipeline.flush();
+            final current = stream;
+            stream = null;
+            if (current != null) {
+              await current.$1.commitJob(current.$2);
+            }
+            await _sessionLane.yieldTo(PrintPriority.realtime, midJob: true);
+            stream = await _beginJobStream();
+          }
+        }
+      }
+      await pipeline.add(job.finish());
+      await pipeline.close();
+      final current = stream;
+      stream = null;
+      if (current != null) {
+        await current.$1.commitJob(current.$2);
+      }
+    } catch (_) {
+      // An appendChunk still waiting for room is answered by the abort; its
+      // job_aborted error is expected and must not go unhandled.
+      pipeline.discard();
+      final current = stream;
+      if (current != null) {
+        await current.$1.abortJob(current.$2).catchError((Object _) {});
+      }
+      rethrow;
+    }
+
+    final (status, deferredStatus) = await _postPrintStatus(
+      printOptions.statusStrategy,
+    );
+    return PrintResult(
+      bytesSent: pipeline.bytesWritten,
+      duration: DateTime.now().difference(startedAt),
+      status: status,
+      styleBytesSaved: job.styleBytesSaved,
+      opBytesSaved: optimized.bytesSaved,
+      deferredStatus: deferredStatus,
+    );
   }
 
-  List<PrintOp> _resolveStringTemplate(
-    String source,
-    Map<String, Object?> variables,
-    TemplateRenderOptions renderOptions,
-  ) {
-    final rendered = _renderer.render(
-      source,
-      variables,
-      strictMissingVariables: renderOptions.strictMissingVariables,
+  /// Opens a job stream on the current transport, or returns null when
+  /// chunks should go through [_sendBytes] instead.
+  Future<(JobStreamTransport, String)?> _beginJobStream() async {
+    final transport = _transport;
+    if (transport is! JobStreamTransport || !transport.isConnected) {
+      return null;
+    }
+    try {
+      final jobId = await transport.beginJob();
+      return jobId == null ? null : (transport, jobId);
+    } on EscPosException {
+      return null;
+    }
+  }
+
+  Future<BatchPrintResult> _printBatchInternal(
+    List<PrintJob> jobs,
+    PrintOptions printOptions,
+  ) async {
+    if (_transport == null) {
+      throw ConnectionException(
+        'No active session. Call connect() before printBatch().',
+      );
+    }
+
+    final startedAt = DateTime.now();
+    final encoded = await _encodeBatch(jobs, printOptions);
+
+    final states = List<BatchJobState>.filled(
+      encoded.length,
+      BatchJobState.notSent,
+    );
+    Object? error;
+    try {
+      if (printOptions.priority == PrintPriority.bulk) {
+        await _sendBulkBatch(encoded, states, printOptions.chunkSizeBytes);
+      } else {
+        await _sendBatch(encoded, states, 0, encoded.length);
+      }
+    } on ConnectionException catch (failure) {
+      error = failure;
+    }
+
+    final results = <BatchJobResult>[];
+    var offset = 0;
+    var bytesSent = 0;
+    for (var i = 0; i < encoded.length; i++) {
+      final length = encoded[i].length;
+      results.add(
+        BatchJobResult(offset: offset, length: length, state: states[i]),
+      );
+      if (states[i] == BatchJobState.written) {
+        bytesSent += length;
+      }
+      offset += length;
+    }
+
+    final (status, deferredStatus) = await _postPrintStatus(
+      printOptions.statusStrategy,
+    );
+    return BatchPrintResult(
+      jobs: List<BatchJobResult>.unmodifiable(results),
+      bytesSent: bytesSent,
+      duration: DateTime.now().difference(startedAt),
+      status: status,
+      deferredStatus: deferredStatus,
+      error: error,
+    );
+  }
+
+  Future<List<Uint8List>> _encodeBatch(
+    List<PrintJob> jobs,
+    PrintOptions printOptions,
+  ) async {
+    final workerPool = _workerPool;
+    if (workerPool != null) {
+      final results = await Future.wait(
+        jobs.map((job) {
+          return workerPool.encode(
+            template: job.template,
+            variables: job.variables,
+            renderOptions: job.renderOptions,
+            printOptions: printOptions,
+            imageFormat: _profileImageFormat,
+          );
+        }),
+      );
+      return results.map((result) => result.bytes).toList();
+    }
+
+    final encoder = EscPosEncoder(
+      paperWidthChars: printOptions.paperWidthChars,
+      codeTable: printOptions.codeTable,
+      imageFormat: printOptions.imageFormat ?? _profileImageFormat,
     );
-    return _parser.parse(rendered);
+    return <Uint8List>[
+      for (final job in jobs)
+        encoder
+            .encodeJob(
+              _resolver.resolve(job.template, job.variables, job.renderOptions),
+              initializePrinter: printOptions.initializePrinter,
+              optimize: printOptions.optimize,
+            )
+            .bytes,
+    ];
+  }
+
+  /// Sends a bulk batch in groups of about [groupBytes], letting more
+  /// urgent session work run between groups (always at a job boundary).
+  Future<void> _sendBulkBatch(
+    List<Uint8List> jobs,
+    List<BatchJobState> states,
+    int groupBytes,
+  ) async {
+    var start = 0;
+    while (start < jobs.length) {
+      var end = start;
+      var bytes = 0;
+      while (end < jobs.length && (end == start || bytes < groupBytes)) {
+        bytes += jobs[end].length;
+        end++;
+      }
+
+      await _sendBatch(jobs, states, start, end);
+      start = end;
+      if (start < jobs.length) {
+        await _sessionLane.yieldTo(PrintPriority.interactive);
+      }
+    }
+  }
+
+  /// Sends jobs [start] to [end] in order, updating [states] as jobs
+  /// complete.
+  ///
+  /// After a failure the session is reconnected and sending resumes at the
+  /// first job that was not fully written, so that job prints again.
+  Future<void> _sendBatch(
+    List<Uint8List> jobs,
+    List<BatchJobState> states,
+    int start,
+    int end,
+  ) async {
+    final policy = _sessionReconnectPolicy ?? _defaultReconnectPolicy;
+    var next = start;
+
+    for (var attempt = 0; ; attempt++) {
+      try {
+        final transport = _transport;
+        if (transport == null) {
+          throw ConnectionException(
+            'No active session. Call connect() before printing.',
+          );
+        }
+
+        if (!transport.isConnected) {
+          await _reconnect();
+        }
+
+        final pending = jobs.sublist(next, end);
+        final current = _transport!;
+        if (current is BatchWriteTransport) {
+          final results = await current.writeBatch(pending);
+          for (final result in results) {
+            states[next] = result.state;
+            if (result.state != BatchJobState.written) {
+              throw current.isConnected
+                  ? WriteInterruptedException(
+                      'Batch stopped at job $next after the transport '
+                      'reconnected.',
+                    )
+                  : TransportException('Batch stopped at job $next.');
+            }
+            next++;
+          }
+        } else {
+          final builder = BytesBuilder(copy: false);
+          pending.forEach(builder.add);
+          await current.write(builder.takeBytes());
+          states.fillRange(next, end, BatchJobState.written);
+          next = end;
+        }
+        return;
+      } catch (error) {
+        if (next < end) {
+          states[next] = BatchJobState.failed;
+        }
+        // The transport already reconnected and retried; another round here
+        // would multiply its attempts.
+        if (error is WriteInterruptedException) {
+          throw ConnectionException('Batch was cut off.', error);
+        }
+        if (attempt >= policy.maxAttempts) {
+          throw ConnectionException(
+            'Failed to send batch to the printer after retries.',
+            error,
+          );
+        }
+
+        await _reconnect();
+        await Future<void>.delayed(
+          policy.delayForAttempt(attempt + 1, random: _random),
+        );
+      }
+    }
   }
 
   Future<void> _sendOps(List<PrintOp> ops) async {
@@ -299,6 +788,11 @@ final class EscPosClient {
         await _transport!.write(bytes);
         return;
       } catch (error) {
+        // The session survived but the data was cut off; sending it again
+        // could print part of the job twice.
+        if (error is WriteInterruptedException) {
+          throw ConnectionException('Write to the printer was cut off.', error);
+        }
         if (attempt >= maxAttempts) {
           throw ConnectionException(
             'Failed to send data to the printer after retries.',
@@ -325,6 +819,32 @@ final class EscPosClient {
     await _transport?.disconnect();
     _transport = await _transportFactory.create(endpoint);
     await _transport!.connect();
+    _watchConnection(_transport!);
+  }
+
+  /// Status for a finished print, and the pending fresh read when
+  /// [strategy] defers it.
+  Future<(PrinterStatus, Future<PrinterStatus>?)> _postPrintStatus(
+    StatusStrategy strategy,
+  ) async {
+    final cached = _lastStatus ?? const PrinterStatus.unknown();
+    switch (strategy) {
+      case StatusStrategy.wait:
+        return (await _readStatusBestEffort(), null);
+      case StatusStrategy.skip:
+        return (const PrinterStatus.unknown(), null);
+      case StatusStrategy.cached:
+        return (cached, null);
+      case StatusStrategy.deferred:
+        final transport = _transport;
+        if (transport == null) {
+          return (cached, Future<PrinterStatus>.value(cached));
+        }
+        return (
+          cached,
+          _statusLane.run<PrinterStatus>(() => _readStatus(transport)),
+        );
+    }
   }
 
   Future<PrinterStatus> _readStatusBestEffort() async {
@@ -332,37 +852,47 @@ final class EscPosClient {
     if (transport == null) {
       return const PrinterStatus.unknown();
     }
+    return _readStatus(transport);
+  }
 
-    try {
-      return await transport.getStatus();
-    } catch (_) {
-      return const PrinterStatus.unknown();
+  void _watchConnection(PrinterTransport transport) {
+    _stopListeningToTransport();
+    if (!_connectionEvents.hasListener) {
+      return;
     }
+    _connectionEvents.add(
+      const PrinterConnectionEvent(PrinterConnectionState.connected),
+    );
+    _listenToTransport();
+  }
+
+  void _listenToTransport() {
+    final transport = _transport;
+    if (_connectionSubscription != null ||
+        transport is! ConnectionStateTransport ||
+        !transport.isConnected) {
+      return;
+    }
+    _connectionSubscription = transport.connectionEvents.listen(
+      _connectionEvents.add,
+    );
+  }
+
+  void _stopListeningToTransport() {
+    unawaited(_connectionSubscription?.cancel());
+    _connectionSubscription = null;
   }
 
   Future<void> _disconnectInternal() async {
     final transport = _transport;
     _transport = null;
+    _stopListeningToTransport();
     _endpoint = null;
     _sessionReconnectPolicy = null;
+    _lastStatus = null;
 
     if (transport != null) {
       await transport.disconnect();
     }
   }
-
-  Future<T> _enqueue<T>(Future<T> Function() task) {
-    final completer = Completer<T>();
-
-    _queueTail = _queueTail.catchError((_) {}).then((_) async {
-      try {
-        final result = await task();
-        completer.complete(result);
-      } catch (error, stackTrace) {
-        completer.completeError(error, stackTrace);
-      }
-    });
-
-    return completer.future;
-  }
 }
@@ -0,0 +1,154 @@
+import 'dart:async';
+
+import '../model/options.dart';
+import '../model/queue_stats.dart';
+
+/// Runs tasks one at a time, most urgent [PrintPriority] first.
+///
+/// Tasks of the same priority keep submission order. A barrier task (a
+/// connection change) is never overtaken and never overtakes: only tasks
+/// queued before the first waiting barrier compete for the next slot.
+///
+/// A running task can let more urgent work through at a safe point with
+/// [yieldTo]; the lane stays exclusive because that work runs inline.
+final class PriorityLane {
+  final List<_LaneTask<Object?>> _pending = <_LaneTask<Object?>>[];
+  final Map<PrintPriority, _ClassCounters> _counters =
+      <PrintPriority, _ClassCounters>{
+        for (final priority in PrintPriority.values)
+          priority: _ClassCounters(),
+      };
+  bool _draining = false;
+
+  Future<T> run<T>(
+    Future<T> Function() task, {
+    PrintPriority priority = PrintPriority.interactive,
+    bool barrier = false,
+    bool safeMidJob = false,
+  }) {
+    final entry = _LaneTask<T>(task, priority, barrier, safeMidJob);
+    _pending.add(entry);
+    if (!_draining) {
+      _draining = true;
+      scheduleMicrotask(_drain);
+    }
+    return entry.completer.future;
+  }
+
+  /// Whether a task that [yieldTo] would run is waiting.
+  bool hasWaiting(PrintPriority priority, {bool midJob = false}) {
+    return _indexOfNext(priority, midJob) >= 0;
+  }
+
+  /// Runs waiting tasks of [priority] or more urgent before returning.
+  ///
+  /// With [midJob], only tasks submitted as safe to run inside another
+  /// job (they print nothing, e.g. a drawer kick) are taken.
+  Future<void> yieldTo(PrintPriority priority, {bool midJob = false}) async {
+    for (;;) {
+      final index = _indexOfNext(priority, midJob);
+      if (index < 0) {
+        return;
+      }
+      await _execute(_pending.removeAt(index));
+    }
+  }
+
+  /// Waiting depth and wait times per priority class.
+  Map<PrintPriority, QueueClassStats> get stats {
+    return <PrintPriority, QueueClassStats>{
+      for (final priority in PrintPriority.values)
+        priority: _counters[priority]!.snapshot(
+          depth: _pending.where((task) => task.priority == priority).length,
+        ),
+    };
+  }
+
+  Future<void> _drain() async {
+    try {
+      for (;;) {
+        final index = _indexOfNext(null, false);
+        if (index < 0) {
+          return;
+        }
+        await _execute(_pending.removeAt(index));
+      }
+    } finally {
+      _draining = false;
+    }
+  }
+
+  /// Index of the task to run next, or -1.
+  ///
+  /// [limit] restricts the choice to that priority or more urgent and
+  /// excludes barriers; `null` means the lane's own scheduling.
+  int _indexOfNext(PrintPriority? limit, bool midJob) {
+    var best = -1;
+    for (var i = 0; i < _pending.length; i++) {
+      final task = _pending[i];
+      if (task.barrier) {
+        if (i == 0 && limit == null) {
+          best = 0;
+        }
+        break;
+      }
+      if (limit != null && task.priority.index > limit.index) {
+        continue;
+      }
+      if (midJob && !task.safeMidJob) {
+        continue;
+      }
+      if (best < 0 || task.priority.index < _pending[best].priority.index) {
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  Future<void> _execute(_LaneTask<Object?> task) {
+    _counters[task.priority]!.record(task.waited.elapsed);
+    return task.execute();
+  }
+}
+
+final class _LaneTask<T> {
+  _LaneTask(this._body, this.priority, this.barrier, this.safeMidJob);
+
+  final Future<T> Function() _body;
+  final PrintPriority priority;
+  final bool barrier;
+  final bool safeMidJob;
+  final Completer<T> completer = Completer<T>();
+  final Stopwatch waited = Stopwatch()..start();
+
+  Future<void> execute() async {
+    try {
+      completer.complete(await _body());
+    } catch (error, stackTrace) {
+      completer.completeError(error, stackTrace);
+    }
+  }
+}
+
+final class _ClassCounters {
+  int started = 0;
+  Duration totalWait = Duration.zero;
+  Duration maxWait = Duration.zero;
+
+  void record(Duration wait) {
+    started++;
+    totalWait += wait;
+    if (wait > maxWait) {
+      maxWait = wait;
+    }
+  }
+
+  QueueClassStats snapshot({required int depth}) {
+    return QueueClassStats(
+      depth: depth,
+      started: started,
+      totalWait: totalWait,
+      maxWait: maxWait,
+    );
+  }
+}
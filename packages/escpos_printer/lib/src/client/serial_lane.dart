@@ -0,0 +1,23 @@
+import 'dart:async';
+
+/// Runs tasks one at a time, in submission order.
+///
+/// A failed task does not stop the lane; its error goes only to its caller.
+final class SerialLane {
+  Future<void> _tail = Future<void>.value();
+
+  Future<T> run<T>(Future<T> Function() task) {
+    final completer = Completer<T>();
+
+    _tail = _tail.then((_) async {
+      try {
+        final result = await task();
+        completer.complete(result);
+      } catch (error, stackTrace) {
+        completer.completeError(error, stackTrace);
+      }
+    });
+
+    return completer.future;
+  }
+}
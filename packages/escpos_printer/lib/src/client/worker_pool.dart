@@ -0,0 +1,261 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:math';
+import 'dart:typed_data';
+
+import '../encoding/escpos_encoder.dart';
+import '../model/exceptions.dart';
+import '../model/options.dart';
+import '../template/compiled_template.dart';
+import '../template/receipt_template.dart';
+import '../template/template_resolver.dart';
+
+/// Background isolates that render, parse and encode print jobs.
+///
+/// Pass one pool to every [EscPosClient] that should use it; jobs from
+/// different clients then encode in parallel, one per worker. Workers are
+/// spawned on demand up to [size] and each keeps its own template cache.
+/// Encoded bytes come back as [TransferableTypedData], so they are not
+/// copied on the way to the calling isolate.
+final class EscPosWorkerPool {
+  EscPosWorkerPool({int? size})
+    : size = size ?? max(1, Platform.numberOfProcessors - 1),
+      assert(size == null || size > 0);
+
+  final int size;
+
+  final List<_Worker> _workers = <_Worker>[];
+  bool _closed = false;
+
+  /// Resolves [template] and encodes it on a worker isolate.
+  ///
+  /// Images use `printOptions.imageFormat`, else [imageFormat] (the
+  /// printer profile's choice), else raster.
+  Future<EncodeResult> encode({
+    required ReceiptTemplate template,
+    Map<String, Object?> variables = const <String, Object?>{},
+    TemplateRenderOptions renderOptions = const TemplateRenderOptions(),
+    PrintOptions printOptions = const PrintOptions(),
+    BitImageFormat? imageFormat,
+  }) {
+    if (_closed) {
+      throw StateError('EscPosWorkerPool is closed.');
+    }
+    return _pickWorker().run(
+      _EncodeRequest(
+        template,
+        variables,
+        renderOptions,
+        printOptions,
+        printOptions.imageFormat ?? imageFormat ?? BitImageFormat.raster,
+      ),
+    );
+  }
+
+  /// Waits for queued jobs and shuts the workers down.
+  Future<void> close() async {
+    if (_closed) {
+      return;
+    }
+    _closed = true;
+    await Future.wait(_workers.map((worker) => worker.close()));
+    _workers.clear();
+  }
+
+  _Worker _pickWorker() {
+    _workers.removeWhere((worker) => worker.failed);
+    _Worker? idlest;
+    for (final worker in _workers) {
+      if (idlest == null || worker.load < idlest.load) {
+        idlest = worker;
+      }
+    }
+    if (idlest != null && (idlest.load == 0 || _workers.length >= size)) {
+      return idlest;
+    }
+
+    final worker = _Worker.spawn();
+    _workers.add(worker);
+    return worker;
+  }
+}
+
+final class _EncodeRequest {
+  const _EncodeRequest(
+    this.template,
+    this.variables,
+    this.renderOptions,
+    this.printOptions,
+    this.imageFormat,
+  );
+
+  final ReceiptTemplate template;
+  final Map<String, Object?> variables;
+  final TemplateRenderOptions renderOptions;
+  final PrintOptions printOptions;
+  final BitImageFormat imageFormat;
+
+  EncodeResult run(TemplateResolver resolver) {
+    final ops = resolver.resolve(template, variables, renderOptions);
+    final encoder = EscPosEncoder(
+      paperWidthChars: printOptions.paperWidthChars,
+      codeTable: printOptions.codeTable,
+      imageFormat: imageFormat,
+    );
+    return encoder.encodeJob(
+      ops,
+      initializePrinter: printOptions.initializePrinter,
+      optimize: printOptions.optimize,
+    );
+  }
+}
+
+final class _Worker {
+  _Worker._() {
+    _commands.future.ignore();
+    _replies.listen(_onReply);
+  }
+
+  factory _Worker.spawn() {
+    final worker = _Worker._();
+    Isolate.spawn(
+      _workerMain,
+      worker._replies.sendPort,
+      onExit: worker._replies.sendPort,
+      debugName: 'escpos_printer_worker',
+    ).then<void>(
+      (_) {},
+      onError: (Object error) {
+        worker._fail(EscPosException('Failed to start worker isolate.', error));
+      },
+    );
+    return worker;
+  }
+
+  final ReceivePort _replies = ReceivePort();
+  final Completer<SendPort> _commands = Completer<SendPort>();
+  final Map<int, Completer<EncodeResult>> _pending =
+      <int, Completer<EncodeResult>>{};
+  int _nextId = 0;
+  bool _failed = false;
+
+  /// Whether the isolate could not start or has exited.
+  bool get failed => _failed;
+
+  /// Jobs sent to this worker and not answered yet.
+  int get load => _pending.length;
+
+  Future<EncodeResult> run(_EncodeRequest request) {
+    final id = _nextId++;
+    final completer = Completer<EncodeResult>();
+    _pending[id] = completer;
+    _commands.future.then(
+      (commands) {
+        try {
+          commands.send((id, request));
+        } on ArgumentError catch (error) {
+          _pending
+              .remove(id)
+              ?.completeError(
+                EscPosException(
+                  'Print job cannot be sent to a worker isolate.',
+                  error,
+                ),
+              );
+        }
+      },
+      onError: (Object error, StackTrace stackTrace) {
+        _pending.remove(id)?.completeError(error, stackTrace);
+      },
+    );
+    return completer.future;
+  }
+
+  Future<void> close() async {
+    await Future.wait(
+      _pending.values.map(
+        (pending) => pending.future.then<void>((_) {}, onError: (_) {}),
+      ),
+    );
+    if (_commands.isCompleted) {
+      (await _commands.future).send(null);
+    }
+    _replies.close();
+  }
+
+  void _onReply(Object? message) {
+    switch (message) {
+      case SendPort commands:
+        _commands.complete(commands);
+      case (
+        int id,
+        TransferableTypedData bytes,
+        int styleBytesSaved,
+        int opBytesSaved,
+      ):
+        _pending
+            .remove(id)
+            ?.complete(
+              EncodeResult(
+                bytes.materialize().asUint8List(),
+                styleBytesSaved: styleBytesSaved,
+                opBytesSaved: opBytesSaved,
+              ),
+            );
+      case (int id, Object error, String stackTrace):
+        _pending
+            .remove(id)
+            ?.completeError(error, StackTrace.fromString(stackTrace));
+      case null:
+        _fail(EscPosException('Worker isolate exited unexpectedly.'));
+    }
+  }
+
+  void _fail(EscPosException error) {
+    _failed = true;
+    if (!_commands.isCompleted) {
+      _commands.completeError(error);
+    }
+    final pending = _pending.values.toList();
+    _pending.clear();
+    for (final completer in pending) {
+      completer.completeError(error);
+    }
+    _replies.close();
+  }
+}
+
+void _workerMain(SendPort replies) {
+  final commands = ReceivePort();
+  final resolver = TemplateResolver(templateCache: TemplateCache());
+  replies.send(commands.sendPort);
+
+  commands.listen((message) {
+    switch (message) {
+      case (int id, _EncodeRequest request):
+        try {
+          final result = request.run(resolver);
+          replies.send((
+            id,
+            TransferableTypedData.fromList(<TypedData>[result.bytes]),
+            result.styleBytesSaved,
+            result.opBytesSaved,
+          ));
+        } catch (error, stackTrace) {
+          try {
+            replies.send((id, error, stackTrace.toString()));
+          } on ArgumentError {
+            // The error (or its cause) cannot cross isolates.
+            replies.send((
+              id,
+              EscPosException('Worker isolate failed.', error.toString()),
+              stackTrace.toString(),
+            ));
+          }
+        }
+      case null:
+        commands.close();
+    }
+  });
+}
@@ -0,0 +1,71 @@
+import 'dart:collection';
+import 'dart:typed_data';
+
+/// Ordered chunk writer that lets the producer run ahead of the transport.
+///
+/// Chunks are written strictly in order, one write at a time. [add] returns
+/// as soon as fewer than [maxInFlight] chunks are queued or being written,
+/// so the next chunk can be encoded while earlier ones are on the wire.
+final class WritePipeline {
+  WritePipeline(this._write, {this.maxInFlight = 2})
+    : assert(maxInFlight > 0);
+
+  final Future<void> Function(Uint8List chunk) _write;
+  final int maxInFlight;
+
+  final Queue<Future<void>> _inFlight = Queue<Future<void>>();
+  Future<void> _tail = Future<void>.value();
+  int _bytesWritten = 0;
+
+  /// Bytes whose write has completed.
+  int get bytesWritten => _bytesWritten;
+
+  Future<void> add(Uint8List chunk) async {
+    if (chunk.isEmpty) {
+      return;
+    }
+
+    final write = _tail.then((_) => _write(chunk)).then((_) {
+      _bytesWritten += chunk.length;
+    });
+    _tail = write;
+    _inFlight.add(write);
+
+    while (_inFlight.length >= maxInFlight) {
+      await _awaitOldest();
+    }
+  }
+
+  /// Waits for every queued chunk to be written. More chunks may follow.
+  Future<void> flush() async {
+    while (_inFlight.isNotEmpty) {
+      await _awaitOldest();
+    }
+  }
+
+  /// Waits for every queued chunk to be written.
+  Future<void> close() => flush();
+
+  /// Stops tracking queued chunks without waiting for them. Their results,
+  /// errors included, are ignored; use it before abandoning the job.
+  void discard() {
+    for (final pending in _inFlight) {
+      pending.ignore();
+    }
+    _inFlight.clear();
+  }
+
+  Future<void> _awaitOldest() async {
+    try {
+      await _inFlight.removeFirst();
+    } catch (_) {
+      // Later writes are chained on the failed one and fail with the same
+      // error; drop them so it is reported only once.
+      for (final pending in _inFlight) {
+        pending.ignore();
+      }
+      _inFlight.clear();
+      rethrow;
+    }
+  }
+}
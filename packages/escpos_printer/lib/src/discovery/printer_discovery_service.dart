@@ -1,3 +1,5 @@
+import 'dart:async';
+
 import '../model/discovery.dart';
 import '../transport/native_transport_bridge.dart';
 import 'wifi_discovery.dart';
@@ -12,39 +14,28 @@ class PrinterDiscoveryService {
   final NativeTransportBridge _nativeBridge;
   final WifiDiscovery _wifiDiscovery;
 
+  /// Every printer found within [PrinterDiscoveryOptions.timeout], sorted
+  /// by transport and name. Wi-Fi and native transports are searched
+  /// concurrently.
   Future<List<DiscoveredPrinter>> search(
     PrinterDiscoveryOptions options,
   ) async {
-    final results = <DiscoveredPrinter>[];
-
-    if (options.transports.contains(DiscoveryTransport.wifi)) {
-      try {
-        results.addAll(await _wifiDiscovery.search(options));
-      } catch (_) {
-        // best effort
-      }
-    }
-
-    final nativeTransports = options.transports
-        .where((transport) => transport != DiscoveryTransport.wifi)
-        .toSet();
-    if (nativeTransports.isNotEmpty) {
-      try {
-        results.addAll(
-          await _nativeBridge.searchNativePrinters(
-            transports: nativeTransports,
+    final searches = await Future.wait(<Future<List<DiscoveredPrinter>>>[
+      if (options.transports.contains(DiscoveryTransport.wifi))
+        _bestEffort(_wifiDiscovery.search(options)),
+      if (_nativeTransports(options).isNotEmpty)
+        _bestEffort(
+          _nativeBridge.searchNativePrinters(
+            transports: _nativeTransports(options),
             timeout: options.timeout,
             wifiPort: options.wifiPort,
             wifiCidrs: options.wifiCidrs,
           ),
-        );
-      } catch (_) {
-        // best effort
-      }
-    }
+        ),
+    ]);
 
     final deduped = <String, DiscoveredPrinter>{};
-    for (final item in results) {
+    for (final item in searches.expand((printers) => printers)) {
       deduped[item.dedupeKey()] = item;
     }
 
@@ -52,6 +43,99 @@ class PrinterDiscoveryService {
     return List<DiscoveredPrinter>.unmodifiable(ordered);
   }
 
+  /// Printers in the order they are found, each once (by
+  /// [DiscoveredPrinter.dedupeKey]). Wi-Fi and native transports are
+  /// searched concurrently; the stream closes when all of them are done or
+  /// [PrinterDiscoveryOptions.timeout] expires, and cancelling it stops
+  /// the searches. Failing transports are skipped.
+  Stream<DiscoveredPrinter> discover(PrinterDiscoveryOptions options) {
+    final seen = <String>{};
+    final subscriptions = <StreamSubscription<DiscoveredPrinter>>[];
+    Timer? deadline;
+    late final StreamController<DiscoveredPrinter> controller;
+
+    void finish() {
+      deadline?.cancel();
+      for (final subscription in subscriptions) {
+        unawaited(subscription.cancel());
+      }
+      subscriptions.clear();
+      if (!controller.isClosed) {
+        unawaited(controller.close());
+      }
+    }
+
+    void listen(Stream<DiscoveredPrinter> source) {
+      late final StreamSubscription<DiscoveredPrinter> subscription;
+      subscription = source.listen(
+        (printer) {
+          if (options.transports.contains(printer.transport) &&
+              seen.add(printer.dedupeKey())) {
+            controller.add(printer);
+          }
+        },
+        onError: (Object _) {
+          // best effort
+        },
+        onDone: () {
+          subscriptions.remove(subscription);
+          if (subscriptions.isEmpty) {
+            finish();
+          }
+        },
+      );
+      subscriptions.add(subscription);
+    }
+
+    controller = StreamController<DiscoveredPrinter>(
+      onListen: () {
+        deadline = Timer(options.timeout, finish);
+        if (options.transports.contains(DiscoveryTransport.wifi)) {
+          final wifi = _wifiDiscovery;
+          listen(
+            wifi is StreamingWifiDiscovery
+                ? wifi.discover(options)
+                : Stream<List<DiscoveredPrinter>>.fromFuture(
+                    wifi.search(options),
+                  ).expand((printers) => printers),
+          );
+        }
+        final nativeTransports = _nativeTransports(options);
+        if (nativeTransports.isNotEmpty) {
+          listen(
+            _nativeBridge.discoverNativePrinters(
+              transports: nativeTransports,
+              timeout: options.timeout,
+              wifiPort: options.wifiPort,
+              wifiCidrs: options.wifiCidrs,
+            ),
+          );
+        }
+        if (subscriptions.isEmpty) {
+          finish();
+        }
+      },
+      onCancel: finish,
+    );
+    return controller.stream;
+  }
+
+  Set<DiscoveryTransport> _nativeTransports(PrinterDiscoveryOptions options) {
+    return options.transports
+        .where((transport) => transport != DiscoveryTransport.wifi)
+        .toSet();
+  }
+
+  Future<List<DiscoveredPrinter>> _bestEffort(
+    Future<List<DiscoveredPrinter>> search,
+  ) async {
+    try {
+      return await search;
+    } catch (_) {
+      return const <DiscoveredPrinter>[];
+    }
+  }
+
   int _compare(DiscoveredPrinter a, DiscoveredPrinter b) {
     final byTransport = a.transport.index.compareTo(b.transport.index);
     if (byTransport != 0) {
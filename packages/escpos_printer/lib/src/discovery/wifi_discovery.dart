@@ -9,44 +9,70 @@ abstract interface class WifiDiscovery {
   Future<List<DiscoveredPrinter>> search(PrinterDiscoveryOptions options);
 }
 
-final class WifiSubnetDiscovery implements WifiDiscovery {
-  const WifiSubnetDiscovery();
+/// [WifiDiscovery] that can report hosts while the sweep is still running.
+abstract interface class StreamingWifiDiscovery implements WifiDiscovery {
+  /// Each responding host as soon as it accepts a connection. Closes when
+  /// every candidate was tried or [PrinterDiscoveryOptions.timeout] expires,
+  /// and stops probing when the subscription is cancelled.
+  Stream<DiscoveredPrinter> discover(PrinterDiscoveryOptions options);
+}
+
+/// Probes every host of the local /24 networks on the printer port.
+///
+/// Hosts in the kernel's neighbour table are probed first: they answered
+/// recently, so printers among them are found within one round trip
+/// instead of after the sweep. [PrinterDiscoveryOptions.wifiVendorOuis]
+/// skips neighbours made by other vendors.
+final class WifiSubnetDiscovery implements StreamingWifiDiscovery {
+  const WifiSubnetDiscovery({this.neighborTablePath = '/proc/net/arp'});
+
+  /// IPv4 neighbour table in the `/proc/net/arp` format. When it cannot be
+  /// read (other platforms, sandboxed apps) hosts are probed in order.
+  final String neighborTablePath;
 
   @override
   Future<List<DiscoveredPrinter>> search(
     PrinterDiscoveryOptions options,
   ) async {
-    final candidates = await _buildCandidates(options);
-    if (candidates.isEmpty) {
-      return const <DiscoveredPrinter>[];
-    }
+    final found = await discover(options).toList();
+    found.sort((a, b) => a.id.compareTo(b.id));
+    return List<DiscoveredPrinter>.unmodifiable(found);
+  }
 
+  @override
+  Stream<DiscoveredPrinter> discover(PrinterDiscoveryOptions options) {
     final maxConcurrent = options.wifiMaxConcurrentHosts.clamp(1, 512);
-    final queue = Queue<String>.from(candidates);
-    final found = <DiscoveredPrinter>[];
+    final queue = Queue<String>();
+    var macs = const <String, String>{};
     var active = 0;
     var done = false;
+    Timer? deadline;
+    late final StreamController<DiscoveredPrinter> controller;
 
-    final completer = Completer<void>();
-
-    void schedule() {
+    void finish() {
       if (done) {
         return;
       }
+      done = true;
+      deadline?.cancel();
+      queue.clear();
+      unawaited(controller.close());
+    }
 
+    void schedule() {
       while (active < maxConcurrent && queue.isNotEmpty && !done) {
         final host = queue.removeFirst();
         active++;
-        _probeHost(host, options)
+        _probeHost(host, macs[host], options)
             .then((printer) {
-              if (printer != null) {
-                found.add(printer);
+              if (printer != null && !done) {
+                controller.add(printer);
               }
             })
             .whenComplete(() {
               active--;
-              if (queue.isEmpty && active == 0 && !completer.isCompleted) {
-                completer.complete();
+              if (queue.isEmpty && active == 0) {
+                finish();
               } else {
                 schedule();
               }
@@ -54,24 +80,40 @@ final class WifiSubnetDiscovery implements WifiDiscovery {
       }
     }
 
-    schedule();
-
-    try {
-      await completer.future.timeout(options.timeout);
-    } on TimeoutException {
-      done = true;
-    }
-
-    found.sort((a, b) => a.id.compareTo(b.id));
-    return List<DiscoveredPrinter>.unmodifiable(found);
+    controller = StreamController<DiscoveredPrinter>(
+      onListen: () async {
+        deadline = Timer(options.timeout, finish);
+        final List<String> candidates;
+        try {
+          final (hosts, neighborMacs) = await _buildCandidates(options);
+          candidates = hosts;
+          macs = neighborMacs;
+        } catch (_) {
+          finish();
+          return;
+        }
+        if (candidates.isEmpty) {
+          finish();
+          return;
+        }
+        queue.addAll(candidates);
+        schedule();
+      },
+      onCancel: finish,
+    );
+    return controller.stream;
   }
 
-  Future<List<String>> _buildCandidates(PrinterDiscoveryOptions options) async {
+  /// Hosts to probe, neighbours first, and the MAC address of each
+  /// neighbour.
+  Future<(List<String>, Map<String, String>)> _buildCandidates(
+    PrinterDiscoveryOptions options,
+  ) async {
     final cidrs = options.wifiCidrs.isNotEmpty
         ? options.wifiCidrs
         : await _inferLocalCidrs();
     if (cidrs.isEmpty) {
-      return const <String>[];
+      return (const <String>[], const <String, String>{});
     }
 
     final hosts = <String>{};
@@ -85,7 +127,53 @@ final class WifiSubnetDiscovery implements WifiDiscovery {
       }
     }
 
-    return hosts.toList(growable: false);
+    final ouis = options.wifiVendorOuis.map(_hexDigits).toList();
+    final neighbors = <String>[];
+    final macs = <String, String>{};
+    for (final (host, mac) in await _readNeighbors()) {
+      if (!hosts.remove(host)) {
+        continue;
+      }
+      final digits = _hexDigits(mac);
+      if (ouis.isNotEmpty && !ouis.any(digits.startsWith)) {
+        continue;
+      }
+      neighbors.add(host);
+      macs[host] = mac;
+    }
+
+    return (<String>[...neighbors, ...hosts], macs);
+  }
+
+  /// Resolved entries of [neighborTablePath] as (IPv4 address, MAC), in
+  /// table order.
+  Future<List<(String, String)>> _readNeighbors() async {
+    final List<String> lines;
+    try {
+      lines = await File(neighborTablePath).readAsLines();
+    } on FileSystemException {
+      return const <(String, String)>[];
+    }
+
+    final neighbors = <(String, String)>[];
+    // IP address, HW type, Flags, HW address, Mask, Device; then a header.
+    for (final line in lines.skip(1)) {
+      final fields = line.trim().split(RegExp(r'\s+'));
+      if (fields.length < 4) {
+        continue;
+      }
+      // ATF_COM: the MAC address is resolved.
+      final flags = int.tryParse(fields[2]);
+      if (flags == null || flags & 0x2 == 0) {
+        continue;
+      }
+      neighbors.add((fields[0], fields[3].toLowerCase()));
+    }
+    return neighbors;
+  }
+
+  static String _hexDigits(String mac) {
+    return mac.toLowerCase().replaceAll(RegExp('[^0-9a-f]'), '');
   }
 
   Future<List<String>> _inferLocalCidrs() async {
@@ -127,6 +215,7 @@ final class WifiSubnetDiscovery implements WifiDiscovery {
 
   Future<DiscoveredPrinter?> _probeHost(
     String host,
+    String? mac,
     PrinterDiscoveryOptions options,
   ) async {
     Socket? socket;
@@ -143,7 +232,10 @@ final class WifiSubnetDiscovery implements WifiDiscovery {
         transport: DiscoveryTransport.wifi,
         endpoint: WifiEndpoint(host, port: options.wifiPort),
         host: host,
-        metadata: <String, Object?>{'port': options.wifiPort},
+        metadata: <String, Object?>{
+          'port': options.wifiPort,
+          if (mac != null) 'mac': mac,
+        },
       );
     } catch (_) {
       return null;
@@ -0,0 +1,75 @@
+import 'dart:typed_data';
+
+/// Converts a row-major raster (one bit per dot, MSB leftmost, as sent with
+/// `GS v 0`) to the column format of `ESC *`.
+///
+/// The result holds `ceil(heightDots / bandHeight)` bands of
+/// `widthBytes * 8` columns each. A column is `bandHeight / 8` bytes, top
+/// byte first, MSB topmost. Rows past [heightDots], and bytes missing from
+/// a short [raster], are blank. [bandHeight] is 8 or 24.
+///
+/// Bits are moved eight rows by eight columns at a time with
+/// [transposeBits8x8], so the cost is per byte rather than per dot.
+Uint8List rasterToColumns(
+  Uint8List raster, {
+  required int widthBytes,
+  required int heightDots,
+  required int bandHeight,
+}) {
+  assert(bandHeight == 8 || bandHeight == 24);
+  final columns = widthBytes * 8;
+  final bytesPerColumn = bandHeight ~/ 8;
+  final bands = (heightDots + bandHeight - 1) ~/ bandHeight;
+  final bandBytes = columns * bytesPerColumn;
+  final out = Uint8List(bands * bandBytes);
+
+  for (var band = 0; band < bands; band++) {
+    for (var block = 0; block < bytesPerColumn; block++) {
+      final firstRow = band * bandHeight + block * 8;
+      if (firstRow >= heightDots) {
+        break;
+      }
+      final rows = heightDots - firstRow < 8 ? heightDots - firstRow : 8;
+      for (var xByte = 0; xByte < widthBytes; xByte++) {
+        // Row 0 in the top byte; missing rows stay zero.
+        var word = 0;
+        var offset = firstRow * widthBytes + xByte;
+        for (var row = 0; row < 8; row++) {
+          word <<= 8;
+          if (row < rows && offset < raster.length) {
+            word |= raster[offset];
+          }
+          offset += widthBytes;
+        }
+        if (word == 0) {
+          continue;
+        }
+
+        final transposed = transposeBits8x8(word);
+        var target = band * bandBytes + xByte * 8 * bytesPerColumn + block;
+        for (var shift = 56; shift >= 0; shift -= 8) {
+          out[target] = (transposed >>> shift) & 0xFF;
+          target += bytesPerColumn;
+        }
+      }
+    }
+  }
+  return out;
+}
+
+/// Transposes an 8x8 bit matrix packed in a 64-bit word, row 0 in the top
+/// byte and column 0 in each byte's MSB.
+///
+/// Three mask-and-shift rounds swap 1x1, 2x2 and 4x4 sub-blocks across the
+/// diagonal (Hacker's Delight, 7-3), so all 64 bits move in nine word
+/// operations instead of 64 single-bit ones. Requires 64-bit integers.
+int transposeBits8x8(int word) {
+  var x = word;
+  var t = (x ^ (x >>> 7)) & 0x00AA00AA00AA00AA;
+  x = x ^ t ^ (t << 7);
+  t = (x ^ (x >>> 14)) & 0x0000CCCC0000CCCC;
+  x = x ^ t ^ (t << 14);
+  t = (x ^ (x >>> 28)) & 0x00000000F0F0F0F0;
+  x = x ^ t ^ (t << 28);
+  return x;
+}
@@ -0,0 +1,82 @@
+import 'dart:typed_data';
+
+/// Growable byte buffer used by the encoder.
+///
+/// Appends go straight into one [Uint8List] that doubles when full, so
+/// encoding a job does not allocate per command or per line.
+final class EscPosByteWriter {
+  EscPosByteWriter([int initialCapacity = 1024])
+    : _initialCapacity = initialCapacity < 16 ? 16 : initialCapacity,
+      _buffer = Uint8List(initialCapacity < 16 ? 16 : initialCapacity);
+
+  final int _initialCapacity;
+  Uint8List _buffer;
+  int _length = 0;
+
+  int get length => _length;
+
+  void add(int byte) {
+    _ensureCapacity(1);
+    _buffer[_length++] = byte;
+  }
+
+  void addAll(List<int> bytes) {
+    final count = bytes.length;
+    _ensureCapacity(count);
+    _buffer.setRange(_length, _length + count, bytes);
+    _length += count;
+  }
+
+  /// Appends [count] copies of [byte].
+  void fill(int byte, int count) {
+    if (count <= 0) {
+      return;
+    }
+    _ensureCapacity(count);
+    _buffer.fillRange(_length, _length + count, byte);
+    _length += count;
+  }
+
+  /// Appends [text] translated through [table], one byte per code unit.
+  ///
+  /// A surrogate pair yields a single byte, looked up from its high half.
+  void addText(String text, Uint8List table) {
+    final count = text.length;
+    _ensureCapacity(count);
+    final buffer = _buffer;
+    var out = _length;
+    for (var i = 0; i < count; i++) {
+      final unit = text.codeUnitAt(i);
+      if ((unit & 0xFC00) == 0xD800 &&
+          i + 1 < count &&
+          (text.codeUnitAt(i + 1) & 0xFC00) == 0xDC00) {
+        i++;
+      }
+      buffer[out++] = table[unit];
+    }
+    _length = out;
+  }
+
+  /// Returns the written bytes and resets the writer.
+  ///
+  /// The result is a view on the internal buffer; no copy is made.
+  Uint8List takeBytes() {
+    final result = Uint8List.sublistView(_buffer, 0, _length);
+    _buffer = Uint8List(_initialCapacity);
+    _length = 0;
+    return result;
+  }
+
+  void _ensureCapacity(int extra) {
+    final required = _length + extra;
+    if (required <= _buffer.length) {
+      return;
+    }
+    var capacity = _buffer.length * 2;
+    while (capacity < required) {
+      capacity *= 2;
+    }
+    final grown = Uint8List(capacity)..setRange(0, _length, _buffer);
+    _buffer = grown;
+  }
+}
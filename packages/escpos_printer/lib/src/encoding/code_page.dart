@@ -0,0 +1,60 @@
+import 'dart:typed_data';
+
+import '../model/options.dart';
+
+/// Byte written for code units the code page cannot represent (`?`).
+const int unmappedByte = 0x3F;
+
+/// Code unit to byte table for [codeTable].
+///
+/// Tables span every UTF-16 code unit, so translating a character is one
+/// indexed load. They are built on first use and shared afterwards. Without
+/// a code table, text is sent as Latin-1.
+Uint8List codePageTable(EscPosCodeTable? codeTable) {
+  return switch (codeTable) {
+    null => _latin1Table,
+    EscPosCodeTable.wcp1252 => _wcp1252Table,
+  };
+}
+
+final Uint8List _latin1Table = _buildTable(const <int, int>{});
+
+// Windows-1252 places typographic characters in 0x80-0x9F.
+final Uint8List _wcp1252Table = _buildTable(const <int, int>{
+  0x20AC: 0x80,
+  0x201A: 0x82,
+  0x0192: 0x83,
+  0x201E: 0x84,
+  0x2026: 0x85,
+  0x2020: 0x86,
+  0x2021: 0x87,
+  0x02C6: 0x88,
+  0x2030: 0x89,
+  0x0160: 0x8A,
+  0x2039: 0x8B,
+  0x0152: 0x8C,
+  0x017D: 0x8E,
+  0x2018: 0x91,
+  0x2019: 0x92,
+  0x201C: 0x93,
+  0x201D: 0x94,
+  0x2022: 0x95,
+  0x2013: 0x96,
+  0x2014: 0x97,
+  0x02DC: 0x98,
+  0x2122: 0x99,
+  0x0161: 0x9A,
+  0x203A: 0x9B,
+  0x0153: 0x9C,
+  0x017E: 0x9E,
+  0x0178: 0x9F,
+});
+
+Uint8List _buildTable(Map<int, int> extras) {
+  final table = Uint8List(0x10000)..fillRange(0x100, 0x10000, unmappedByte);
+  for (var unit = 0; unit < 0x100; unit++) {
+    table[unit] = unit;
+  }
+  extras.forEach((unit, byte) => table[unit] = byte);
+  return table;
+}
@@ -1,118 +1,156 @@
-import 'dart:convert';
 import 'dart:typed_data';
 
 import '../model/exceptions.dart';
 import '../model/options.dart';
 import '../template/operations.dart';
+import 'bit_image.dart';
+import 'byte_writer.dart';
+import 'code_page.dart';
+import 'op_optimizer.dart';
 
 final class EscPosEncoder {
   const EscPosEncoder({
     this.paperWidthChars = 48,
     this.codeTable = EscPosCodeTable.wcp1252,
+    this.imageFormat = BitImageFormat.raster,
   }) : assert(paperWidthChars > 0);
 
   final int paperWidthChars;
   final EscPosCodeTable? codeTable;
+  final BitImageFormat imageFormat;
 
-  List<int> encode(List<PrintOp> ops, {bool initializePrinter = true}) {
-    final bytes = <int>[];
+  Uint8List encode(List<PrintOp> ops, {bool initializePrinter = true}) {
+    return encodeJob(ops, initializePrinter: initializePrinter).bytes;
+  }
 
-    if (initializePrinter) {
-      bytes.addAll(const <int>[0x1B, 0x40]);
-      final selectedCodeTable = codeTable;
-      if (selectedCodeTable != null) {
-        bytes.addAll(<int>[0x1B, 0x74, selectedCodeTable.value]);
-      }
+  /// Encodes [ops] and reports how many formatting bytes state tracking saved.
+  ///
+  /// Alignment and text style commands are only sent when they differ from
+  /// what the printer already has. Settings the job changed are restored to
+  /// their defaults before it ends.
+  ///
+  /// With [optimize], [ops] first go through [PrintOpOptimizer], and the
+  /// bytes it removed are reported as [EncodeResult.opBytesSaved].
+  EncodeResult encodeJob(
+    List<PrintOp> ops, {
+    bool initializePrinter = true,
+    bool optimize = false,
+  }) {
+    var jobOps = ops;
+    var opBytesSaved = 0;
+    if (optimize) {
+      final optimized = PrintOpOptimizer(
+        encoder: this,
+      ).optimize(ops, initializePrinter: initializePrinter);
+      jobOps = optimized.ops;
+      opBytesSaved = optimized.bytesSaved;
     }
 
+    final job = startJob(initializePrinter: initializePrinter);
+    for (final op in jobOps) {
+      job.add(op);
+    }
+    return EncodeResult(
+      job.finish(),
+      styleBytesSaved: job.styleBytesSaved,
+      opBytesSaved: opBytesSaved,
+    );
+  }
+
+  /// Encodes [ops] as a sequence of chunks of roughly [chunkSizeBytes].
+  ///
+  /// Chunks break only between ops, and the next chunk is not encoded until
+  /// the caller asks for it, so bytes can be sent while later ops are still
+  /// pending.
+  Iterable<Uint8List> encodeChunks(
+    List<PrintOp> ops, {
+    bool initializePrinter = true,
+    int chunkSizeBytes = 4096,
+  }) sync* {
+    final job = startJob(initializePrinter: initializePrinter);
     for (final op in ops) {
-      switch (op) {
-        case TextOp(:final text, :final style):
-          _appendStyledText(bytes, text, style);
-
-        case RowOp(:final columns):
-          _appendRow(bytes, columns);
-
-        case QrCodeOp(:final data, :final size, :final align):
-          _appendAlign(bytes, align);
-          _appendQrCode(bytes, data, size: size);
-
-        case BarcodeOp(:final data, :final type, :final height, :final align):
-          _appendAlign(bytes, align);
-          _appendBarcode(bytes, data, type: type, height: height);
-
-        case ImageOp(
-          :final rasterData,
-          :final widthBytes,
-          :final heightDots,
-          :final mode,
-          :final align,
-        ):
-          _appendAlign(bytes, align);
-          _appendImage(
-            bytes,
-            rasterData,
-            widthBytes: widthBytes,
-            heightDots: heightDots,
-            mode: mode,
-          );
-
-        case FeedOp(:final lines):
-          bytes.addAll(<int>[0x1B, 0x64, lines]);
-
-        case CutOp(:final mode):
-          bytes.addAll(<int>[0x1D, 0x56, mode == CutMode.full ? 0 : 1]);
-
-        case DrawerKickOp(:final pin, :final onMs, :final offMs):
-          bytes.addAll(<int>[
-            0x1B,
-            0x70,
-            pin == DrawerPin.pin2 ? 0 : 1,
-            onMs,
-            offMs,
-          ]);
-
-        case TextTemplateOp() || TemplateBlockOp():
-          throw TemplateValidationException(
-            'Operacao de template nao resolvida antes do encoding.',
-          );
+      job.add(op);
+      if (job.pendingBytes >= chunkSizeBytes) {
+        yield job.takeBytes();
       }
     }
+    final tail = job.finish();
+    if (tail.isNotEmpty) {
+      yield tail;
+    }
+  }
 
-    return bytes;
+  /// Starts an incremental encoding of one print job.
+  EscPosJobEncoder startJob({bool initializePrinter = true}) {
+    return EscPosJobEncoder._(this, initializePrinter: initializePrinter);
   }
 
   void _appendStyledText(
-    List<int> output,
+    EscPosByteWriter output,
+    _PrinterState state,
     String text,
     ReceiptTextStyle style,
   ) {
-    _appendAlign(output, style.align);
-
-    output.addAll(<int>[0x1B, 0x45, style.bold ? 1 : 0]);
-    output.addAll(<int>[0x1B, 0x2D, style.underline ? 1 : 0]);
-    output.addAll(<int>[0x1D, 0x42, style.invert ? 1 : 0]);
-    output.addAll(<int>[0x1B, 0x4D, style.font == FontType.a ? 0 : 1]);
-
-    final size = ((style.widthScale - 1) << 4) | (style.heightScale - 1);
-    output.addAll(<int>[0x1D, 0x21, size]);
-
-    output.addAll(_latin1WithFallback(text));
+    state.applyTextStyle(output, style);
+    output.addText(text, codePageTable(codeTable));
     output.add(0x0A);
-
-    // Prevent style state from leaking into the next block.
-    output.addAll(const <int>[0x1B, 0x45, 0]);
-    output.addAll(const <int>[0x1B, 0x2D, 0]);
-    output.addAll(const <int>[0x1D, 0x42, 0]);
-    output.addAll(const <int>[0x1B, 0x4D, 0]);
-    output.addAll(const <int>[0x1D, 0x21, 0]);
   }
 
-  void _appendRow(List<int> output, List<RowColumnSpec> columns) {
+  void _appendRow(EscPosByteWriter output, List<RowColumnSpec> columns) {
     if (columns.isEmpty) {
       return;
     }
 
+    final (widths, wrappedColumns, lineCount) = _layoutColumns(columns);
+    final table = codePageTable(codeTable);
+    for (var line = 0; line < lineCount; line++) {
+      for (var colIndex = 0; colIndex < columns.length; colIndex++) {
+        final chunk = line < wrappedColumns[colIndex].length
+            ? wrappedColumns[colIndex][line]
+            : '';
+        _appendCell(
+          output,
+          chunk,
+          widths[colIndex],
+          columns[colIndex].align,
+          table,
+        );
+      }
+      output.add(0x0A);
+    }
+  }
+
+  /// The lines [RowOp] prints for [columns], each cell padded with spaces
+  /// to its column width.
+  List<String> layoutRow(List<RowColumnSpec> columns) {
+    final (widths, wrappedColumns, lineCount) = _layoutColumns(columns);
+    final lines = <String>[];
+    for (var line = 0; line < lineCount; line++) {
+      final buffer = StringBuffer();
+      for (var colIndex = 0; colIndex < columns.length; colIndex++) {
+        final chunk = line < wrappedColumns[colIndex].length
+            ? wrappedColumns[colIndex][line]
+            : '';
+        final width = widths[colIndex];
+        final trimmed = chunk.length > width
+            ? chunk.substring(0, width)
+            : chunk;
+        final padding = width - trimmed.length;
+        final before = _leadingPadding(padding, columns[colIndex].align);
+        buffer
+          ..write(' ' * before)
+          ..write(trimmed)
+          ..write(' ' * (padding - before));
+      }
+      lines.add(buffer.toString());
+    }
+    return lines;
+  }
+
+  /// Column widths, wrapped cell lines and the row's line count.
+  (List<int>, List<List<String>>, int) _layoutColumns(
+    List<RowColumnSpec> columns,
+  ) {
     final totalFlex = columns.fold<int>(0, (sum, item) => sum + item.flex);
     final widths = List<int>.filled(columns.length, 0);
 
@@ -140,27 +178,15 @@ final class EscPosEncoder {
         maxLines = wrapped.length;
       }
     }
-
-    for (var line = 0; line < maxLines; line++) {
-      final row = StringBuffer();
-      for (var colIndex = 0; colIndex < columns.length; colIndex++) {
-        final chunk = line < wrappedColumns[colIndex].length
-            ? wrappedColumns[colIndex][line]
-            : '';
-        final aligned = _alignCell(
-          chunk,
-          widths[colIndex],
-          columns[colIndex].align,
-        );
-        row.write(aligned);
-      }
-      output.addAll(_latin1WithFallback(row.toString()));
-      output.add(0x0A);
-    }
+    return (widths, wrappedColumns, maxLines);
   }
 
-  void _appendQrCode(List<int> output, String data, {required int size}) {
-    final dataBytes = _latin1WithFallback(data);
+  void _appendQrCode(
+    EscPosByteWriter output,
+    String data, {
+    required int size,
+  }) {
+    final dataBytes = _encodeLatin1(data);
     output.addAll(const <int>[
       0x1D,
       0x28,
@@ -185,12 +211,12 @@ final class EscPosEncoder {
   }
 
   void _appendBarcode(
-    List<int> output,
+    EscPosByteWriter output,
     String data, {
     required BarcodeType type,
     required int height,
   }) {
-    final dataBytes = _latin1WithFallback(data);
+    final dataBytes = _encodeLatin1(data);
     final barcodeType = switch (type) {
       BarcodeType.upca => 65,
       BarcodeType.upce => 66,
@@ -208,7 +234,7 @@ final class EscPosEncoder {
   }
 
   void _appendImage(
-    List<int> output,
+    EscPosByteWriter output,
     Uint8List rasterData, {
     required int widthBytes,
     required int heightDots,
@@ -221,6 +247,17 @@ final class EscPosEncoder {
       );
     }
 
+    if (imageFormat != BitImageFormat.raster) {
+      _appendColumnImage(
+        output,
+        rasterData,
+        widthBytes: widthBytes,
+        heightDots: heightDots,
+        doubleWidth: mode & 0x01 != 0,
+      );
+      return;
+    }
+
     final xL = widthBytes & 0xFF;
     final xH = (widthBytes >> 8) & 0xFF;
     final yL = heightDots & 0xFF;
@@ -231,83 +268,150 @@ final class EscPosEncoder {
     output.add(0x0A);
   }
 
-  void _appendAlign(List<int> output, TextAlign align) {
-    final alignValue = switch (align) {
-      TextAlign.left => 0,
-      TextAlign.center => 1,
-      TextAlign.right => 2,
-    };
-    output.addAll(<int>[0x1B, 0x61, alignValue]);
+  /// Sends the image as `ESC *` bands, one per line, with the line spacing
+  /// set to the band height so bands touch.
+  ///
+  /// Single density (modes 0/32) stands in for the raster double-width
+  /// flag; column format has no double height.
+  void _appendColumnImage(
+    EscPosByteWriter output,
+    Uint8List rasterData, {
+    required int widthBytes,
+    required int heightDots,
+    required bool doubleWidth,
+  }) {
+    final bandHeight = imageFormat == BitImageFormat.column24 ? 24 : 8;
+    final density = (bandHeight == 24 ? 32 : 0) + (doubleWidth ? 0 : 1);
+    final columns = widthBytes * 8;
+    final bandBytes = columns * (bandHeight ~/ 8);
+    final data = rasterToColumns(
+      rasterData,
+      widthBytes: widthBytes,
+      heightDots: heightDots,
+      bandHeight: bandHeight,
+    );
+
+    // Both band heights are 24/180" (8-dot bands print at 60 dpi).
+    output.addAll(const <int>[0x1B, 0x33, 24]);
+    for (var offset = 0; offset < data.length; offset += bandBytes) {
+      output.addAll(<int>[
+        0x1B,
+        0x2A,
+        density,
+        columns & 0xFF,
+        (columns >> 8) & 0xFF,
+      ]);
+      output.addAll(Uint8List.sublistView(data, offset, offset + bandBytes));
+      output.add(0x0A);
+    }
+    output.addAll(const <int>[0x1B, 0x32]);
   }
 
-  List<int> _latin1WithFallback(String value) {
-    final runes = value.runes;
-    final chars = StringBuffer();
-    for (final rune in runes) {
-      if (rune <= 0xFF) {
-        chars.writeCharCode(rune);
-      } else {
-        chars.write('?');
-      }
-    }
-    return latin1.encode(chars.toString());
+  Uint8List _encodeLatin1(String value) {
+    final writer = EscPosByteWriter(value.length);
+    writer.addText(value, codePageTable(null));
+    return writer.takeBytes();
   }
 
+  /// Word-wraps [text] to [width] columns in a single pass.
+  ///
+  /// Words are separated by whitespace runs and joined with one space;
+  /// `\n` starts a new paragraph and `\r` is dropped.
   List<String> _wrapText(String text, int width) {
     if (width <= 0) {
       return const <String>[''];
     }
 
-    final normalized = text.replaceAll('\r', '');
-    final paragraphs = normalized.split('\n');
     final lines = <String>[];
+    final current = StringBuffer();
+    final word = StringBuffer();
 
-    for (final paragraph in paragraphs) {
-      final words = paragraph
-          .split(RegExp(r'\s+'))
-          .where((word) => word.isNotEmpty)
-          .toList(growable: false);
-      if (words.isEmpty) {
-        lines.add('');
-        continue;
+    void flushWord() {
+      if (word.isEmpty) {
+        return;
       }
+      final value = word.toString();
+      word.clear();
 
-      var current = '';
-      for (final word in words) {
-        if (current.isEmpty) {
-          if (word.length <= width) {
-            current = word;
-          } else {
-            lines.addAll(_chunkWord(word, width));
-            current = '';
-          }
-          continue;
+      if (current.isEmpty) {
+        if (value.length <= width) {
+          current.write(value);
+        } else {
+          lines.addAll(_chunkWord(value, width));
         }
+        return;
+      }
 
-        final candidate = '$current $word';
-        if (candidate.length <= width) {
-          current = candidate;
-          continue;
-        }
+      if (current.length + 1 + value.length <= width) {
+        current
+          ..write(' ')
+          ..write(value);
+        return;
+      }
 
-        lines.add(current);
-        if (word.length <= width) {
-          current = word;
-        } else {
-          final chunks = _chunkWord(word, width);
-          lines.addAll(chunks.take(chunks.length - 1));
-          current = chunks.last;
-        }
+      lines.add(current.toString());
+      current.clear();
+      if (value.length <= width) {
+        current.write(value);
+      } else {
+        final chunks = _chunkWord(value, width);
+        lines.addAll(chunks.take(chunks.length - 1));
+        current.write(chunks.last);
       }
+    }
 
+    var paragraphHasWords = false;
+    void endParagraph() {
+      flushWord();
       if (current.isNotEmpty) {
-        lines.add(current);
+        lines.add(current.toString());
+        current.clear();
+      } else if (!paragraphHasWords) {
+        lines.add('');
+      }
+      paragraphHasWords = false;
+    }
+
+    for (var i = 0; i < text.length; i++) {
+      final unit = text.codeUnitAt(i);
+      if (unit == 0x0D) {
+        continue;
+      }
+      if (unit == 0x0A) {
+        endParagraph();
+        continue;
+      }
+      if (_isWhitespace(unit)) {
+        flushWord();
+        continue;
       }
+      word.writeCharCode(unit);
+      paragraphHasWords = true;
     }
+    endParagraph();
 
     return lines;
   }
 
+  /// Matches the code units `RegExp(r'\s')` treats as whitespace.
+  static bool _isWhitespace(int unit) {
+    if (unit <= 0x20) {
+      return unit == 0x20 || (unit >= 0x09 && unit <= 0x0D);
+    }
+    if (unit < 0xA0) {
+      return false;
+    }
+    return unit == 0xA0 ||
+        unit == 0x1680 ||
+        (unit >= 0x2000 && unit <= 0x200A) ||
+        unit == 0x2028 ||
+        unit == 0x2029 ||
+        unit == 0x202F ||
+        unit == 0x205F ||
+        unit == 0x3000 ||
+        unit == 0xFEFF;
+  }
+
   List<String> _chunkWord(String word, int width) {
     final chunks = <String>[];
     var cursor = 0;
@@ -319,18 +423,230 @@ final class EscPosEncoder {
     return chunks;
   }
 
-  String _alignCell(String text, int width, TextAlign align) {
+  void _appendCell(
+    EscPosByteWriter output,
+    String text,
+    int width,
+    TextAlign align,
+    Uint8List table,
+  ) {
     final trimmed = text.length > width ? text.substring(0, width) : text;
     final padding = width - trimmed.length;
     if (padding <= 0) {
-      return trimmed;
+      output.addText(trimmed, table);
+      return;
     }
 
+    final before = _leadingPadding(padding, align);
+    output.fill(0x20, before);
+    output.addText(trimmed, table);
+    output.fill(0x20, padding - before);
+  }
+
+  static int _leadingPadding(int padding, TextAlign align) {
     return switch (align) {
-      TextAlign.left => '$trimmed${' ' * padding}',
-      TextAlign.right => '${' ' * padding}$trimmed',
-      TextAlign.center =>
-        '${' ' * (padding ~/ 2)}$trimmed${' ' * (padding - (padding ~/ 2))}',
+      TextAlign.left => 0,
+      TextAlign.right => padding,
+      TextAlign.center => padding ~/ 2,
+    };
+  }
+}
+
+/// Incremental encoder for one print job, created by
+/// [EscPosEncoder.startJob].
+///
+/// Ops are appended one at a time; encoded bytes can be taken between ops.
+/// Printer style state carries across [takeBytes] calls.
+final class EscPosJobEncoder {
+  EscPosJobEncoder._(this._encoder, {required bool initializePrinter}) {
+    if (initializePrinter) {
+      _bytes.addAll(const <int>[0x1B, 0x40]);
+      _state.assumeDefaults();
+      final selectedCodeTable = _encoder.codeTable;
+      if (selectedCodeTable != null) {
+        _bytes.addAll(<int>[0x1B, 0x74, selectedCodeTable.value]);
+      }
+    }
+  }
+
+  final EscPosEncoder _encoder;
+  final EscPosByteWriter _bytes = EscPosByteWriter();
+  final _PrinterState _state = _PrinterState();
+
+  /// Bytes encoded but not yet taken.
+  int get pendingBytes => _bytes.length;
+
+  int get styleBytesSaved => _state.bytesSaved;
+
+  void add(PrintOp op) {
+    switch (op) {
+      case TextOp(:final text, :final style):
+        _encoder._appendStyledText(_bytes, _state, text, style);
+
+      case RowOp(:final columns):
+        // Rows print in the default style at the current alignment.
+        _state.restoreDefaults(_bytes, includeAlign: false);
+        _encoder._appendRow(_bytes, columns);
+
+      case QrCodeOp(:final data, :final size, :final align):
+        _state.setAlign(_bytes, align);
+        _encoder._appendQrCode(_bytes, data, size: size);
+
+      case BarcodeOp(:final data, :final type, :final height, :final align):
+        _state.setAlign(_bytes, align);
+        _encoder._appendBarcode(_bytes, data, type: type, height: height);
+
+      case ImageOp(
+        :final rasterData,
+        :final widthBytes,
+        :final heightDots,
+        :final mode,
+        :final align,
+      ):
+        _state.setAlign(_bytes, align);
+        _encoder._appendImage(
+          _bytes,
+          rasterData,
+          widthBytes: widthBytes,
+          heightDots: heightDots,
+          mode: mode,
+        );
+
+      case FeedOp(:final lines):
+        _bytes.addAll(<int>[0x1B, 0x64, lines]);
+
+      case CutOp(:final mode):
+        _bytes.addAll(<int>[0x1D, 0x56, mode == CutMode.full ? 0 : 1]);
+
+      case DrawerKickOp(:final pin, :final onMs, :final offMs):
+        _bytes.addAll(<int>[
+          0x1B,
+          0x70,
+          pin == DrawerPin.pin2 ? 0 : 1,
+          onMs,
+          offMs,
+        ]);
+
+      case TextTemplateOp() || TemplateBlockOp():
+        throw TemplateValidationException(
+          'Operacao de template nao resolvida antes do encoding.',
+        );
+    }
+  }
+
+  Uint8List takeBytes() => _bytes.takeBytes();
+
+  /// Restores changed settings and returns the remaining bytes.
+  Uint8List finish() {
+    // Keep style state from leaking into whatever is printed next.
+    _state.restoreDefaults(_bytes, includeAlign: true);
+    return _bytes.takeBytes();
+  }
+}
+
+/// Bytes produced by [EscPosEncoder.encodeJob].
+final class EncodeResult {
+  const EncodeResult(
+    this.bytes, {
+    this.styleBytesSaved = 0,
+    this.opBytesSaved = 0,
+  });
+
+  final Uint8List bytes;
+
+  /// Formatting bytes not sent because the printer already had that state,
+  /// compared to setting and resetting every style around each text line.
+  final int styleBytesSaved;
+
+  /// Bytes [PrintOpOptimizer] removed before encoding; zero unless
+  /// `optimize` was set.
+  final int opBytesSaved;
+}
+
+enum _Setting {
+  align(0x1B, 0x61),
+  bold(0x1B, 0x45),
+  underline(0x1B, 0x2D),
+  invert(0x1D, 0x42),
+  font(0x1B, 0x4D),
+  size(0x1D, 0x21);
+
+  const _Setting(this.prefix, this.command);
+
+  final int prefix;
+  final int command;
+}
+
+/// Formatting state of the printer while a job is encoded.
+///
+/// Each setting holds the last value sent, or `null` while unknown (no
+/// `ESC @` and not yet set by this job). Default values are all `0`.
+final class _PrinterState {
+  final List<int?> _values = List<int?>.filled(_Setting.values.length, null);
+
+  // Bytes a stateless encoder would have spent on formatting.
+  int _baselineBytes = 0;
+  int _emittedBytes = 0;
+
+  int get bytesSaved {
+    final saved = _baselineBytes - _emittedBytes;
+    return saved > 0 ? saved : 0;
+  }
+
+  void assumeDefaults() {
+    _values.fillRange(0, _values.length, 0);
+  }
+
+  void setAlign(EscPosByteWriter output, TextAlign align) {
+    _baselineBytes += 3;
+    _set(output, _Setting.align, _alignValue(align));
+  }
+
+  void applyTextStyle(EscPosByteWriter output, ReceiptTextStyle style) {
+    // Alignment, five style sets and five resets.
+    _baselineBytes += 33;
+    _set(output, _Setting.align, _alignValue(style.align));
+    _set(output, _Setting.bold, style.bold ? 1 : 0);
+    _set(output, _Setting.underline, style.underline ? 1 : 0);
+    _set(output, _Setting.invert, style.invert ? 1 : 0);
+    _set(output, _Setting.font, style.font == FontType.a ? 0 : 1);
+    _set(
+      output,
+      _Setting.size,
+      ((style.widthScale - 1) << 4) | (style.heightScale - 1),
+    );
+  }
+
+  /// Sends the default for every setting this job left non-default.
+  void restoreDefaults(EscPosByteWriter output, {required bool includeAlign}) {
+    for (final setting in _Setting.values) {
+      if (!includeAlign && setting == _Setting.align) {
+        continue;
+      }
+      final current = _values[setting.index];
+      if (current != null && current != 0) {
+        _set(output, setting, 0);
+      }
+    }
+  }
+
+  void _set(EscPosByteWriter output, _Setting setting, int value) {
+    if (_values[setting.index] == value) {
+      return;
+    }
+    output
+      ..add(setting.prefix)
+      ..add(setting.command)
+      ..add(value);
+    _values[setting.index] = value;
+    _emittedBytes += 3;
+  }
+
+  static int _alignValue(TextAlign align) {
+    return switch (align) {
+      TextAlign.left => 0,
+      TextAlign.center => 1,
+      TextAlign.right => 2,
     };
   }
 }
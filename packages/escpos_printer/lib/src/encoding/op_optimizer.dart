@@ -0,0 +1,192 @@
+import '../model/options.dart';
+import '../template/operations.dart';
+import 'escpos_encoder.dart';
+
+/// Ops returned by [PrintOpOptimizer.optimize] and the bytes they save.
+final class OptimizedOps {
+  const OptimizedOps(this.ops, {this.bytesSaved = 0});
+
+  final List<PrintOp> ops;
+
+  /// Bytes the removed and shortened ops would have encoded to. Style
+  /// commands the encoder no longer has to send are not counted.
+  final int bytesSaved;
+}
+
+/// Peephole pass over resolved ops that drops bytes which print nothing.
+///
+/// The printed result does not change:
+/// - `FeedOp(0)` is dropped, and a run of feeds and blank text lines
+///   becomes one `FeedOp` (split at 255 lines) when that is shorter.
+/// - Back-to-back cuts become one cut, full if either was.
+/// - Trailing spaces are stripped where they print blank: text lines that
+///   are left aligned without underline or invert, and rows printed while
+///   the printer is left aligned. Such rows become text.
+/// - Adjacent text ops with the same style are merged.
+///
+/// Alignment is tracked because rows print at whatever alignment the
+/// previous op left; blank lines are only turned into feeds when that does
+/// not change it.
+final class PrintOpOptimizer {
+  const PrintOpOptimizer({this.encoder = const EscPosEncoder()});
+
+  /// Lays out rows and gives the paper width; use the encoder the ops are
+  /// sent to.
+  final EscPosEncoder encoder;
+
+  /// [initializePrinter] says whether the job starts with `ESC @`, which
+  /// makes the alignment known from the first op.
+  OptimizedOps optimize(List<PrintOp> ops, {bool initializePrinter = true}) {
+    final out = <PrintOp>[];
+    var saved = 0;
+    TextAlign? align = initializePrinter ? TextAlign.left : null;
+
+    // Blank lines not yet emitted, as the cheapest ops that print them.
+    final blankRun = <PrintOp>[];
+    var blankLines = 0;
+    var blankRunBytes = 0;
+
+    void flushBlankLines() {
+      final feedBytes = (blankLines + 254) ~/ 255 * 3;
+      if (feedBytes < blankRunBytes) {
+        for (var left = blankLines; left > 0; left -= 255) {
+          out.add(FeedOp(left > 255 ? 255 : left));
+        }
+        saved += blankRunBytes - feedBytes;
+      } else {
+        out.addAll(blankRun);
+      }
+      blankRun.clear();
+      blankLines = 0;
+      blankRunBytes = 0;
+    }
+
+    void addText(String text, ReceiptTextStyle style) {
+      final previous = out.isEmpty ? null : out.last;
+      if (previous is TextOp && _sameStyle(previous.style, style)) {
+        out[out.length - 1] = TextOp(
+          '${previous.text}\n$text',
+          style: style,
+        );
+      } else {
+        out.add(TextOp(text, style: style));
+      }
+    }
+
+    for (final op in ops) {
+      switch (op) {
+        case FeedOp(:final lines):
+          blankRun.add(op);
+          blankLines += lines;
+          blankRunBytes += 3;
+
+        case TextOp(:final text, :final style)
+            when style.align == align && _isBlankLine(text, style):
+          saved += text.length;
+          blankRun.add(TextOp('', style: style));
+          blankLines++;
+          blankRunBytes++;
+
+        case TextOp(:final text, :final style):
+          flushBlankLines();
+          align = style.align;
+          final (trimmed, removed) = _trimLines(text, style);
+          saved += removed;
+          addText(trimmed, style);
+
+        case RowOp(:final columns) when align == TextAlign.left:
+          flushBlankLines();
+          final lines = encoder.layoutRow(columns);
+          final trimmed = lines.map(_trimTrailingSpaces).toList();
+          var removed = 0;
+          for (var i = 0; i < lines.length; i++) {
+            removed += lines[i].length - trimmed[i].length;
+          }
+          if (removed == 0) {
+            out.add(op);
+          } else {
+            // Rows print in the default style, which is left aligned here.
+            saved += removed;
+            addText(trimmed.join('\n'), ReceiptTextStyle.defaults);
+          }
+
+        case CutOp(:final mode):
+          flushBlankLines();
+          final previous = out.isEmpty ? null : out.last;
+          if (previous is CutOp) {
+            out[out.length - 1] = CutOp(
+              previous.mode == CutMode.full ? CutMode.full : mode,
+            );
+            saved += 3;
+          } else {
+            out.add(op);
+          }
+
+        case QrCodeOp(align: final opAlign) ||
+            BarcodeOp(align: final opAlign) ||
+            ImageOp(align: final opAlign):
+          flushBlankLines();
+          align = opAlign;
+          out.add(op);
+
+        case RowOp() || DrawerKickOp() || TextTemplateOp() || TemplateBlockOp():
+          flushBlankLines();
+          out.add(op);
+      }
+    }
+    flushBlankLines();
+
+    return OptimizedOps(List<PrintOp>.unmodifiable(out), bytesSaved: saved);
+  }
+
+  /// Whether [text] prints as one empty line of normal height.
+  static bool _isBlankLine(String text, ReceiptTextStyle style) {
+    if (style.heightScale != 1) {
+      return false;
+    }
+    if (text.isEmpty) {
+      return true;
+    }
+    // Underlined and inverted spaces are visible.
+    return !style.underline &&
+        !style.invert &&
+        _trimTrailingSpaces(text).isEmpty;
+  }
+
+  /// Strips trailing spaces from each line of [text] when they print
+  /// blank, and returns the result with the number of spaces removed.
+  (String, int) _trimLines(String text, ReceiptTextStyle style) {
+    if (style.align != TextAlign.left || style.underline || style.invert) {
+      return (text, 0);
+    }
+    var removed = 0;
+    final lines = text.split('\n').map((line) {
+      // Spaces past the paper width wrap onto a line of their own.
+      if (line.length * style.widthScale > encoder.paperWidthChars) {
+        return line;
+      }
+      final trimmed = _trimTrailingSpaces(line);
+      removed += line.length - trimmed.length;
+      return trimmed;
+    }).toList();
+    return removed == 0 ? (text, 0) : (lines.join('\n'), removed);
+  }
+
+  static String _trimTrailingSpaces(String line) {
+    var end = line.length;
+    while (end > 0 && line.codeUnitAt(end - 1) == 0x20) {
+      end--;
+    }
+    return end == line.length ? line : line.substring(0, end);
+  }
+
+  static bool _sameStyle(ReceiptTextStyle a, ReceiptTextStyle b) {
+    return a.bold == b.bold &&
+        a.underline == b.underline &&
+        a.invert == b.invert &&
+        a.font == b.font &&
+        a.widthScale == b.widthScale &&
+        a.heightScale == b.heightScale &&
+        a.align == b.align;
+  }
+}
@@ -1,6 +1,7 @@
 import 'package:flutter/foundation.dart';
 
 import 'endpoints.dart';
+import 'printer_profile.dart';
 
 enum DiscoveryTransport { wifi, usb, bluetooth }
 
@@ -17,6 +18,7 @@ final class PrinterDiscoveryOptions {
     this.wifiHostTimeout = const Duration(milliseconds: 250),
     this.wifiMaxConcurrentHosts = 64,
     this.wifiCidrs = const <String>[],
+    this.wifiVendorOuis = const <String>[],
   }) : assert(wifiPort > 0 && wifiPort <= 65535),
        assert(wifiMaxConcurrentHosts > 0);
 
@@ -26,6 +28,11 @@ final class PrinterDiscoveryOptions {
   final Duration wifiHostTimeout;
   final int wifiMaxConcurrentHosts;
   final List<String> wifiCidrs;
+
+  /// MAC address prefixes (OUIs, e.g. `00:11:62`) of printer vendors. Hosts
+  /// in the neighbour table whose MAC starts with none of them are not
+  /// probed; hosts missing from the table still are. Empty probes all.
+  final List<String> wifiVendorOuis;
 }
 
 @immutable
@@ -43,6 +50,7 @@ final class DiscoveredPrinter {
     this.host,
     this.isPaired,
     this.metadata = const <String, Object?>{},
+    this.profile,
   });
 
   final String id;
@@ -58,6 +66,9 @@ final class DiscoveredPrinter {
   final bool? isPaired;
   final Map<String, Object?> metadata;
 
+  /// Built-in profile matched from the USB vendor and product ID.
+  final PrinterProfile? profile;
+
   String dedupeKey() {
     switch (transport) {
       case DiscoveryTransport.wifi:
@@ -33,6 +33,7 @@ final class UsbEndpoint extends PrinterEndpoint {
     this.productId, {
     this.serialNumber,
     this.interfaceNumber,
+    this.serialSettings,
   });
 
   const UsbEndpoint.serial(
@@ -40,6 +41,7 @@ final class UsbEndpoint extends PrinterEndpoint {
     this.vendorId,
     this.productId,
     this.interfaceNumber,
+    this.serialSettings,
   }) : assert(
          serialNumber != null && serialNumber != '',
          'serialNumber/path cannot be empty.',
@@ -50,10 +52,40 @@ final class UsbEndpoint extends PrinterEndpoint {
   final String? serialNumber;
   final int? interfaceNumber;
 
+  /// Line settings when [serialNumber] is a serial port (Linux `/dev/tty*`
+  /// or `/dev/rfcomm*`); `null` keeps the port's current speed.
+  final SerialSettings? serialSettings;
+
   @override
   String get transport => 'usb';
 }
 
+enum SerialParity { none, even, odd }
+
+enum SerialFlowControl { none, rtsCts, xonXoff }
+
+/// termios configuration for RS-232 and USB-serial printers.
+///
+/// Writes are paced at the line rate these settings give and complete once
+/// the port has transmitted them (`tcdrain`).
+@immutable
+final class SerialSettings {
+  const SerialSettings({
+    this.baudRate = 9600,
+    this.dataBits = 8,
+    this.parity = SerialParity.none,
+    this.stopBits = 1,
+    this.flowControl = SerialFlowControl.none,
+  }) : assert(dataBits >= 5 && dataBits <= 8, 'dataBits must be 5-8.'),
+       assert(stopBits == 1 || stopBits == 2, 'stopBits must be 1 or 2.');
+
+  final int baudRate;
+  final int dataBits;
+  final SerialParity parity;
+  final int stopBits;
+  final SerialFlowControl flowControl;
+}
+
 enum BluetoothMode { classic, ble }
 
 /// Bluetooth endpoint for classic SPP/RFCOMM or BLE.
@@ -21,6 +21,20 @@ class TransportException extends EscPosException {
   TransportException(super.message, [super.cause]);
 }
 
+/// A write was cut off after the platform had already reconnected the
+/// session itself. The session is still open, but the cut-off data was not
+/// sent again, so retrying would stack on the platform's own retries and
+/// could print part of the job twice.
+class WriteInterruptedException extends TransportException {
+  WriteInterruptedException(super.message, [super.cause]);
+}
+
+/// A job stream call failed because the stream was aborted while the call
+/// waited on it. The stream is gone, but the session is still open.
+class JobAbortedException extends TransportException {
+  JobAbortedException(super.message, [super.cause]);
+}
+
 class TemplateRenderException extends EscPosException {
   TemplateRenderException(super.message, [super.cause]);
 }
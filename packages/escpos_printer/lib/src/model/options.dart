@@ -8,6 +8,54 @@ enum TextAlign { left, center, right }
 
 enum DrawerPin { pin2, pin5 }
 
+/// How a print obtains printer status once its bytes are written.
+enum StatusStrategy {
+  /// Read status before the print completes (one extra round trip).
+  wait,
+
+  /// Do not read status; [PrintResult.status] is unknown.
+  skip,
+
+  /// Report the last status the client read, without a round trip.
+  cached,
+
+  /// Complete the print right away with the cached status and read a fresh
+  /// one in the background, delivered by [PrintResult.deferredStatus] and
+  /// [EscPosClient.statusUpdates]. The next job does not wait for it.
+  deferred,
+}
+
+/// Scheduling class of work queued on an [EscPosClient] session.
+///
+/// More urgent work starts first. Work already running is interrupted only
+/// at safe points: between the jobs of a batch, and between the chunks of
+/// a streaming or bulk print for operations that print nothing (such as a
+/// drawer kick).
+enum PrintPriority {
+  /// Immediate, non-printing commands such as a cash drawer kick.
+  realtime,
+
+  /// Receipts a user is waiting for.
+  interactive,
+
+  /// Long reports and batches that can wait.
+  bulk,
+}
+
+/// How `ImageOp` rasters are sent to the printer.
+enum BitImageFormat {
+  /// `GS v 0` raster: the whole image in one command.
+  raster,
+
+  /// `ESC *` column format in 24-dot bands (mode 33), for printers that
+  /// predate `GS v 0`.
+  column24,
+
+  /// `ESC *` column format in 8-dot bands (mode 1), for impact printers
+  /// with an 8-pin head. Vertical density is a third of [column24].
+  column8,
+}
+
 /// ESC/POS tables that keep compatibility with Latin-1 bytes.
 ///
 /// The text encoder currently uses Latin-1 to generate bytes.
@@ -64,7 +112,19 @@ final class PrintOptions {
     this.paperWidthChars = 48,
     this.initializePrinter = true,
     this.codeTable = EscPosCodeTable.wcp1252,
-  }) : assert(paperWidthChars > 0);
+    this.streaming = false,
+    this.chunkSizeBytes = 4096,
+    this.maxInFlightChunks = 2,
+    this.priority = PrintPriority.interactive,
+    this.statusStrategy = StatusStrategy.wait,
+    this.imageFormat,
+    this.copies = 1,
+    this.cutBetweenCopies,
+    this.optimize = false,
+  }) : assert(paperWidthChars > 0),
+       assert(chunkSizeBytes > 0),
+       assert(maxInFlightChunks > 0),
+       assert(copies > 0);
 
   final int paperWidthChars;
   final bool initializePrinter;
@@ -73,4 +133,46 @@ final class PrintOptions {
   ///
   /// Use `null` to skip code table command emission.
   final EscPosCodeTable? codeTable;
+
+  /// Sends the job in chunks while it is still being encoded.
+  ///
+  /// The first chunk reaches the printer after its ops are encoded, instead
+  /// of after the whole document. A write failure mid-job leaves the chunks
+  /// already sent printed.
+  final bool streaming;
+
+  /// Target chunk size when [streaming]. Chunks break between ops, so a
+  /// single large op (e.g. an image) may exceed it.
+  final int chunkSizeBytes;
+
+  /// Chunks that may be queued or in transit before encoding waits for the
+  /// transport when [streaming].
+  final int maxInFlightChunks;
+
+  /// Queue class of the job. [PrintPriority.bulk] jobs are always sent in
+  /// [chunkSizeBytes] chunks so drawer kicks are not held up by them.
+  final PrintPriority priority;
+
+  final StatusStrategy statusStrategy;
+
+  /// Image command format. `null` uses the connected printer's
+  /// `PrinterProfile.imageFormat`, or [BitImageFormat.raster] without one.
+  final BitImageFormat? imageFormat;
+
+  /// Times the job is printed. It is encoded once and, on platforms that
+  /// retain jobs, sent to the platform once and replayed there. With more
+  /// than one copy the job is encoded whole, so [streaming] and bulk
+  /// chunking do not apply; more urgent work can run between copies.
+  /// `printBatch` ignores it.
+  final int copies;
+
+  /// Cut sent between copies, or `null` for none. Nothing is added after
+  /// the last copy.
+  final CutMode? cutBetweenCopies;
+
+  /// Runs the resolved ops through a peephole pass before encoding: feeds
+  /// and blank lines are merged, trailing spaces that print blank are
+  /// dropped, and same-style text is joined. The printout is unchanged;
+  /// `PrintResult.opBytesSaved` reports the bytes removed.
+  final bool optimize;
 }
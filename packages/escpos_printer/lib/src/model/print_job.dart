@@ -0,0 +1,18 @@
+import 'package:flutter/foundation.dart';
+
+import '../template/receipt_template.dart';
+import 'options.dart';
+
+/// One receipt of a [EscPosClient.printBatch] call.
+@immutable
+final class PrintJob {
+  const PrintJob({
+    required this.template,
+    this.variables = const <String, Object?>{},
+    this.renderOptions = const TemplateRenderOptions(),
+  });
+
+  final ReceiptTemplate template;
+  final Map<String, Object?> variables;
+  final TemplateRenderOptions renderOptions;
+}
@@ -0,0 +1,44 @@
+import 'package:flutter/foundation.dart';
+
+import 'options.dart';
+
+/// Built-in description of a known printer model, matched by USB vendor
+/// and product ID without talking to the printer.
+@immutable
+final class PrinterProfile {
+  const PrinterProfile({
+    required this.name,
+    required this.dotsPerLine,
+    required this.fontAColumns,
+    required this.fontBColumns,
+    required this.maxRasterWidth,
+    required this.hasCutter,
+    this.nvGraphicsKb = 0,
+    this.codePages = const <int>[],
+    this.imageFormat = BitImageFormat.raster,
+  });
+
+  final String name;
+  final int dotsPerLine;
+
+  /// Characters per line with Font A (12x24); a good
+  /// `PrintOptions.paperWidthChars`.
+  final int fontAColumns;
+
+  /// Characters per line with Font B (9x17).
+  final int fontBColumns;
+
+  /// Widest raster image in dots.
+  final int maxRasterWidth;
+  final bool hasCutter;
+
+  /// NV graphics memory in KiB; 0 when absent or unknown.
+  final int nvGraphicsKb;
+
+  /// `ESC t` code table numbers the model supports.
+  final List<int> codePages;
+
+  /// How the model prints images best; used when
+  /// `PrintOptions.imageFormat` is not set.
+  final BitImageFormat imageFormat;
+}
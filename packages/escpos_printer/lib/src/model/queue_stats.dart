@@ -0,0 +1,25 @@
+import 'package:flutter/foundation.dart';
+
+/// Queue counters for one [PrintPriority] class of [EscPosClient] work.
+@immutable
+final class QueueClassStats {
+  const QueueClassStats({
+    this.depth = 0,
+    this.started = 0,
+    this.totalWait = Duration.zero,
+    this.maxWait = Duration.zero,
+  });
+
+  /// Operations waiting to start.
+  final int depth;
+
+  /// Operations that have started since the client was created.
+  final int started;
+
+  /// Sum of the time started operations spent queued.
+  final Duration totalWait;
+  final Duration maxWait;
+
+  Duration get averageWait =>
+      started == 0 ? Duration.zero : totalWait ~/ started;
+}
@@ -8,9 +8,94 @@ final class PrintResult {
     required this.bytesSent,
     required this.duration,
     this.status = const PrinterStatus.unknown(),
+    this.styleBytesSaved = 0,
+    this.opBytesSaved = 0,
+    this.deferredStatus,
   });
 
   final int bytesSent;
   final Duration duration;
   final PrinterStatus status;
+
+  /// Fresh status read after the print, with [StatusStrategy.deferred].
+  final Future<PrinterStatus>? deferredStatus;
+
+  /// Formatting bytes the encoder skipped because the printer already had
+  /// the requested alignment/style.
+  final int styleBytesSaved;
+
+  /// Bytes removed by [PrintOptions.optimize] before encoding.
+  final int opBytesSaved;
+}
+
+/// Sent on `EscPosClient.copyProgress` after each copy of a job.
+@immutable
+final class PrintCopyProgress {
+  const PrintCopyProgress({
+    required this.copy,
+    required this.copies,
+    required this.bytesSent,
+  });
+
+  /// Copies written so far, from 1 to [copies].
+  final int copy;
+  final int copies;
+
+  /// Bytes written to the printer for this job so far.
+  final int bytesSent;
+}
+
+enum BatchJobState {
+  /// Every byte of the job reached the transport.
+  written,
+
+  /// The job was being written when the batch failed; it may be partially
+  /// printed.
+  failed,
+
+  /// The batch stopped before this job.
+  notSent,
+}
+
+@immutable
+final class BatchJobResult {
+  const BatchJobResult({
+    required this.offset,
+    required this.length,
+    required this.state,
+  });
+
+  /// Position of the job's first byte in the batch byte stream.
+  final int offset;
+  final int length;
+  final BatchJobState state;
+}
+
+@immutable
+final class BatchPrintResult {
+  const BatchPrintResult({
+    required this.jobs,
+    required this.bytesSent,
+    required this.duration,
+    this.status = const PrinterStatus.unknown(),
+    this.deferredStatus,
+    this.error,
+  });
+
+  /// One entry per submitted job, in submission order.
+  final List<BatchJobResult> jobs;
+  final int bytesSent;
+  final Duration duration;
+
+  /// Status read once, after the last write.
+  final PrinterStatus status;
+
+  /// Fresh status read after the batch, with [StatusStrategy.deferred].
+  final Future<PrinterStatus>? deferredStatus;
+
+  /// Error that stopped the batch after retries, if any.
+  final Object? error;
+
+  bool get isComplete =>
+      jobs.every((job) => job.state == BatchJobState.written);
 }
@@ -1,5 +1,7 @@
 import 'package:flutter/foundation.dart';
 
+import 'printer_profile.dart';
+
 enum TriState { yes, no, unknown }
 
 @immutable
@@ -29,6 +31,42 @@ final class PrinterStatus {
   final TriState drawerSignal;
 }
 
+/// Health of an open session's link, as seen by the platform.
+enum PrinterConnectionState {
+  connected,
+
+  /// Still open, but the printer is slow to acknowledge data, e.g. while
+  /// keepalive probes or retransmissions go unanswered.
+  degraded,
+
+  /// The link is gone (peer closed, cable pulled, keepalives timed out).
+  /// The next write reconnects; apps can also reconnect right away.
+  lost,
+}
+
+@immutable
+final class PrinterConnectionEvent {
+  const PrinterConnectionEvent(this.state, {this.reason});
+
+  final PrinterConnectionState state;
+
+  /// Platform description of why the state changed, if any.
+  final String? reason;
+}
+
+/// Where a session's [PrinterCapabilities] came from.
+enum CapabilitySource {
+  /// Defaults for the transport; the printer was not asked.
+  assumed,
+
+  /// Answered by the printer when this session opened.
+  probed,
+
+  /// Stored from an earlier probe of the same device. The platform may
+  /// re-probe in the background; see `EscPosClient.refreshCapabilities`.
+  cached,
+}
+
 @immutable
 final class PrinterCapabilities {
   const PrinterCapabilities({
@@ -39,6 +77,11 @@ final class PrinterCapabilities {
     this.supportsQrCode = true,
     this.supportsBarcode = true,
     this.supportsImage = true,
+    this.source = CapabilitySource.assumed,
+    this.model,
+    this.firmwareVersion,
+    this.manufacturer,
+    this.profile,
   });
 
   final bool supportsPartialCut;
@@ -48,4 +91,13 @@ final class PrinterCapabilities {
   final bool supportsQrCode;
   final bool supportsBarcode;
   final bool supportsImage;
+  final CapabilitySource source;
+
+  /// Identity reported by the printer (`GS I`), when it answered.
+  final String? model;
+  final String? firmwareVersion;
+  final String? manufacturer;
+
+  /// Built-in profile of the printer model, when the platform knows it.
+  final PrinterProfile? profile;
 }
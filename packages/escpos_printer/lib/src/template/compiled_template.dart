@@ -0,0 +1,95 @@
+import 'esctpl_parser.dart';
+import 'lru_cache.dart';
+import 'mustache_renderer.dart';
+import 'operations.dart';
+
+/// Template source compiled once and resolved on every print.
+///
+/// The Mustache tree is parsed at compile time. When the template is used as
+/// EscTpl, its skeleton lines outside sections are validated on first use,
+/// and templates without tags are parsed to ops only once. Lines inside
+/// sections are checked when they render.
+final class CompiledTemplate {
+  CompiledTemplate(this.mustache);
+
+  factory CompiledTemplate.compile(
+    String source, {
+    MustacheRenderer renderer = const MustacheRenderer(),
+  }) {
+    return CompiledTemplate(renderer.compile(source));
+  }
+
+  final CompiledMustacheTemplate mustache;
+
+  List<PrintOp>? _staticOps;
+  bool _skeletonValidated = false;
+
+  String get source => mustache.source;
+
+  String render(
+    Map<String, Object?> variables, {
+    bool strictMissingVariables = true,
+  }) {
+    return mustache.render(
+      variables,
+      strictMissingVariables: strictMissingVariables,
+    );
+  }
+
+  /// Renders the template and parses the result as EscTpl.
+  List<PrintOp> resolveOps(
+    Map<String, Object?> variables, {
+    EscTplParser parser = const EscTplParser(),
+    bool strictMissingVariables = true,
+  }) {
+    if (mustache.isStatic) {
+      return _staticOps ??= parser.parse(mustache.source);
+    }
+
+    if (!_skeletonValidated) {
+      _validateSkeleton(parser);
+      _skeletonValidated = true;
+    }
+
+    return parser.parse(
+      render(variables, strictMissingVariables: strictMissingVariables),
+    );
+  }
+
+  void _validateSkeleton(EscTplParser parser) {
+    for (final segment in mustache.textSegments) {
+      final lines = segment.split('\n');
+      // The first and last pieces of a segment may be completed by a tag at
+      // render time, so only lines fully inside the segment are checked.
+      for (var i = 1; i < lines.length - 1; i++) {
+        parser.validateLine(lines[i]);
+      }
+    }
+  }
+}
+
+/// Bounded LRU of [CompiledTemplate]s keyed by template source.
+final class TemplateCache {
+  TemplateCache({
+    this.capacity = 32,
+    MustacheRenderer renderer = const MustacheRenderer(),
+  }) : assert(capacity > 0),
+       _renderer = renderer,
+       _entries = LruCache<String, CompiledTemplate>(capacity);
+
+  final int capacity;
+  final MustacheRenderer _renderer;
+  final LruCache<String, CompiledTemplate> _entries;
+
+  int get length => _entries.length;
+
+  /// Returns the compiled form of [source], compiling it on a miss.
+  CompiledTemplate lookup(String source) {
+    return _entries.putIfAbsent(
+      source,
+      () => CompiledTemplate.compile(source, renderer: _renderer),
+    );
+  }
+
+  void clear() => _entries.clear();
+}
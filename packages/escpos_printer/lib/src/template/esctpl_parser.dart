@@ -3,14 +3,42 @@ import 'dart:typed_data';
 
 import '../model/exceptions.dart';
 import '../model/options.dart';
+import 'lru_cache.dart';
 import 'operations.dart';
 
 final class EscTplParser {
   const EscTplParser();
 
+  static const _knownCommands = <String>{
+    'row',
+    'endrow',
+    'col',
+    'text',
+    'qrcode',
+    'barcode',
+    'image',
+    'feed',
+    'cut',
+    'drawer',
+  };
+
+  // Ops are immutable, so a line that was already parsed (template skeleton
+  // lines repeat on every print) resolves to the same instance. Lines longer
+  // than _maxCachedLineLength, such as inline `@image` data, are parsed
+  // every time instead of being pinned by the cache. Documents with more
+  // lines than the caches hold bypass them: an LRU cycled by one pass only
+  // evicts, and would drop the entries shorter documents reuse.
+  static const _cacheCapacity = 256;
+  static const _maxCachedLineLength = 512;
+  static final LruCache<String, PrintOp> _opCache =
+      LruCache<String, PrintOp>(_cacheCapacity);
+  static final LruCache<String, RowColumnSpec> _columnCache =
+      LruCache<String, RowColumnSpec>(_cacheCapacity);
+
   List<PrintOp> parse(String source) {
     final lines = const LineSplitter().convert(source);
     final ops = <PrintOp>[];
+    final useCache = lines.length <= _cacheCapacity;
 
     var index = 0;
     while (index < lines.length) {
@@ -28,173 +56,206 @@ final class EscTplParser {
         );
       }
 
-      final command = _parseCommandLine(line);
-
-      switch (command.name) {
-        case 'row':
-          final rowColumns = <RowColumnSpec>[];
-          var foundEnd = false;
-
-          while (index < lines.length) {
-            final candidate = lines[index].trim();
-            index++;
-
-            if (candidate.isEmpty || candidate.startsWith('#')) {
-              continue;
-            }
+      final cacheable = useCache && line.length <= _maxCachedLineLength;
+      final cached = cacheable ? _opCache[line] : null;
+      if (cached != null) {
+        ops.add(cached);
+        continue;
+      }
 
-            if (candidate == '@endrow') {
-              foundEnd = true;
-              break;
-            }
+      final command = _parseCommandLine(line);
+      if (command.name == 'row') {
+        final rowColumns = <RowColumnSpec>[];
+        var foundEnd = false;
 
-            if (!candidate.startsWith('@col')) {
-              throw TemplateParseException(
-                'Only @col and @endrow are allowed inside @row. Received: "$candidate".',
-              );
-            }
+        while (index < lines.length) {
+          final candidate = lines[index].trim();
+          index++;
 
-            final colCommand = _parseCommandLine(candidate);
-            rowColumns.add(_parseColumn(colCommand));
+          if (candidate.isEmpty || candidate.startsWith('#')) {
+            continue;
           }
 
-          if (!foundEnd) {
-            throw TemplateParseException('@row block without @endrow closing.');
+          if (candidate == '@endrow') {
+            foundEnd = true;
+            break;
           }
-          if (rowColumns.isEmpty) {
-            throw TemplateValidationException(
-              '@row requires at least one @col column.',
+
+          if (!candidate.startsWith('@col')) {
+            throw TemplateParseException(
+              'Only @col and @endrow are allowed inside @row. Received: "$candidate".',
             );
           }
 
-          ops.add(RowOp(List<RowColumnSpec>.unmodifiable(rowColumns)));
-
-        case 'endrow':
-          throw TemplateParseException(
-            '@endrow without a matching @row block.',
+          rowColumns.add(
+            useCache && candidate.length <= _maxCachedLineLength
+                ? _columnCache.putIfAbsent(
+                    candidate,
+                    () => _parseColumn(_parseCommandLine(candidate)),
+                  )
+                : _parseColumn(_parseCommandLine(candidate)),
           );
+        }
 
-        case 'text':
-          final text = command.content.isNotEmpty
-              ? command.content
-              : (command.attrs['text'] ?? '');
-          ops.add(TextOp(text, style: _parseTextStyle(command.attrs)));
-
-        case 'qrcode':
-          final data = _requireContent(command, label: 'qrcode');
-          ops.add(
-            QrCodeOp(
-              data,
-              size: _parseIntAttr(
-                command,
-                'size',
-                defaultValue: 6,
-                min: 1,
-                max: 16,
-              ),
-              align: _parseAlign(command.attrs['align']),
-            ),
+        if (!foundEnd) {
+          throw TemplateParseException('@row block without @endrow closing.');
+        }
+        if (rowColumns.isEmpty) {
+          throw TemplateValidationException(
+            '@row requires at least one @col column.',
           );
+        }
 
-        case 'barcode':
-          final data = _requireContent(command, label: 'barcode');
-          ops.add(
-            BarcodeOp(
-              data,
-              type: _parseBarcodeType(command.attrs['type']),
-              height: _parseIntAttr(
-                command,
-                'height',
-                defaultValue: 80,
-                min: 1,
-                max: 255,
-              ),
-              align: _parseAlign(command.attrs['align']),
-            ),
-          );
+        ops.add(RowOp(List<RowColumnSpec>.unmodifiable(rowColumns)));
+        continue;
+      }
 
-        case 'image':
-          final base64Data = _requireContent(command, label: 'image');
-          final widthBytes = _parseIntAttr(command, 'widthBytes', min: 1);
-          final heightDots = _parseIntAttr(command, 'heightDots', min: 1);
-          final mode = _parseIntAttr(
+      final op = _parseCommand(command);
+      if (cacheable) {
+        _opCache[line] = op;
+      }
+      ops.add(op);
+    }
+
+    return List<PrintOp>.unmodifiable(ops);
+  }
+
+  /// Checks that [line] is a well-formed command with a known name.
+  ///
+  /// Lets compiled templates reject a broken skeleton before any variables
+  /// are bound.
+  void validateLine(String line) {
+    final trimmed = line.trim();
+    if (trimmed.isEmpty || trimmed.startsWith('#')) {
+      return;
+    }
+    if (!trimmed.startsWith('@')) {
+      throw TemplateParseException(
+        'Invalid line: "$trimmed". Expected a command starting with @.',
+      );
+    }
+
+    final command = _parseCommandLine(trimmed);
+    if (!_knownCommands.contains(command.name)) {
+      throw TemplateParseException('Unsupported command: @${command.name}');
+    }
+  }
+
+  PrintOp _parseCommand(_Command command) {
+    switch (command.name) {
+      case 'endrow':
+        throw TemplateParseException('@endrow without a matching @row block.');
+
+      case 'text':
+        final text = command.content.isNotEmpty
+            ? command.content
+            : (command.attrs['text'] ?? '');
+        return TextOp(text, style: _parseTextStyle(command.attrs));
+
+      case 'qrcode':
+        final data = _requireContent(command, label: 'qrcode');
+        return QrCodeOp(
+          data,
+          size: _parseIntAttr(
             command,
-            'mode',
-            defaultValue: 0,
-            min: 0,
-            max: 3,
-          );
-          final rasterData = _decodeBase64(base64Data);
-          ops.add(
-            ImageOp(
-              rasterData: rasterData,
-              widthBytes: widthBytes,
-              heightDots: heightDots,
-              mode: mode,
-              align: _parseAlign(command.attrs['align']),
-            ),
-          );
+            'size',
+            defaultValue: 6,
+            min: 1,
+            max: 16,
+          ),
+          align: _parseAlign(command.attrs['align']),
+        );
 
-        case 'feed':
-          final linesToFeed = _parseIntAttr(
+      case 'barcode':
+        final data = _requireContent(command, label: 'barcode');
+        return BarcodeOp(
+          data,
+          type: _parseBarcodeType(command.attrs['type']),
+          height: _parseIntAttr(
             command,
-            'lines',
-            defaultValue: command.content.isEmpty
-                ? 1
-                : _parseInt(command.content, name: 'feed content'),
+            'height',
+            defaultValue: 80,
+            min: 1,
+            max: 255,
+          ),
+          align: _parseAlign(command.attrs['align']),
+        );
+
+      case 'image':
+        final base64Data = _requireContent(command, label: 'image');
+        final widthBytes = _parseIntAttr(command, 'widthBytes', min: 1);
+        final heightDots = _parseIntAttr(command, 'heightDots', min: 1);
+        final mode = _parseIntAttr(
+          command,
+          'mode',
+          defaultValue: 0,
+          min: 0,
+          max: 3,
+        );
+        final rasterData = _decodeBase64(base64Data);
+        return ImageOp(
+          rasterData: rasterData,
+          widthBytes: widthBytes,
+          heightDots: heightDots,
+          mode: mode,
+          align: _parseAlign(command.attrs['align']),
+        );
+
+      case 'feed':
+        final linesToFeed = _parseIntAttr(
+          command,
+          'lines',
+          defaultValue: command.content.isEmpty
+              ? 1
+              : _parseInt(command.content, name: 'feed content'),
+          min: 0,
+          max: 255,
+        );
+        return FeedOp(linesToFeed);
+
+      case 'cut':
+        final modeRaw = (command.attrs['mode'] ?? 'partial')
+            .trim()
+            .toLowerCase();
+        final mode = switch (modeRaw) {
+          'partial' => CutMode.partial,
+          'full' => CutMode.full,
+          _ => throw TemplateValidationException(
+            'Invalid cut mode: $modeRaw. Use partial or full.',
+          ),
+        };
+        return CutOp(mode);
+
+      case 'drawer':
+        final pinRaw = (command.attrs['pin'] ?? '2').trim();
+        final pin = switch (pinRaw) {
+          '2' => DrawerPin.pin2,
+          '5' => DrawerPin.pin5,
+          _ => throw TemplateValidationException(
+            'Invalid drawer pin: $pinRaw. Use 2 or 5.',
+          ),
+        };
+        return DrawerKickOp(
+          pin: pin,
+          onMs: _parseIntAttr(
+            command,
+            'on',
+            defaultValue: 120,
             min: 0,
             max: 255,
-          );
-          ops.add(FeedOp(linesToFeed));
-
-        case 'cut':
-          final modeRaw = (command.attrs['mode'] ?? 'partial')
-              .trim()
-              .toLowerCase();
-          final mode = switch (modeRaw) {
-            'partial' => CutMode.partial,
-            'full' => CutMode.full,
-            _ => throw TemplateValidationException(
-              'Invalid cut mode: $modeRaw. Use partial or full.',
-            ),
-          };
-          ops.add(CutOp(mode));
-
-        case 'drawer':
-          final pinRaw = (command.attrs['pin'] ?? '2').trim();
-          final pin = switch (pinRaw) {
-            '2' => DrawerPin.pin2,
-            '5' => DrawerPin.pin5,
-            _ => throw TemplateValidationException(
-              'Invalid drawer pin: $pinRaw. Use 2 or 5.',
-            ),
-          };
-          ops.add(
-            DrawerKickOp(
-              pin: pin,
-              onMs: _parseIntAttr(
-                command,
-                'on',
-                defaultValue: 120,
-                min: 0,
-                max: 255,
-              ),
-              offMs: _parseIntAttr(
-                command,
-                'off',
-                defaultValue: 240,
-                min: 0,
-                max: 255,
-              ),
-            ),
-          );
+          ),
+          offMs: _parseIntAttr(
+            command,
+            'off',
+            defaultValue: 240,
+            min: 0,
+            max: 255,
+          ),
+        );
 
-        default:
-          throw TemplateParseException('Unsupported command: @${command.name}');
-      }
+      default:
+        throw TemplateParseException('Unsupported command: @${command.name}');
     }
-
-    return List<PrintOp>.unmodifiable(ops);
   }
 
   RowColumnSpec _parseColumn(_Command command) {
@@ -0,0 +1,42 @@
+import 'dart:collection';
+
+/// Bounded least-recently-used cache.
+///
+/// Backed by a [LinkedHashMap], whose insertion order doubles as recency
+/// order: hits are moved to the end and evictions take the first key.
+final class LruCache<K, V> {
+  LruCache(this.capacity) : assert(capacity > 0);
+
+  final int capacity;
+  final LinkedHashMap<K, V> _entries = LinkedHashMap<K, V>();
+
+  int get length => _entries.length;
+
+  V? operator [](K key) {
+    final value = _entries.remove(key);
+    if (value != null) {
+      _entries[key] = value;
+    }
+    return value;
+  }
+
+  void operator []=(K key, V value) {
+    _entries.remove(key);
+    _entries[key] = value;
+    if (_entries.length > capacity) {
+      _entries.remove(_entries.keys.first);
+    }
+  }
+
+  V putIfAbsent(K key, V Function() ifAbsent) {
+    final cached = this[key];
+    if (cached != null) {
+      return cached;
+    }
+    final value = ifAbsent();
+    this[key] = value;
+    return value;
+  }
+
+  void clear() => _entries.clear();
+}
@@ -8,67 +8,20 @@ final class MustacheRenderer {
     Map<String, Object?> variables, {
     bool strictMissingVariables = true,
   }) {
-    final parseResult = _parseSection(template, 0, null);
-    final context = _RenderContext(<Object?>[
-      variables,
-    ], strictMissingVariables);
-    return _renderNodes(parseResult.nodes, context);
+    return compile(
+      template,
+    ).render(variables, strictMissingVariables: strictMissingVariables);
   }
 
-  String _renderNodes(List<_TemplateNode> nodes, _RenderContext context) {
-    final out = StringBuffer();
-    for (final node in nodes) {
-      switch (node) {
-        case _TextNode(:final value):
-          out.write(value);
-        case _VariableNode(:final path):
-          final resolved = context.resolve(path);
-          if (!resolved.found) {
-            if (context.strictMissingVariables) {
-              throw TemplateRenderException('Missing required variable: $path');
-            }
-            continue;
-          }
-          if (resolved.value != null) {
-            out.write(resolved.value);
-          }
-        case _EachNode(:final path, :final children):
-          final resolved = context.resolve(path);
-          if (!resolved.found) {
-            if (context.strictMissingVariables) {
-              throw TemplateRenderException(
-                'Missing required collection in #each: $path',
-              );
-            }
-            continue;
-          }
-
-          final iterable = resolved.value;
-          if (iterable is! Iterable<Object?>) {
-            throw TemplateValidationException(
-              '#each block expects Iterable at "$path".',
-            );
-          }
-
-          for (final item in iterable) {
-            out.write(_renderNodes(children, context.push(item)));
-          }
-        case _IfNode(:final path, :final children):
-          final resolved = context.resolve(path);
-          if (!resolved.found) {
-            if (context.strictMissingVariables) {
-              throw TemplateRenderException(
-                'Missing required variable in #if: $path',
-              );
-            }
-            continue;
-          }
-          if (_truthy(resolved.value)) {
-            out.write(_renderNodes(children, context));
-          }
-      }
-    }
-    return out.toString();
+  /// Parses [template] once so it can be rendered many times.
+  ///
+  /// Parse errors surface here rather than on the first render.
+  CompiledMustacheTemplate compile(String template) {
+    final parseResult = _parseSection(template, 0, null);
+    return CompiledMustacheTemplate._(
+      template,
+      List<_TemplateNode>.unmodifiable(parseResult.nodes),
+    );
   }
 
   _SectionParseResult _parseSection(
@@ -115,7 +68,7 @@ final class MustacheRenderer {
           );
         }
         final nested = _parseSection(source, close + 2, 'each');
-        nodes.add(_EachNode(path, nested.nodes));
+        nodes.add(_EachNode(_Path(path), nested.nodes));
         cursor = nested.nextIndex;
         continue;
       }
@@ -128,7 +81,7 @@ final class MustacheRenderer {
           );
         }
         final nested = _parseSection(source, close + 2, 'if');
-        nodes.add(_IfNode(path, nested.nodes));
+        nodes.add(_IfNode(_Path(path), nested.nodes));
         cursor = nested.nextIndex;
         continue;
       }
@@ -148,7 +101,7 @@ final class MustacheRenderer {
         return _SectionParseResult(nodes, close + 2);
       }
 
-      nodes.add(_VariableNode(rawTag));
+      nodes.add(_VariableNode(_Path(rawTag)));
       cursor = close + 2;
     }
 
@@ -158,8 +111,102 @@ final class MustacheRenderer {
 
     return _SectionParseResult(nodes, cursor);
   }
+}
+
+/// Mustache template parsed into an immutable node tree.
+///
+/// Rendering only resolves variables against the tree; no source scanning
+/// happens per call. Instances are safe to cache and share.
+final class CompiledMustacheTemplate {
+  CompiledMustacheTemplate._(this.source, this._nodes)
+    : isStatic = _nodes.every((node) => node is _TextNode);
+
+  final String source;
+  final List<_TemplateNode> _nodes;
+
+  /// Whether the template has no tags, so every render yields [source].
+  final bool isStatic;
+
+  /// Literal text segments outside sections, in source order.
+  ///
+  /// Text inside `#each`/`#if` blocks is left out, since whether and
+  /// how often it renders depends on the variables.
+  Iterable<String> get textSegments => _nodes
+      .whereType<_TextNode>()
+      .map((node) => node.value);
+
+  String render(
+    Map<String, Object?> variables, {
+    bool strictMissingVariables = true,
+  }) {
+    final out = StringBuffer();
+    _renderNodes(
+      out,
+      _nodes,
+      _RenderContext(variables, null, strictMissingVariables),
+    );
+    return out.toString();
+  }
+
+  void _renderNodes(
+    StringBuffer out,
+    List<_TemplateNode> nodes,
+    _RenderContext context,
+  ) {
+    for (final node in nodes) {
+      switch (node) {
+        case _TextNode(:final value):
+          out.write(value);
+        case _VariableNode(:final path):
+          final resolved = context.resolve(path);
+          if (!resolved.found) {
+            if (context.strictMissingVariables) {
+              throw TemplateRenderException('Missing required variable: $path');
+            }
+            continue;
+          }
+          if (resolved.value != null) {
+            out.write(resolved.value);
+          }
+        case _EachNode(:final path, :final children):
+          final resolved = context.resolve(path);
+          if (!resolved.found) {
+            if (context.strictMissingVariables) {
+              throw TemplateRenderException(
+                'Missing required collection in #each: $path',
+              );
+            }
+            continue;
+          }
+
+          final iterable = resolved.value;
+          if (iterable is! Iterable<Object?>) {
+            throw TemplateValidationException(
+              '#each block expects Iterable at "$path".',
+            );
+          }
+
+          for (final item in iterable) {
+            _renderNodes(out, children, context.push(item));
+          }
+        case _IfNode(:final path, :final children):
+          final resolved = context.resolve(path);
+          if (!resolved.found) {
+            if (context.strictMissingVariables) {
+              throw TemplateRenderException(
+                'Missing required variable in #if: $path',
+              );
+            }
+            continue;
+          }
+          if (_truthy(resolved.value)) {
+            _renderNodes(out, children, context);
+          }
+      }
+    }
+  }
 
-  bool _truthy(Object? value) {
+  static bool _truthy(Object? value) {
     if (value == null) {
       return false;
     }
@@ -183,48 +230,39 @@ final class MustacheRenderer {
 }
 
 final class _RenderContext {
-  const _RenderContext(this.scopes, this.strictMissingVariables);
+  const _RenderContext(this.scope, this.parent, this.strictMissingVariables);
 
-  final List<Object?> scopes;
+  final Object? scope;
+  final _RenderContext? parent;
   final bool strictMissingVariables;
 
   _RenderContext push(Object? scope) {
-    return _RenderContext(<Object?>[scope, ...scopes], strictMissingVariables);
+    return _RenderContext(scope, this, strictMissingVariables);
   }
 
-  _ResolveResult resolve(String path) {
-    for (final scope in scopes) {
-      final fromScope = _resolvePathInScope(scope, path);
+  _ResolveResult resolve(_Path path) {
+    for (_RenderContext? context = this; context != null;) {
+      final fromScope = _resolvePathInScope(context.scope, path);
       if (fromScope.found) {
         return fromScope;
       }
+      context = context.parent;
     }
     return const _ResolveResult.notFound();
   }
 
-  _ResolveResult _resolvePathInScope(Object? scope, String path) {
-    if (path == 'this') {
+  _ResolveResult _resolvePathInScope(Object? scope, _Path path) {
+    if (path.isThis) {
       return _ResolveResult.found(scope);
     }
 
-    final segments = path
-        .split('.')
-        .map((segment) => segment.trim())
-        .where((segment) => segment.isNotEmpty)
-        .toList(growable: false);
-
+    final segments = path.segments;
     if (segments.isEmpty) {
       return const _ResolveResult.notFound();
     }
 
-    Object? current;
-    var index = 0;
-    if (segments.first == 'this') {
-      current = scope;
-      index = 1;
-    } else {
-      current = scope;
-    }
+    Object? current = scope;
+    final index = segments.first == 'this' ? 1 : 0;
 
     for (var i = index; i < segments.length; i++) {
       final segment = segments[i];
@@ -248,19 +286,29 @@ final class _RenderContext {
       return const _ResolveResult.notFound();
     }
 
-    if (segments.first != 'this' &&
-        segments.length == 1 &&
-        scope is Map<Object?, Object?>) {
-      if (!scope.containsKey(segments.first)) {
-        return const _ResolveResult.notFound();
-      }
-      return _ResolveResult.found(scope[segments.first]);
-    }
-
     return _ResolveResult.found(current);
   }
 }
 
+/// Variable path split into segments at compile time.
+final class _Path {
+  _Path(this.raw)
+    : segments = List<String>.unmodifiable(
+        raw
+            .split('.')
+            .map((segment) => segment.trim())
+            .where((segment) => segment.isNotEmpty),
+      );
+
+  final String raw;
+  final List<String> segments;
+
+  bool get isThis => raw == 'this';
+
+  @override
+  String toString() => raw;
+}
+
 sealed class _TemplateNode {
   const _TemplateNode();
 }
@@ -274,20 +322,20 @@ final class _TextNode extends _TemplateNode {
 final class _VariableNode extends _TemplateNode {
   const _VariableNode(this.path);
 
-  final String path;
+  final _Path path;
 }
 
 final class _EachNode extends _TemplateNode {
   const _EachNode(this.path, this.children);
 
-  final String path;
+  final _Path path;
   final List<_TemplateNode> children;
 }
 
 final class _IfNode extends _TemplateNode {
   const _IfNode(this.path, this.children);
 
-  final String path;
+  final _Path path;
   final List<_TemplateNode> children;
 }
 
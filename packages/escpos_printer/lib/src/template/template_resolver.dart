@@ -0,0 +1,91 @@
+import '../model/options.dart';
+import 'compiled_template.dart';
+import 'esctpl_parser.dart';
+import 'operations.dart';
+import 'receipt_template.dart';
+
+/// Turns a [ReceiptTemplate] and its variables into printable ops.
+///
+/// Mustache text is rendered and EscTpl blocks are parsed through
+/// [templateCache], so repeated templates are compiled only once.
+final class TemplateResolver {
+  TemplateResolver({
+    required this.templateCache,
+    this.parser = const EscTplParser(),
+  });
+
+  final TemplateCache templateCache;
+  final EscTplParser parser;
+
+  List<PrintOp> resolve(
+    ReceiptTemplate template,
+    Map<String, Object?> variables,
+    TemplateRenderOptions renderOptions,
+  ) {
+    return switch (template) {
+      DslReceiptTemplate(:final ops) => _resolveDslOps(
+        ops,
+        variables,
+        renderOptions,
+      ),
+      StringReceiptTemplate(:final template) => _resolveStringTemplate(
+        template,
+        variables,
+        renderOptions,
+      ),
+    };
+  }
+
+  List<PrintOp> _resolveDslOps(
+    List<PrintOp> rawOps,
+    Map<String, Object?> variables,
+    TemplateRenderOptions renderOptions,
+  ) {
+    final result = <PrintOp>[];
+
+    for (final op in rawOps) {
+      switch (op) {
+        case TextTemplateOp(:final template, :final vars, :final style):
+          final mergedVars = <String, Object?>{...variables, ...vars};
+          final rendered = templateCache
+              .lookup(template)
+              .render(
+                mergedVars,
+                strictMissingVariables: renderOptions.strictMissingVariables,
+              );
+          result.add(TextOp(rendered, style: style));
+
+        case TemplateBlockOp(:final template, :final vars):
+          final mergedVars = <String, Object?>{...variables, ...vars};
+          result.addAll(
+            templateCache
+                .lookup(template)
+                .resolveOps(
+                  mergedVars,
+                  parser: parser,
+                  strictMissingVariables: renderOptions.strictMissingVariables,
+                ),
+          );
+
+        default:
+          result.add(op);
+      }
+    }
+
+    return List<PrintOp>.unmodifiable(result);
+  }
+
+  List<PrintOp> _resolveStringTemplate(
+    String source,
+    Map<String, Object?> variables,
+    TemplateRenderOptions renderOptions,
+  ) {
+    return templateCache
+        .lookup(source)
+        .resolveOps(
+          variables,
+          parser: parser,
+          strictMissingVariables: renderOptions.strictMissingVariables,
+        );
+  }
+}
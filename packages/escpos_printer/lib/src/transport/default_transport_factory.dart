@@ -2,18 +2,29 @@ import '../model/endpoints.dart';
 import 'native_transport_bridge.dart';
 import 'platform_bluetooth_transport.dart';
 import 'platform_usb_transport.dart';
+import 'platform_wifi_transport.dart';
 import 'transport.dart';
 import 'wifi_socket_transport.dart';
 
 final class DefaultTransportFactory implements TransportFactory {
-  DefaultTransportFactory({NativeTransportBridge? nativeBridge})
-    : _nativeBridge = nativeBridge ?? NativeTransportBridge();
+  DefaultTransportFactory({
+    NativeTransportBridge? nativeBridge,
+    this.nativeWifi = false,
+  }) : _nativeBridge = nativeBridge ?? NativeTransportBridge();
 
   final NativeTransportBridge _nativeBridge;
 
+  /// Sends Wi-Fi jobs through the native plugin instead of a Dart socket,
+  /// e.g. to use [NativeIoBackend.ioUring] on Linux.
+  final bool nativeWifi;
+
   @override
   Future<PrinterTransport> create(PrinterEndpoint endpoint) async {
     return switch (endpoint) {
+      WifiEndpoint endpoint when nativeWifi => PlatformWifiTransport(
+        endpoint,
+        bridge: _nativeBridge,
+      ),
       WifiEndpoint endpoint => WifiSocketTransport(endpoint),
       UsbEndpoint endpoint => PlatformUsbTransport(
         endpoint,
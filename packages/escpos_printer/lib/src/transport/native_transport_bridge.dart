@@ -1,29 +1,91 @@
+import 'dart:async';
 import 'dart:typed_data';
 
 import 'package:escpos_printer_platform_interface/escpos_printer_platform_interface.dart';
+import 'package:flutter/services.dart';
 
 import '../model/discovery.dart';
 import '../model/endpoints.dart';
 import '../model/exceptions.dart';
+import '../model/options.dart';
+import '../model/printer_profile.dart';
+import '../model/result.dart';
 import '../model/status.dart';
 
+/// How the native plugin writes to TCP and RFCOMM sockets.
+enum NativeIoBackend {
+  /// Blocking `send()` on the platform thread.
+  standard,
+
+  /// Linux only: one shared io_uring that batches writes from all sessions
+  /// and sends large chunks with zero-copy. Falls back to [standard] when
+  /// the kernel does not support it.
+  ioUring,
+}
+
 final class NativeConnectionSession {
   const NativeConnectionSession({
     required this.sessionId,
     required this.capabilities,
+    this.ioBackend = NativeIoBackend.standard,
   });
 
   final String sessionId;
   final PrinterCapabilities capabilities;
+
+  /// Backend the platform actually uses for this session.
+  final NativeIoBackend ioBackend;
+}
+
+/// Outcome of [NativeTransportBridge.writeBatch].
+final class NativeBatchResult {
+  const NativeBatchResult(this.jobs, {this.reconnected = false});
+
+  /// One entry per job, in order.
+  final List<BatchJobResult> jobs;
+
+  /// Whether the platform reconnected the session during the batch and
+  /// already resumed it. The session stays open after a failed job then.
+  final bool reconnected;
 }
 
 /// Bridge for native transport operations (USB/Bluetooth) using a typed contract.
 class NativeTransportBridge {
-  NativeTransportBridge({NativeTransportApi? api})
-    : _api = api ?? NativeTransportApi();
+  /// [directWrites] sends writes through the platform's
+  /// [NativeDirectWriter] when it has one, e.g. `dart:ffi` on Linux. It is
+  /// ignored when [api] is given.
+  NativeTransportBridge({
+    NativeTransportApi? api,
+    this.ioBackend = NativeIoBackend.standard,
+    bool directWrites = false,
+  }) : _api = api ?? NativeTransportApi(useDirectWriter: directWrites);
 
   final NativeTransportApi _api;
 
+  /// Socket write backend requested for Wi-Fi and Bluetooth sessions.
+  final NativeIoBackend ioBackend;
+
+  int _discoveryCounter = 0;
+
+  /// Link state changes of [sessionId]. Empty on platforms without
+  /// connection events.
+  Stream<PrinterConnectionEvent> connectionEvents(String sessionId) {
+    return _api.connectionEvents
+        .where((event) => event.sessionId == sessionId)
+        .map((event) {
+          return PrinterConnectionEvent(
+            PrinterConnectionState.values.firstWhere(
+              (state) => state.name == event.state,
+              orElse: () => PrinterConnectionState.connected,
+            ),
+            reason: event.reason,
+          );
+        })
+        .handleError((Object _) {}, test: (error) {
+          return error is MissingPluginException;
+        });
+  }
+
   Future<NativeConnectionSession> openConnection(
     PrinterEndpoint endpoint,
   ) async {
@@ -32,6 +94,9 @@ class NativeTransportBridge {
       return NativeConnectionSession(
         sessionId: response.sessionId,
         capabilities: _mapCapabilities(response.capabilities),
+        ioBackend: response.ioBackend == NativeIoBackend.ioUring.name
+            ? NativeIoBackend.ioUring
+            : NativeIoBackend.standard,
       );
     } catch (error) {
       throw TransportException('Failed to open native connection.', error);
@@ -40,14 +105,203 @@ class NativeTransportBridge {
 
   Future<void> write(String sessionId, List<int> bytes) async {
     try {
+      // Both the channel codec and a direct writer copy the bytes before
+      // returning, so a Uint8List is passed as is.
       await _api.write(
-        WritePayload(sessionId: sessionId, bytes: Uint8List.fromList(bytes)),
+        WritePayload(
+          sessionId: sessionId,
+          bytes: bytes is Uint8List ? bytes : Uint8List.fromList(bytes),
+        ),
       );
+    } on PlatformException catch (error) {
+      throw _writeError('Failed to write to native transport.', error);
     } catch (error) {
       throw TransportException('Failed to write to native transport.', error);
     }
   }
 
+  /// Writes [jobs] back to back in a single native call.
+  ///
+  /// Platforms without `writeBatch` get one concatenated `write`, which
+  /// succeeds or fails as a whole.
+  Future<NativeBatchResult> writeBatch(
+    String sessionId,
+    List<Uint8List> jobs,
+  ) async {
+    final builder = BytesBuilder(copy: false);
+    final lengths = <int>[];
+    for (final job in jobs) {
+      builder.add(job);
+      lengths.add(job.length);
+    }
+    final bytes = builder.takeBytes();
+
+    final WriteBatchResponse response;
+    try {
+      response = await _api.writeBatch(
+        WriteBatchPayload(
+          sessionId: sessionId,
+          bytes: bytes,
+          jobLengths: lengths,
+        ),
+      );
+    } on MissingPluginException {
+      await write(sessionId, bytes);
+      return NativeBatchResult(_writtenJobs(lengths));
+    } catch (error) {
+      throw TransportException(
+        'Failed to write batch to native transport.',
+        error,
+      );
+    }
+
+    if (response.jobs.length != jobs.length) {
+      throw TransportException(
+        'Native writeBatch reported ${response.jobs.length} jobs, '
+        'expected ${jobs.length}.',
+      );
+    }
+    return NativeBatchResult(
+      List<BatchJobResult>.unmodifiable(
+        response.jobs.map((job) {
+          return BatchJobResult(
+            offset: job.offset,
+            length: job.length,
+            state: switch (job.status) {
+              'written' => BatchJobState.written,
+              'failed' => BatchJobState.failed,
+              _ => BatchJobState.notSent,
+            },
+          );
+        }),
+      ),
+      reconnected: response.reconnected,
+    );
+  }
+
+  /// Keeps [job] on the platform for repeated writes. Null when the
+  /// platform cannot retain jobs.
+  Future<String?> retainJob(
+    String sessionId,
+    Uint8List job, {
+    Uint8List? separator,
+  }) async {
+    try {
+      return await _api.retainJob(
+        RetainJobPayload(
+          sessionId: sessionId,
+          bytes: job,
+          separator: separator,
+        ),
+      );
+    } on MissingPluginException {
+      return null;
+    } catch (error) {
+      throw TransportException('Failed to retain job on native side.', error);
+    }
+  }
+
+  Future<void> writeRetainedJob(
+    String sessionId,
+    String jobId, {
+    bool withSeparator = false,
+  }) async {
+    try {
+      await _api.writeRetainedJob(
+        RetainedJobPayload(
+          sessionId: sessionId,
+          jobId: jobId,
+          withSeparator: withSeparator,
+        ),
+      );
+    } on PlatformException catch (error) {
+      throw _writeError('Failed to write retained job.', error);
+    } catch (error) {
+      throw TransportException('Failed to write retained job.', error);
+    }
+  }
+
+  Future<void> releaseJob(String sessionId, String jobId) async {
+    try {
+      await _api.releaseJob(
+        RetainedJobPayload(sessionId: sessionId, jobId: jobId),
+      );
+    } catch (error) {
+      throw TransportException('Failed to release retained job.', error);
+    }
+  }
+
+  /// Opens a job stream on [sessionId]. Null when the platform has none.
+  Future<String?> beginJob(String sessionId) async {
+    try {
+      return await _api.beginJob(SessionPayload(sessionId));
+    } on MissingPluginException {
+      return null;
+    } catch (error) {
+      throw TransportException('Failed to begin native job stream.', error);
+    }
+  }
+
+  Future<void> appendChunk(
+    String sessionId,
+    String jobId,
+    Uint8List chunk,
+  ) async {
+    try {
+      await _api.appendChunk(
+        AppendChunkPayload(sessionId: sessionId, jobId: jobId, bytes: chunk),
+      );
+    } on PlatformException catch (error) {
+      throw _jobError('Failed to append to native job stream.', error);
+    } catch (error) {
+      throw TransportException('Failed to append to native job stream.', error);
+    }
+  }
+
+  Future<void> commitJob(String sessionId, String jobId) async {
+    try {
+      await _api.commitJob(
+        JobStreamPayload(sessionId: sessionId, jobId: jobId),
+      );
+    } on PlatformException catch (error) {
+      throw _jobError('Failed to commit native job stream.', error);
+    } catch (error) {
+      throw TransportException('Failed to commit native job stream.', error);
+    }
+  }
+
+  Future<void> abortJob(String sessionId, String jobId) async {
+    try {
+      await _api.abortJob(JobStreamPayload(sessionId: sessionId, jobId: jobId));
+    } catch (error) {
+      throw TransportException('Failed to abort native job stream.', error);
+    }
+  }
+
+  /// Bytes the printer sent on [sessionId] (USB bulk IN on Linux).
+  Future<Uint8List> readBytes(
+    String sessionId, {
+    int maxBytes = 256,
+    Duration timeout = const Duration(seconds: 1),
+  }) async {
+    try {
+      return await _api.readBytes(
+        ReadBytesPayload(
+          sessionId: sessionId,
+          maxBytes: maxBytes,
+          timeoutMs: timeout.inMilliseconds,
+        ),
+      );
+    } on MissingPluginException catch (error) {
+      throw TransportException(
+        'Reading is not supported on this platform.',
+        error,
+      );
+    } catch (error) {
+      throw TransportException('Failed to read from native transport.', error);
+    }
+  }
+
   Future<PrinterStatus> readStatus(String sessionId) async {
     try {
       final status = await _api.readStatus(SessionPayload(sessionId));
@@ -106,6 +360,142 @@ class NativeTransportBridge {
     }
   }
 
+  /// Native printers as the platform finds them. Closes when every
+  /// transport is searched or [timeout] expires; cancelling the
+  /// subscription stops the platform search. Platforms without streaming
+  /// discovery emit the [searchNativePrinters] result when it completes.
+  Stream<DiscoveredPrinter> discoverNativePrinters({
+    required Set<DiscoveryTransport> transports,
+    Duration timeout = const Duration(seconds: 8),
+    int wifiPort = 9100,
+    List<String> wifiCidrs = const <String>[],
+  }) {
+    final discoveryId = 'discovery-${identityHashCode(this)}-'
+        '${_discoveryCounter++}';
+    StreamSubscription<DiscoveryEventPayload>? events;
+    var finished = false;
+    late final StreamController<DiscoveredPrinter> controller;
+
+    void finish() {
+      if (finished) {
+        return;
+      }
+      finished = true;
+      unawaited(events?.cancel());
+      unawaited(controller.close());
+    }
+
+    Future<void> searchOnce() async {
+      try {
+        final printers = await searchNativePrinters(
+          transports: transports,
+          timeout: timeout,
+          wifiPort: wifiPort,
+          wifiCidrs: wifiCidrs,
+        );
+        if (!finished) {
+          printers.forEach(controller.add);
+        }
+      } catch (error) {
+        if (!finished) {
+          controller.addError(error);
+        }
+      }
+      finish();
+    }
+
+    controller = StreamController<DiscoveredPrinter>(
+      onListen: () async {
+        // Subscribed before starting, so no early device is missed.
+        events = _api.discoveryEvents
+            .where((event) => event.discoveryId == discoveryId)
+            .listen((event) {
+              final device = event.device;
+              final mapped = device == null
+                  ? null
+                  : _mapDiscoveredDevice(device);
+              if (mapped != null &&
+                  transports.contains(mapped.transport) &&
+                  !finished) {
+                controller.add(mapped);
+              }
+              if (event.done) {
+                finish();
+              }
+            }, onError: (Object _) {});
+        try {
+          await _api.startDiscovery(
+            DiscoveryRequestPayload(
+              transports: [for (final transport in transports) transport.name],
+              timeoutMs: timeout.inMilliseconds,
+              wifiPort: wifiPort,
+              wifiCidrs: wifiCidrs,
+              discoveryId: discoveryId,
+            ),
+          );
+        } on MissingPluginException {
+          await events?.cancel();
+          events = null;
+          await searchOnce();
+        } catch (error) {
+          if (!finished) {
+            controller.addError(
+              TransportException('Failed to start native discovery.', error),
+            );
+          }
+          finish();
+        }
+      },
+      onCancel: () {
+        if (finished) {
+          return;
+        }
+        finish();
+        unawaited(
+          _api.cancelDiscovery(discoveryId).catchError((Object _) {}),
+        );
+      },
+    );
+    return controller.stream;
+  }
+
+  /// [WriteInterruptedException] when the platform reconnected the session
+  /// itself (see [NativeTransportApi.write]).
+  TransportException _writeError(String message, PlatformException error) {
+    final details = error.details;
+    if (details is Map<Object?, Object?> && details['reconnected'] == true) {
+      return WriteInterruptedException(
+        '$message The platform reconnected the session but did not resend '
+        'the cut-off data.',
+        error,
+      );
+    }
+    return TransportException(message, error);
+  }
+
+  TransportException _jobError(String message, PlatformException error) {
+    if (error.code == 'job_aborted') {
+      return JobAbortedException('$message The job was aborted.', error);
+    }
+    return TransportException(message, error);
+  }
+
+  List<BatchJobResult> _writtenJobs(List<int> lengths) {
+    var offset = 0;
+    final results = <BatchJobResult>[];
+    for (final length in lengths) {
+      results.add(
+        BatchJobResult(
+          offset: offset,
+          length: length,
+          state: BatchJobState.written,
+        ),
+      );
+      offset += length;
+    }
+    return List<BatchJobResult>.unmodifiable(results);
+  }
+
   EndpointPayload _endpointToPayload(PrinterEndpoint endpoint) {
     return switch (endpoint) {
       WifiEndpoint endpoint => EndpointPayload(
@@ -113,6 +503,7 @@ class NativeTransportBridge {
         host: endpoint.host,
         port: endpoint.port,
         timeoutMs: endpoint.timeout.inMilliseconds,
+        ioBackend: ioBackend.name,
       ),
       UsbEndpoint endpoint => EndpointPayload(
         transport: endpoint.transport,
@@ -120,12 +511,18 @@ class NativeTransportBridge {
         productId: endpoint.productId,
         serialNumber: endpoint.serialNumber,
         interfaceNumber: endpoint.interfaceNumber,
+        baudRate: endpoint.serialSettings?.baudRate,
+        dataBits: endpoint.serialSettings?.dataBits,
+        parity: endpoint.serialSettings?.parity.name,
+        stopBits: endpoint.serialSettings?.stopBits,
+        flowControl: endpoint.serialSettings?.flowControl.name,
       ),
       BluetoothEndpoint endpoint => EndpointPayload(
         transport: endpoint.transport,
         address: endpoint.address,
         mode: endpoint.mode.name,
         serviceUuid: endpoint.serviceUuid,
+        ioBackend: ioBackend.name,
       ),
     };
   }
@@ -139,6 +536,35 @@ class NativeTransportBridge {
       supportsQrCode: payload.supportsQrCode,
       supportsBarcode: payload.supportsBarcode,
       supportsImage: payload.supportsImage,
+      source: CapabilitySource.values.firstWhere(
+        (source) => source.name == payload.source,
+        orElse: () => CapabilitySource.assumed,
+      ),
+      model: payload.model,
+      firmwareVersion: payload.firmwareVersion,
+      manufacturer: payload.manufacturer,
+      profile: _mapProfile(payload.profile),
+    );
+  }
+
+  PrinterProfile? _mapProfile(ProfilePayload? payload) {
+    if (payload == null) {
+      return null;
+    }
+    return PrinterProfile(
+      name: payload.name,
+      dotsPerLine: payload.dotsPerLine,
+      fontAColumns: payload.fontAColumns,
+      fontBColumns: payload.fontBColumns,
+      maxRasterWidth: payload.maxRasterWidth,
+      hasCutter: payload.hasCutter,
+      nvGraphicsKb: payload.nvGraphicsKb,
+      codePages: List<int>.unmodifiable(payload.codePages),
+      imageFormat: switch (payload.imageFormat) {
+        'column24' => BitImageFormat.column24,
+        'column8' => BitImageFormat.column8,
+        _ => BitImageFormat.raster,
+      },
     );
   }
 
@@ -214,6 +640,7 @@ class NativeTransportBridge {
           comPort: payload.comPort,
           serialNumber: payload.serialNumber,
           metadata: payload.metadata,
+          profile: _mapProfile(payload.profile),
         );
 
       case 'bluetooth':
@@ -1,9 +1,19 @@
+import 'dart:typed_data';
+
 import '../model/exceptions.dart';
+import '../model/result.dart';
 import '../model/status.dart';
 import 'native_transport_bridge.dart';
 import 'transport.dart';
 
-abstract class PlatformChannelTransport implements PrinterTransport {
+abstract class PlatformChannelTransport
+    implements
+        BatchWriteTransport,
+        ReadableTransport,
+        CapabilityProbingTransport,
+        ConnectionStateTransport,
+        RetainedJobTransport,
+        JobStreamTransport {
   PlatformChannelTransport(this.bridge);
 
   final NativeTransportBridge bridge;
@@ -32,6 +42,27 @@ abstract class PlatformChannelTransport implements PrinterTransport {
 
   Future<NativeConnectionSession> openSession();
 
+  @override
+  Stream<PrinterConnectionEvent> get connectionEvents {
+    final current = _sessionId;
+    if (current == null) {
+      return const Stream<PrinterConnectionEvent>.empty();
+    }
+    return bridge.connectionEvents(current);
+  }
+
+  /// Capabilities change when the platform finishes re-probing a printer
+  /// whose capabilities came from its cache.
+  @override
+  Future<PrinterCapabilities> refreshCapabilities() async {
+    final current = _sessionId;
+    if (current == null) {
+      throw ConnectionException('Native transport is not connected.');
+    }
+    _capabilities = await bridge.getCapabilities(current);
+    return _capabilities;
+  }
+
   @override
   Future<void> disconnect() async {
     final current = _sessionId;
@@ -51,12 +82,140 @@ abstract class PlatformChannelTransport implements PrinterTransport {
 
     try {
       await bridge.write(current, data);
+    } on WriteInterruptedException {
+      rethrow;
     } catch (error) {
       _sessionId = null;
       rethrow;
     }
   }
 
+  @override
+  Future<List<BatchJobResult>> writeBatch(List<Uint8List> jobs) async {
+    final current = _sessionId;
+    if (current == null) {
+      throw ConnectionException('Native transport is not connected.');
+    }
+
+    try {
+      final result = await bridge.writeBatch(current, jobs);
+      if (!result.reconnected &&
+          result.jobs.any((job) => job.state != BatchJobState.written)) {
+        _sessionId = null;
+      }
+      return result.jobs;
+    } catch (error) {
+      _sessionId = null;
+      rethrow;
+    }
+  }
+
+  @override
+  Future<String?> retainJob(Uint8List job, {Uint8List? separator}) {
+    final current = _sessionId;
+    if (current == null) {
+      throw ConnectionException('Native transport is not connected.');
+    }
+    return bridge.retainJob(current, job, separator: separator);
+  }
+
+  @override
+  Future<void> writeRetainedJob(
+    String jobId, {
+    bool withSeparator = false,
+  }) async {
+    final current = _sessionId;
+    if (current == null) {
+      throw ConnectionException('Native transport is not connected.');
+    }
+
+    try {
+      await bridge.writeRetainedJob(
+        current,
+        jobId,
+        withSeparator: withSeparator,
+      );
+    } on WriteInterruptedException {
+      rethrow;
+    } catch (error) {
+      _sessionId = null;
+      rethrow;
+    }
+  }
+
+  @override
+  Future<void> releaseJob(String jobId) async {
+    final current = _sessionId;
+    if (current == null) {
+      return;
+    }
+    await bridge.releaseJob(current, jobId);
+  }
+
+  @override
+  Future<String?> beginJob() {
+    final current = _sessionId;
+    if (current == null) {
+      throw ConnectionException('Native transport is not connected.');
+    }
+    return bridge.beginJob(current);
+  }
+
+  @override
+  Future<void> appendChunk(String jobId, Uint8List chunk) async {
+    final current = _sessionId;
+    if (current == null) {
+      throw ConnectionException('Native transport is not connected.');
+    }
+
+    try {
+      await bridge.appendChunk(current, jobId, chunk);
+    } on JobAbortedException {
+      rethrow;
+    } catch (error) {
+      _sessionId = null;
+      rethrow;
+    }
+  }
+
+  @override
+  Future<void> commitJob(String jobId) async {
+    final current = _sessionId;
+    if (current == null) {
+      throw ConnectionException('Native transport is not connected.');
+    }
+
+    try {
+      await bridge.commitJob(current, jobId);
+    } on JobAbortedException {
+      rethrow;
+    } catch (error) {
+      _sessionId = null;
+      rethrow;
+    }
+  }
+
+  @override
+  Future<void> abortJob(String jobId) async {
+    final current = _sessionId;
+    if (current == null) {
+      return;
+    }
+    await bridge.abortJob(current, jobId);
+  }
+
+  @override
+  Future<Uint8List> read({
+    int maxBytes = 256,
+    Duration timeout = const Duration(seconds: 1),
+  }) {
+    final current = _sessionId;
+    if (current == null) {
+      throw ConnectionException('Native transport is not connected.');
+    }
+    return bridge.readBytes(current, maxBytes: maxBytes, timeout: timeout);
+  }
+
   @override
   Future<PrinterStatus> getStatus() async {
     final current = _sessionId;
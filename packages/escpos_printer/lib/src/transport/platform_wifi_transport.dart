@@ -0,0 +1,15 @@
+import '../model/endpoints.dart';
+import 'native_transport_bridge.dart';
+import 'platform_channel_transport.dart';
+
+final class PlatformWifiTransport extends PlatformChannelTransport {
+  PlatformWifiTransport(this.endpoint, {required NativeTransportBridge bridge})
+    : super(bridge);
+
+  final WifiEndpoint endpoint;
+
+  @override
+  Future<NativeConnectionSession> openSession() {
+    return bridge.openConnection(endpoint);
+  }
+}
@@ -1,4 +1,7 @@
+import 'dart:typed_data';
+
 import '../model/endpoints.dart';
+import '../model/result.dart';
 import '../model/status.dart';
 
 abstract interface class PrinterTransport {
@@ -12,6 +15,76 @@ abstract interface class PrinterTransport {
   Future<PrinterStatus> getStatus();
 }
 
+/// Transport that writes several jobs in one call and reports, per job,
+/// how far it got.
+///
+/// Returns one entry per job, in order. A failure mid-batch is reported in
+/// the result rather than thrown. A transport that already reconnected and
+/// resumed the batch by itself stays connected after such a failure, so the
+/// caller reports it instead of reconnecting and retrying on top.
+abstract interface class BatchWriteTransport implements PrinterTransport {
+  Future<List<BatchJobResult>> writeBatch(List<Uint8List> jobs);
+}
+
+/// Transport that returns bytes the printer sends back, such as status
+/// replies, model IDs or transaction acknowledgements.
+abstract interface class ReadableTransport implements PrinterTransport {
+  /// Up to [maxBytes] received bytes, waiting at most [timeout] for the
+  /// first one. Empty when nothing arrived in time.
+  Future<Uint8List> read({
+    int maxBytes = 256,
+    Duration timeout = const Duration(seconds: 1),
+  });
+}
+
+/// Transport whose capabilities can change while connected, e.g. when the
+/// platform re-probes a printer in the background.
+abstract interface class CapabilityProbingTransport
+    implements PrinterTransport {
+  /// Reads the current capabilities and updates [capabilities].
+  Future<PrinterCapabilities> refreshCapabilities();
+}
+
+/// Transport whose platform reports link health while connected, so dead
+/// printers are noticed before the next write.
+abstract interface class ConnectionStateTransport implements PrinterTransport {
+  /// State changes of the current session. Emits nothing while
+  /// disconnected.
+  Stream<PrinterConnectionEvent> get connectionEvents;
+}
+
+/// Transport that keeps a job on the platform side so it can be printed
+/// again without sending its bytes again, e.g. for copies.
+abstract interface class RetainedJobTransport implements PrinterTransport {
+  /// Stores [job], and [separator] to write after a copy on request, for
+  /// the current session. Null when the platform cannot retain jobs.
+  Future<String?> retainJob(Uint8List job, {Uint8List? separator});
+
+  /// Writes one copy of the retained job [jobId].
+  Future<void> writeRetainedJob(String jobId, {bool withSeparator = false});
+
+  /// Frees [jobId]. Retained jobs are also dropped on disconnect.
+  Future<void> releaseJob(String jobId);
+}
+
+/// Transport that takes a job in chunks through a bounded platform-side
+/// buffer, so neither side holds the whole job.
+abstract interface class JobStreamTransport implements PrinterTransport {
+  /// Opens a job on the current session. Null when the platform has no
+  /// job streams.
+  Future<String?> beginJob();
+
+  /// Completes once the platform has buffered [chunk]; while its buffer is
+  /// full that waits for the printer to catch up.
+  Future<void> appendChunk(String jobId, Uint8List chunk);
+
+  /// Completes once every chunk has been written to the printer.
+  Future<void> commitJob(String jobId);
+
+  /// Drops chunks not written yet and ends the job.
+  Future<void> abortJob(String jobId);
+}
+
 abstract interface class TransportFactory {
   Future<PrinterTransport> create(PrinterEndpoint endpoint);
 }
@@ -1,10 +1,15 @@
+import 'dart:async';
 import 'dart:convert';
+import 'dart:io';
+import 'dart:math';
 import 'dart:typed_data';
 
 import 'package:escpos_printer/escpos_printer.dart';
 import 'package:escpos_printer/src/discovery/printer_discovery_service.dart';
 import 'package:escpos_printer/src/discovery/wifi_discovery.dart';
+import 'package:escpos_printer/src/encoding/escpos_encoder.dart';
 import 'package:escpos_printer_platform_interface/escpos_printer_platform_interface.dart';
+import 'package:flutter/services.dart' show PlatformException;
 import 'package:flutter_test/flutter_test.dart';
 
 void main() {
@@ -64,6 +69,208 @@ void main() {
     });
   });
 
+  group('CompiledTemplate', () {
+    test('renders like MustacheRenderer and reuses static ops', () {
+      final cache = TemplateCache(capacity: 2);
+      final compiled = cache.lookup(
+        '@text Total: {{price}}\n{{#each items}}@text {{name}}\n{{/each}}',
+      );
+
+      expect(identical(cache.lookup(compiled.source), compiled), isTrue);
+      final ops = compiled.resolveOps(<String, Object?>{
+        'price': '10.50',
+        'items': <Object?>[
+          <String, Object?>{'name': 'Coffee'},
+          <String, Object?>{'name': 'Bread'},
+        ],
+      });
+      expect(ops.length, 3);
+      expect((ops.first as TextOp).text, 'Total: 10.50');
+      expect((ops.last as TextOp).text, 'Bread');
+
+      final staticTemplate = cache.lookup('@text Header\n@cut');
+      final first = staticTemplate.resolveOps(const <String, Object?>{});
+      final second = staticTemplate.resolveOps(const <String, Object?>{});
+      expect(identical(first, second), isTrue);
+
+      cache.lookup('@feed');
+      expect(cache.length, 2);
+      expect(identical(cache.lookup(compiled.source), compiled), isFalse);
+    });
+
+    test('rejects invalid skeleton lines before rendering', () {
+      final compiled = CompiledTemplate.compile(
+        '@text {{title}}\n@bogus line\n@text {{footer}}',
+      );
+      expect(
+        () => compiled.resolveOps(<String, Object?>{
+          'title': 'A',
+          'footer': 'B',
+        }),
+        throwsA(isA<TemplateParseException>()),
+      );
+    });
+
+    test('leaves lines inside sections to the render', () {
+      final compiled = CompiledTemplate.compile(
+        '@text {{title}}\n{{#if debug}}\n@bogus line\n{{/if}}\n@cut',
+      );
+      final ops = compiled.resolveOps(<String, Object?>{
+        'title': 'A',
+        'debug': false,
+      });
+      expect(ops.length, 2);
+      expect(
+        () => compiled.resolveOps(<String, Object?>{
+          'title': 'A',
+          'debug': true,
+        }),
+        throwsA(isA<TemplateParseException>()),
+      );
+    });
+  });
+
+  group('EscPosEncoder', () {
+    test('maps WCP1252 characters and replaces unsupported ones', () {
+      const encoder = EscPosEncoder();
+      final bytes = encoder.encode(<PrintOp>[
+        const TextOp('€5 – ok 😀'),
+      ], initializePrinter: false);
+
+      expect(
+        _containsSequence(bytes, <int>[
+          0x80,
+          0x35,
+          0x20,
+          0x96,
+          0x20,
+          0x6F,
+          0x6B,
+          0x20,
+          0x3F,
+          0x0A,
+        ]),
+        isTrue,
+      );
+
+      const latin1Encoder = EscPosEncoder(codeTable: null);
+      final latin1Bytes = latin1Encoder.encode(<PrintOp>[
+        const TextOp('€'),
+      ], initializePrinter: false);
+      expect(_containsSequence(latin1Bytes, <int>[0x3F, 0x0A]), isTrue);
+    });
+
+    test('wraps and pads row cells to the paper width', () {
+      const encoder = EscPosEncoder(paperWidthChars: 10);
+      final bytes = encoder.encode(<PrintOp>[
+        RowOp(const <RowColumnSpec>[
+          RowColumnSpec(text: 'Big  coffee\r\nmug'),
+          RowColumnSpec(text: '9.90', align: TextAlign.right),
+        ]),
+      ], initializePrinter: false);
+
+      expect(
+        latin1.decode(bytes),
+        'Big   9.90\ncoffe     \ne         \nmug       \n',
+      );
+    });
+
+    test('sends only style changes and resets at job end', () {
+      const encoder = EscPosEncoder();
+      final result = encoder.encodeJob(<PrintOp>[
+        const TextOp('A', style: ReceiptTextStyle(bold: true)),
+        const TextOp('B', style: ReceiptTextStyle(bold: true)),
+        const TextOp('C'),
+      ]);
+
+      expect(
+        result.bytes,
+        <int>[0x1B, 0x40, 0x1B, 0x74, 0x10]
+          ..addAll(<int>[0x1B, 0x45, 1, 0x41, 0x0A, 0x42, 0x0A])
+          ..addAll(<int>[0x1B, 0x45, 0, 0x43, 0x0A]),
+      );
+      expect(result.styleBytesSaved, 33 * 3 - 6);
+    });
+
+    test('sends images as ESC * column bands when asked', () {
+      final random = Random(45);
+      const widthBytes = 3;
+      const heightDots = 30;
+      final raster = Uint8List.fromList(
+        List<int>.generate(widthBytes * heightDots, (_) => random.nextInt(256)),
+      );
+      bool dot(int x, int y) {
+        if (y >= heightDots) {
+          return false;
+        }
+        return raster[y * widthBytes + x ~/ 8] & (0x80 >> (x % 8)) != 0;
+      }
+
+      final expected = <int>[0x1B, 0x33, 24];
+      for (var band = 0; band < 2; band++) {
+        expected.addAll(<int>[0x1B, 0x2A, 33, widthBytes * 8, 0]);
+        for (var x = 0; x < widthBytes * 8; x++) {
+          for (var block = 0; block < 3; block++) {
+            var byte = 0;
+            for (var bit = 0; bit < 8; bit++) {
+              if (dot(x, band * 24 + block * 8 + bit)) {
+                byte |= 0x80 >> bit;
+              }
+            }
+            expected.add(byte);
+          }
+        }
+        expected.add(0x0A);
+      }
+      expected.addAll(<int>[0x1B, 0x32]);
+
+      const encoder = EscPosEncoder(imageFormat: BitImageFormat.column24);
+      final bytes = encoder.encode(<PrintOp>[
+        ImageOp(
+          rasterData: raster,
+          widthBytes: widthBytes,
+          heightDots: heightDots,
+        ),
+      ], initializePrinter: false);
+
+      expect(_containsSequence(bytes, expected), isTrue);
+      expect(_containsSequence(bytes, <int>[0x1D, 0x76, 0x30]), isFalse);
+    });
+
+    test('optimizes blank lines, padding and cuts away', () {
+      const encoder = EscPosEncoder(paperWidthChars: 10);
+      final ops = <PrintOp>[
+        const TextOp('Total   '),
+        const TextOp(''),
+        const FeedOp(0),
+        const FeedOp(2),
+        RowOp(const <RowColumnSpec>[
+          RowColumnSpec(text: 'Tea'),
+          RowColumnSpec(text: 'x'),
+        ]),
+        const TextOp('Thanks'),
+        const CutOp(CutMode.partial),
+        const CutOp(CutMode.full),
+      ];
+
+      final result = encoder.encodeJob(ops, optimize: true);
+
+      expect(
+        result.bytes,
+        <int>[0x1B, 0x40, 0x1B, 0x74, 0x10]
+          ..addAll(latin1.encode('Total\n'))
+          ..addAll(<int>[0x1B, 0x64, 3])
+          ..addAll(latin1.encode('Tea  x\nThanks\n'))
+          ..addAll(<int>[0x1D, 0x56, 0]),
+      );
+      expect(result.opBytesSaved, 14);
+      expect(
+        encoder.encodeJob(ops).bytes.length - result.bytes.length,
+        result.opBytesSaved,
+      );
+    });
+  });
+
   group('DefaultTransportFactory', () {
     test('routes USB and Bluetooth to native transports', () async {
       final bridge = FakeNativeTransportBridge();
@@ -94,9 +301,174 @@ void main() {
       final transport = await factory.create(const WifiEndpoint('127.0.0.1'));
       expect(transport, isA<WifiSocketTransport>());
     });
+
+    test('opens native Wi-Fi with the requested io backend', () async {
+      final api = FakeOpenApi(ioBackend: 'ioUring');
+      final bridge = NativeTransportBridge(
+        api: api,
+        ioBackend: NativeIoBackend.ioUring,
+      );
+      final factory = DefaultTransportFactory(
+        nativeBridge: bridge,
+        nativeWifi: true,
+      );
+
+      final transport = await factory.create(const WifiEndpoint('10.0.0.5'));
+      expect(transport, isA<PlatformWifiTransport>());
+
+      final session = await bridge.openConnection(
+        const WifiEndpoint('10.0.0.5'),
+      );
+      expect(api.openedPayloads.single['ioBackend'], 'ioUring');
+      expect(api.openedPayloads.single['host'], '10.0.0.5');
+      expect(session.ioBackend, NativeIoBackend.ioUring);
+    });
+
+    test('sends serial line settings with device paths', () async {
+      final api = FakeOpenApi();
+      final bridge = NativeTransportBridge(api: api);
+
+      await bridge.openConnection(
+        const UsbEndpoint.serial(
+          '/dev/ttyUSB0',
+          serialSettings: SerialSettings(
+            baudRate: 19200,
+            parity: SerialParity.even,
+            flowControl: SerialFlowControl.rtsCts,
+          ),
+        ),
+      );
+      await bridge.openConnection(const UsbEndpoint.serial('/dev/usb/lp0'));
+
+      final tty = api.openedPayloads.first;
+      expect(tty['serialNumber'], '/dev/ttyUSB0');
+      expect(tty['baudRate'], 19200);
+      expect(tty['dataBits'], 8);
+      expect(tty['parity'], 'even');
+      expect(tty['stopBits'], 1);
+      expect(tty['flowControl'], 'rtsCts');
+      expect(api.openedPayloads.last['baudRate'], isNull);
+    });
+
+    test('opens usblp nodes as device sessions with line status', () async {
+      final api = FakeLpStatusApi();
+      final bridge = NativeTransportBridge(api: api);
+
+      final session = await bridge.openConnection(
+        const UsbEndpoint.serial('/dev/usb/lp0'),
+      );
+      final status = await bridge.readStatus(session.sessionId);
+
+      final payload = api.openedPayloads.single;
+      expect(payload['serialNumber'], '/dev/usb/lp0');
+      expect(payload['vendorId'], isNull);
+      expect(payload['productId'], isNull);
+      expect(api.statusSessions, <String>[session.sessionId]);
+      expect(status.paperOut, TriState.yes);
+      expect(status.offline, TriState.no);
+      expect(status.paperNearEnd, TriState.unknown);
+      expect(status.coverOpen, TriState.unknown);
+      expect(status.cutterError, TriState.unknown);
+      expect(status.drawerSignal, TriState.unknown);
+    });
+
+    test('maps cached capabilities and refreshes them', () async {
+      final api = FakeOpenApi(
+        capabilities: const CapabilityPayload(
+          supportsRealtimeStatus: true,
+          source: 'cached',
+          model: 'TM-T20',
+        ),
+        refreshedCapabilities: const CapabilityPayload(
+          supportsPartialCut: false,
+          supportsFullCut: false,
+          supportsRealtimeStatus: true,
+          source: 'probed',
+          model: 'TM-T20II',
+          firmwareVersion: '1.01',
+        ),
+      );
+      final client = EscPosClient(
+        transportFactory: DefaultTransportFactory(
+          nativeBridge: NativeTransportBridge(api: api),
+        ),
+      );
+
+      await client.connect(const UsbEndpoint(0x04b8, 0x0e15));
+      final cached = client.transportCapabilities!;
+      expect(cached.source, CapabilitySource.cached);
+      expect(cached.model, 'TM-T20');
+      expect(cached.supportsRealtimeStatus, isTrue);
+
+      final refreshed = await client.refreshCapabilities();
+      expect(refreshed.source, CapabilitySource.probed);
+      expect(refreshed.model, 'TM-T20II');
+      expect(refreshed.firmwareVersion, '1.01');
+      expect(refreshed.supportsPartialCut, isFalse);
+      expect(client.transportCapabilities, same(refreshed));
+    });
+
+    test('forwards connection events of the current session', () async {
+      final api = FakeOpenApi();
+      final client = EscPosClient(
+        transportFactory: DefaultTransportFactory(
+          nativeBridge: NativeTransportBridge(api: api),
+        ),
+      );
+      final events = <PrinterConnectionEvent>[];
+      final subscription = client.connectionEvents.listen(events.add);
+
+      await client.connect(const UsbEndpoint(0x04b8, 0x0e15));
+      api.connectionController
+        ..add(
+          const ConnectionEventPayload(
+            sessionId: 'open-1',
+            state: 'degraded',
+            reason: 'Printer is not acknowledging data.',
+          ),
+        )
+        ..add(
+          const ConnectionEventPayload(sessionId: 'other', state: 'lost'),
+        )
+        ..add(const ConnectionEventPayload(sessionId: 'open-1', state: 'lost'));
+      await Future<void>.delayed(Duration.zero);
+
+      await client.disconnect();
+      api.connectionController.add(
+        const ConnectionEventPayload(sessionId: 'open-1', state: 'connected'),
+      );
+      await Future<void>.delayed(Duration.zero);
+      await subscription.cancel();
+
+      expect(events.map((event) => event.state), <PrinterConnectionState>[
+        PrinterConnectionState.connected,
+        PrinterConnectionState.degraded,
+        PrinterConnectionState.lost,
+      ]);
+      expect(events[1].reason, 'Printer is not acknowledging data.');
+    });
   });
 
   group('EscPosClient', () {
+    test('reads printer replies from native sessions', () async {
+      final bridge = FakeNativeTransportBridge();
+      final client = EscPosClient(
+        transportFactory: DefaultTransportFactory(nativeBridge: bridge),
+      );
+
+      await expectLater(
+        client.readBytes(),
+        throwsA(isA<ConnectionException>()),
+      );
+
+      await client.connect(const UsbEndpoint(0x0416, 0x5011));
+      bridge.replies.addAll(<int>[0x5F, 0x54, 0x4D, 0x00]);
+
+      expect(await client.readBytes(maxBytes: 3), <int>[0x5F, 0x54, 0x4D]);
+      expect(await client.readBytes(), <int>[0x00]);
+      expect(await client.readBytes(), isEmpty);
+    });
+
     test('sends WCP1252 code table by default for accented text', () async {
       final factory = FakeTransportFactory();
       final client = EscPosClient(transportFactory: factory);
@@ -189,6 +561,413 @@ void main() {
       expect(_containsSequence(payload, <int>[0x1D, 0x56, 0x01]), isTrue);
     });
 
+    test('streams chunks with the same bytes as a single write', () async {
+      final template = ReceiptTemplate.dsl((builder) {
+        for (var i = 0; i < 50; i++) {
+          builder.text('Line $i', bold: i.isEven);
+        }
+        builder.cut();
+      });
+
+      final singleFactory = FakeTransportFactory();
+      final single = EscPosClient(transportFactory: singleFactory);
+      await single.connect(const WifiEndpoint('127.0.0.1'));
+      await single.print(template: template);
+
+      final streamFactory = FakeTransportFactory();
+      final streaming = EscPosClient(transportFactory: streamFactory);
+      await streaming.connect(const WifiEndpoint('127.0.0.1'));
+      final result = await streaming.print(
+        template: template,
+        printOptions: const PrintOptions(streaming: true, chunkSizeBytes: 64),
+      );
+
+      final writes = streamFactory.createdTransports.single.writes;
+      expect(writes.length, greaterThan(1));
+      expect(
+        writes.expand((chunk) => chunk).toList(),
+        singleFactory.lastPayload,
+      );
+      expect(result.bytesSent, singleFactory.lastPayload!.length);
+    });
+
+    test('encodes on a worker pool with the same bytes', () async {
+      final pool = EscPosWorkerPool(size: 2);
+      addTearDown(pool.close);
+      final template = ReceiptTemplate.string(
+        '@text align=center bold=true {{store}}\n@cut',
+      );
+
+      final localFactory = FakeTransportFactory();
+      final local = EscPosClient(transportFactory: localFactory);
+      await local.connect(const WifiEndpoint('127.0.0.1'));
+      await local.print(
+        template: template,
+        variables: <String, Object?>{'store': 'Mini Market'},
+      );
+
+      final pooledFactory = FakeTransportFactory();
+      final pooled = EscPosClient(
+        transportFactory: pooledFactory,
+        workerPool: pool,
+      );
+      await pooled.connect(const WifiEndpoint('127.0.0.1'));
+      final result = await pooled.print(
+        template: template,
+        variables: <String, Object?>{'store': 'Mini Market'},
+      );
+
+      expect(pooledFactory.lastPayload, localFactory.lastPayload);
+      expect(result.bytesSent, localFactory.lastPayload!.length);
+      await expectLater(
+        pooled.print(template: template),
+        throwsA(isA<TemplateRenderException>()),
+      );
+    });
+
+    test('prints a batch in one write with per-job offsets', () async {
+      final factory = FakeTransportFactory();
+      final client = EscPosClient(transportFactory: factory);
+      await client.connect(const WifiEndpoint('127.0.0.1'));
+
+      final template = ReceiptTemplate.string('@text Ticket {{n}}\n@cut');
+      final result = await client.printBatch(<PrintJob>[
+        for (var n = 1; n <= 3; n++)
+          PrintJob(template: template, variables: <String, Object?>{'n': n}),
+      ]);
+
+      final writes = factory.createdTransports.single.writes;
+      expect(writes.length, 1);
+      expect(result.isComplete, isTrue);
+      expect(result.bytesSent, writes.single.length);
+      expect(result.jobs.length, 3);
+      expect(result.jobs[1].offset, result.jobs[0].length);
+      expect(
+        _containsAscii(
+          writes.single.sublist(result.jobs[2].offset),
+          'Ticket 3',
+        ),
+        isTrue,
+      );
+    });
+
+    test('resumes a native batch at the job that failed', () async {
+      final api = FakeBatchApi(failJobOnFirstCall: 1);
+      final client = EscPosClient(
+        transportFactory: DefaultTransportFactory(
+          nativeBridge: NativeTransportBridge(api: api),
+        ),
+        reconnectPolicy: const ReconnectPolicy(
+          maxAttempts: 1,
+          baseDelay: Duration.zero,
+          maxDelay: Duration.zero,
+        ),
+      );
+      await client.connect(const UsbEndpoint(0x0416, 0x5011));
+
+      final result = await client.printBatch(<PrintJob>[
+        for (final name in <String>['A', 'B', 'C'])
+          PrintJob(template: ReceiptTemplate.string('@text $name')),
+      ]);
+
+      expect(result.isComplete, isTrue);
+      expect(api.batchCalls, <int>[3, 2]);
+      expect(
+        result.jobs.map((job) => job.state),
+        everyElement(BatchJobState.written),
+      );
+    });
+
+    test('replays copies from a job retained on the native side', () async {
+      final api = FakeRetainApi();
+      final client = EscPosClient(
+        transportFactory: DefaultTransportFactory(
+          nativeBridge: NativeTransportBridge(api: api),
+        ),
+      );
+      await client.connect(const UsbEndpoint(0x0416, 0x5011));
+      final progress = <PrintCopyProgress>[];
+      final subscription = client.copyProgress.listen(progress.add);
+
+      final result = await client.printFromString(
+        template: '@text Kitchen',
+        variables: const <String, Object?>{},
+        printOptions: const PrintOptions(
+          copies: 3,
+          cutBetweenCopies: CutMode.partial,
+          statusStrategy: StatusStrategy.skip,
+        ),
+      );
+      await subscription.cancel();
+
+      final jobLength = api.retained.single.bytes.length;
+      expect(api.retained.single.separator, <int>[0x1D, 0x56, 1]);
+      expect(api.copies, <bool>[true, true, false]);
+      expect(api.released, <String>['job-1']);
+      expect(api.plainWrites, 0);
+      expect(result.bytesSent, jobLength * 3 + 6);
+      expect(progress.map((event) => event.copy), <int>[1, 2, 3]);
+      expect(progress.last.bytesSent, result.bytesSent);
+    });
+
+    test('streams a job through a native job stream', () async {
+      final api = FakeJobStreamApi();
+      final client = EscPosClient(
+        transportFactory: DefaultTransportFactory(
+          nativeBridge: NativeTransportBridge(api: api),
+        ),
+      );
+      await client.connect(const UsbEndpoint(0x0416, 0x5011));
+
+      final result = await client.printFromString(
+        template: List<String>.filled(40, '@text Line').join('\n'),
+        variables: const <String, Object?>{},
+        printOptions: const PrintOptions(
+          streaming: true,
+          chunkSizeBytes: 64,
+          statusStrategy: StatusStrategy.skip,
+        ),
+      );
+
+      expect(api.calls.first, 'begin');
+      expect(api.calls.last, 'commit');
+      expect(
+        api.calls.where((call) => call == 'append').length,
+        greaterThan(1),
+      );
+      expect(api.appendedBytes, result.bytesSent);
+      expect(api.plainWrites, 0);
+    });
+
+    test('keeps the session when a job stream is aborted', () async {
+      final api = FakeAbortedJobStreamApi();
+      final client = EscPosClient(
+        transportFactory: DefaultTransportFactory(
+          nativeBridge: NativeTransportBridge(api: api),
+        ),
+      );
+      await client.connect(const UsbEndpoint(0x0416, 0x5011));
+
+      await expectLater(
+        client.printFromString(
+          template: List<String>.filled(40, '@text Line').join('\n'),
+          variables: const <String, Object?>{},
+          printOptions: const PrintOptions(
+            streaming: true,
+            chunkSizeBytes: 64,
+            statusStrategy: StatusStrategy.skip,
+          ),
+        ),
+        throwsA(isA<EscPosException>()),
+      );
+      await client.printFromString(
+        template: '@text After',
+        variables: const <String, Object?>{},
+        printOptions: const PrintOptions(statusStrategy: StatusStrategy.skip),
+      );
+
+      expect(api.opens, 1);
+      expect(api.plainWrites, 1);
+    });
+
+    test('writes through a registered direct writer', () async {
+      final writer = FakeDirectWriter();
+      final client = EscPosClient(
+        transportFactory: DefaultTransportFactory(
+          nativeBridge: NativeTransportBridge(
+            api: FakeOpenApi(directWriter: writer),
+          ),
+        ),
+      );
+      await client.connect(const UsbEndpoint(0x0416, 0x5011));
+
+      final result = await client.printFromString(
+        template: '@text Direct',
+        variables: const <String, Object?>{},
+        printOptions: const PrintOptions(statusStrategy: StatusStrategy.skip),
+      );
+
+      expect(writer.writes.single.$1, 'open-1');
+      expect(writer.writes.single.$2.length, result.bytesSent);
+      expect(_containsAscii(writer.writes.single.$2, 'Direct'), isTrue);
+    });
+
+    test('binds the platform direct writer only when opted in', () async {
+      final writer = FakeDirectWriter();
+      var opens = 0;
+      NativeDirectWriter.opener = () {
+        opens++;
+        return writer;
+      };
+      addTearDown(() {
+        NativeDirectWriter.opener = null;
+        NativeDirectWriter.instance = null;
+      });
+
+      NativeTransportBridge();
+      expect(opens, 0);
+
+      final api = NativeTransportApi(useDirectWriter: true);
+      final payload = WritePayload(
+        sessionId: 'open-1',
+        bytes: Uint8List.fromList(<int>[0x1b, 0x40]),
+      );
+      await api.write(payload);
+      await api.write(payload);
+
+      expect(opens, 1);
+      expect(writer.writes, hasLength(2));
+    });
+
+    test('does not resend a write cut off after a native reconnect', () async {
+      final api = FakeInterruptedApi();
+      final client = EscPosClient(
+        transportFactory: DefaultTransportFactory(
+          nativeBridge: NativeTransportBridge(api: api),
+        ),
+        reconnectPolicy: const ReconnectPolicy(maxAttempts: 3),
+      );
+      await client.connect(const UsbEndpoint(0x0416, 0x5011));
+
+      await expectLater(
+        client.printFromString(
+          template: '@text Once',
+          variables: const <String, Object?>{},
+          printOptions: const PrintOptions(
+            statusStrategy: StatusStrategy.skip,
+          ),
+        ),
+        throwsA(
+          isA<ConnectionException>().having(
+            (error) => error.cause,
+            'cause',
+            isA<WriteInterruptedException>(),
+          ),
+        ),
+      );
+      expect(api.writes, 1);
+      expect(api.openedPayloads, hasLength(1));
+    });
+
+    test('reads status while a write is in progress', () async {
+      final factory = FakeTransportFactory();
+      final client = EscPosClient(transportFactory: factory);
+      await client.connect(const WifiEndpoint('127.0.0.1'));
+
+      factory.writeGate = Completer<void>();
+      var printed = false;
+      final printing = client
+          .print(template: ReceiptTemplate.dsl((b) => b.text('Slow job')))
+          .then((_) => printed = true);
+
+      final status = await client.getStatus();
+      expect(status.paperOut, TriState.no);
+      expect(printed, isFalse);
+
+      factory.writeGate!.complete();
+      await printing;
+      expect(printed, isTrue);
+    });
+
+    test('runs queued work by priority class', () async {
+      final factory = FakeTransportFactory();
+      final client = EscPosClient(transportFactory: factory);
+      await client.connect(const WifiEndpoint('127.0.0.1'));
+
+      ReceiptTemplate labelled(String label) {
+        return ReceiptTemplate.dsl((b) => b.text(label));
+      }
+
+      factory.writeGate = Completer<void>();
+      final first = client.print(template: labelled('first'));
+      await Future<void>.delayed(Duration.zero);
+      final pending = <Future<Object?>>[
+        first,
+        client.print(
+          template: labelled('report'),
+          printOptions: const PrintOptions(priority: PrintPriority.bulk),
+        ),
+        client.print(template: labelled('reprint')),
+        client.openCashDrawer(),
+      ];
+      await Future<void>.delayed(Duration.zero);
+      expect(client.queueStats[PrintPriority.bulk]!.depth, 1);
+
+      factory.writeGate!.complete();
+      await Future.wait(pending);
+
+      final writes = factory.createdTransports.single.writes;
+      expect(_containsAscii(writes[0], 'first'), isTrue);
+      expect(_containsSequence(writes[1], <int>[0x1B, 0x70]), isTrue);
+      expect(_containsAscii(writes[2], 'reprint'), isTrue);
+      expect(_containsAscii(writes[3], 'report'), isTrue);
+      expect(client.queueStats[PrintPriority.bulk]!.started, 1);
+      expect(client.queueStats[PrintPriority.bulk]!.depth, 0);
+    });
+
+    test('kicks the drawer between chunks of a bulk print', () async {
+      final factory = FakeTransportFactory();
+      final client = EscPosClient(transportFactory: factory);
+      await client.connect(const WifiEndpoint('127.0.0.1'));
+
+      factory.writeGate = Completer<void>();
+      final report = client.print(
+        template: ReceiptTemplate.dsl((b) {
+          for (var i = 0; i < 40; i++) {
+            b.text('Report line $i');
+          }
+        }),
+        printOptions: const PrintOptions(
+          priority: PrintPriority.bulk,
+          chunkSizeBytes: 32,
+        ),
+      );
+      await Future<void>.delayed(Duration.zero);
+      final kick = client.openCashDrawer();
+
+      factory.writeGate!.complete();
+      await Future.wait(<Future<void>>[report.then((_) {}), kick]);
+
+      final writes = factory.createdTransports.single.writes;
+      final kickIndex = writes.indexWhere(
+        (bytes) => _containsSequence(bytes, <int>[0x1B, 0x70]),
+      );
+      expect(kickIndex, greaterThan(0));
+      expect(kickIndex, lessThan(writes.length - 1));
+    });
+
+    test('defers post-print status and serves it from cache', () async {
+      final factory = FakeTransportFactory();
+      final client = EscPosClient(transportFactory: factory);
+      await client.connect(const WifiEndpoint('127.0.0.1'));
+      final template = ReceiptTemplate.dsl((b) => b.text('Hi'));
+
+      final skipped = await client.print(
+        template: template,
+        printOptions: const PrintOptions(statusStrategy: StatusStrategy.skip),
+      );
+      expect(skipped.status.paperOut, TriState.unknown);
+      expect(client.lastStatus, isNull);
+
+      final updates = client.statusUpdates.first;
+      final deferred = await client.print(
+        template: template,
+        printOptions: const PrintOptions(
+          statusStrategy: StatusStrategy.deferred,
+        ),
+      );
+      expect(deferred.status.paperOut, TriState.unknown);
+      expect((await deferred.deferredStatus)!.paperOut, TriState.no);
+      expect((await updates).paperOut, TriState.no);
+
+      final cached = await client.print(
+        template: template,
+        printOptions: const PrintOptions(statusStrategy: StatusStrategy.cached),
+      );
+      expect(cached.status.paperOut, TriState.no);
+      expect(cached.deferredStatus, isNull);
+    });
+
     test('retries with reconnection when first write fails', () async {
       final factory = FakeTransportFactory(failFirstWrite: true);
       final client = EscPosClient(
@@ -312,6 +1091,93 @@ void main() {
       );
     });
 
+    test('streams printers from every source as they are found', () async {
+      final wifi = FakeWifiDiscovery(<DiscoveredPrinter>[
+        DiscoveredPrinter(
+          id: 'wifi-1',
+          transport: DiscoveryTransport.wifi,
+          endpoint: const WifiEndpoint('192.168.0.30'),
+          host: '192.168.0.30',
+        ),
+        DiscoveredPrinter(
+          id: 'wifi-1-again',
+          transport: DiscoveryTransport.wifi,
+          endpoint: const WifiEndpoint('192.168.0.30'),
+          host: '192.168.0.30',
+        ),
+      ]);
+      final api = FakeStreamingDiscoveryApi();
+      final service = PrinterDiscoveryService(
+        nativeBridge: NativeTransportBridge(api: api),
+        wifiDiscovery: wifi,
+      );
+
+      final found = await service
+          .discover(const PrinterDiscoveryOptions())
+          .toList();
+
+      expect(found.map((printer) => printer.transport).toSet(), <Object>{
+        DiscoveryTransport.wifi,
+        DiscoveryTransport.usb,
+        DiscoveryTransport.bluetooth,
+      });
+      expect(found.length, 3);
+      expect(
+        found.where((printer) => printer.address == '11:22:33:44:55:66'),
+        isEmpty,
+      );
+      expect(api.cancelled, isEmpty);
+    });
+
+    test('stops native discovery when the stream is cancelled', () async {
+      final api = FakeStreamingDiscoveryApi();
+      final bridge = NativeTransportBridge(api: api);
+
+      final first = await bridge
+          .discoverNativePrinters(
+            transports: <DiscoveryTransport>{DiscoveryTransport.usb},
+          )
+          .first;
+
+      expect(first.vendorId, 0x04b8);
+      expect(api.cancelled, hasLength(1));
+    });
+
+    test('probes neighbours of listed printer vendors first', () async {
+      final server = await ServerSocket.bind(InternetAddress.loopbackIPv4, 0);
+      server.listen((socket) => socket.destroy());
+      final directory = await Directory.systemTemp.createTemp('escpos_arp');
+      final table = File('${directory.path}/arp');
+      await table.writeAsString(
+        'IP address       HW type     Flags       HW address            '
+        'Mask     Device\n'
+        '127.0.0.1        0x1         0x2         00:11:62:aa:bb:cc     '
+        '*        lo\n'
+        '127.0.0.9        0x1         0x0         00:00:00:00:00:00     '
+        '*        lo\n',
+      );
+      addTearDown(() async {
+        await server.close();
+        await directory.delete(recursive: true);
+      });
+
+      final discovery = WifiSubnetDiscovery(neighborTablePath: table.path);
+      PrinterDiscoveryOptions options(List<String> ouis) {
+        return PrinterDiscoveryOptions(
+          transports: const <DiscoveryTransport>{DiscoveryTransport.wifi},
+          wifiPort: server.port,
+          wifiCidrs: const <String>['127.0.0.0/24'],
+          wifiVendorOuis: ouis,
+        );
+      }
+
+      final first = await discovery.discover(options(['00-11-62'])).first;
+      expect(first.host, '127.0.0.1');
+      expect(first.metadata['mac'], '00:11:62:aa:bb:cc');
+
+      expect(await discovery.search(options(['00:26:ab'])), isEmpty);
+    });
+
     test('applies transport filter during search', () async {
       final wifi = FakeWifiDiscovery(<DiscoveredPrinter>[
         DiscoveredPrinter(
@@ -377,6 +1243,39 @@ void main() {
       expect(endpoint.vendorId, 0x04B8);
       expect(endpoint.productId, 0x0E15);
     });
+
+    test('maps built-in printer profiles from discovery', () async {
+      final payload = DiscoveredDevicePayload.fromMap(<String, Object?>{
+        'name': 'Epson TM-T20II',
+        'transport': 'usb',
+        'vendorId': 0x04B8,
+        'productId': 0x0E15,
+        'profile': <Object?, Object?>{
+          'name': 'Epson TM-T20II',
+          'dotsPerLine': 576,
+          'fontAColumns': 48,
+          'fontBColumns': 64,
+          'maxRasterWidth': 576,
+          'hasCutter': true,
+          'nvGraphicsKb': 256,
+          'codePages': <Object?>[0, 16],
+        },
+      });
+      final bridge = NativeTransportBridge(
+        api: FakeNativeTransportApi(<DiscoveredDevicePayload>[payload]),
+      );
+
+      final devices = await bridge.searchNativePrinters(
+        transports: const <DiscoveryTransport>{DiscoveryTransport.usb},
+      );
+
+      final profile = devices.single.profile!;
+      expect(profile.name, 'Epson TM-T20II');
+      expect(profile.dotsPerLine, 576);
+      expect(profile.fontAColumns, 48);
+      expect(profile.hasCutter, isTrue);
+      expect(profile.codePages, <int>[0, 16]);
+    });
   });
 }
 
@@ -416,6 +1315,9 @@ final class FakeTransportFactory implements TransportFactory {
   final List<FakeTransport> createdTransports = <FakeTransport>[];
   bool _failureInjected = false;
 
+  /// When set, writes wait for it to complete.
+  Completer<void>? writeGate;
+
   List<int>? get lastPayload {
     if (createdTransports.isEmpty) {
       return null;
@@ -434,16 +1336,20 @@ final class FakeTransportFactory implements TransportFactory {
     final shouldFail = failFirstWrite && !_failureInjected;
     _failureInjected = _failureInjected || shouldFail;
 
-    final transport = FakeTransport(shouldFailFirstWrite: shouldFail);
+    final transport = FakeTransport(
+      shouldFailFirstWrite: shouldFail,
+      beforeWrite: () => writeGate?.future,
+    );
     createdTransports.add(transport);
     return transport;
   }
 }
 
 final class FakeTransport implements PrinterTransport {
-  FakeTransport({required this.shouldFailFirstWrite});
+  FakeTransport({required this.shouldFailFirstWrite, this.beforeWrite});
 
   final bool shouldFailFirstWrite;
+  final Future<void>? Function()? beforeWrite;
   final List<List<int>> writes = <List<int>>[];
   bool _connected = false;
   String? _sessionId;
@@ -484,6 +1390,7 @@ final class FakeTransport implements PrinterTransport {
 
   @override
   Future<void> write(List<int> data) async {
+    await beforeWrite?.call();
     if (!_connected) {
       throw ConnectionException('Fake transport disconnected.');
     }
@@ -500,6 +1407,7 @@ final class FakeTransport implements PrinterTransport {
 final class FakeNativeTransportBridge extends NativeTransportBridge {
   final List<PrinterEndpoint> openedEndpoints = <PrinterEndpoint>[];
   final Map<String, List<int>> writes = <String, List<int>>{};
+  final List<int> replies = <int>[];
 
   int _sessionCounter = 0;
 
@@ -520,6 +1428,18 @@ final class FakeNativeTransportBridge extends NativeTransportBridge {
     writes[sessionId] = List<int>.from(bytes);
   }
 
+  @override
+  Future<Uint8List> readBytes(
+    String sessionId, {
+    int maxBytes = 256,
+    Duration timeout = const Duration(seconds: 1),
+  }) async {
+    final count = min(maxBytes, replies.length);
+    final bytes = Uint8List.fromList(replies.sublist(0, count));
+    replies.removeRange(0, count);
+    return bytes;
+  }
+
   @override
   Future<PrinterStatus> readStatus(String sessionId) async {
     return const PrinterStatus.unknown();
@@ -567,6 +1487,57 @@ final class FakeWifiDiscovery implements WifiDiscovery {
   }
 }
 
+final class FakeStreamingDiscoveryApi extends NativeTransportApi {
+  final StreamController<DiscoveryEventPayload> events =
+      StreamController<DiscoveryEventPayload>.broadcast();
+  final List<String> cancelled = <String>[];
+
+  @override
+  Stream<DiscoveryEventPayload> get discoveryEvents => events.stream;
+
+  @override
+  Future<void> startDiscovery(DiscoveryRequestPayload payload) async {
+    final id = payload.discoveryId!;
+    Timer.run(() {
+      events
+        ..add(
+          DiscoveryEventPayload(
+            discoveryId: id,
+            device: const DiscoveredDevicePayload(
+              transport: 'usb',
+              vendorId: 0x04b8,
+              productId: 0x0e15,
+            ),
+          ),
+        )
+        ..add(
+          const DiscoveryEventPayload(
+            discoveryId: 'someone-else',
+            device: DiscoveredDevicePayload(
+              transport: 'bluetooth',
+              address: '11:22:33:44:55:66',
+            ),
+          ),
+        )
+        ..add(
+          DiscoveryEventPayload(
+            discoveryId: id,
+            device: const DiscoveredDevicePayload(
+              transport: 'bluetooth',
+              address: 'AA:BB:CC:DD:EE:FF',
+            ),
+          ),
+        )
+        ..add(DiscoveryEventPayload(discoveryId: id, done: true));
+    });
+  }
+
+  @override
+  Future<void> cancelDiscovery(String discoveryId) async {
+    cancelled.add(discoveryId);
+  }
+}
+
 final class FakeNativeTransportApi extends NativeTransportApi {
   FakeNativeTransportApi(this.discoveredDevices);
 
@@ -579,3 +1550,240 @@ final class FakeNativeTransportApi extends NativeTransportApi {
     return discoveredDevices;
   }
 }
+
+final class FakeOpenApi extends NativeTransportApi {
+  FakeOpenApi({
+    this.ioBackend,
+    this.capabilities = const CapabilityPayload(),
+    this.refreshedCapabilities = const CapabilityPayload(),
+    super.directWriter,
+  });
+
+  final String? ioBackend;
+  final CapabilityPayload capabilities;
+  final CapabilityPayload refreshedCapabilities;
+  final List<Map<String, Object?>> openedPayloads = <Map<String, Object?>>[];
+  final StreamController<ConnectionEventPayload> connectionController =
+      StreamController<ConnectionEventPayload>.broadcast();
+
+  @override
+  Stream<ConnectionEventPayload> get connectionEvents =>
+      connectionController.stream;
+
+  @override
+  Future<OpenConnectionResponse> openConnection(
+    EndpointPayload endpoint,
+  ) async {
+    openedPayloads.add(endpoint.toMap());
+    return OpenConnectionResponse(
+      sessionId: 'open-${openedPayloads.length}',
+      capabilities: capabilities,
+      ioBackend: ioBackend,
+    );
+  }
+
+  @override
+  Future<CapabilityPayload> getCapabilities(SessionPayload payload) async {
+    return refreshedCapabilities;
+  }
+}
+
+/// Answers readStatus with the map the Linux plugin builds from
+/// `LPGETSTATUS` for a device node with LP_POUTPA and LP_PSELECD set.
+final class FakeLpStatusApi extends FakeOpenApi {
+  final List<String> statusSessions = <String>[];
+
+  @override
+  Future<StatusPayload> readStatus(SessionPayload payload) async {
+    statusSessions.add(payload.sessionId);
+    return StatusPayload.fromMap(const <String, Object?>{
+      'paperOut': 'yes',
+      'paperNearEnd': 'unknown',
+      'coverOpen': 'unknown',
+      'cutterError': 'unknown',
+      'offline': 'no',
+      'drawerSignal': 'unknown',
+    });
+  }
+}
+
+/// Fails every write the way the Linux plugin does after it reconnected
+/// the session by itself.
+final class FakeInterruptedApi extends FakeOpenApi {
+  int writes = 0;
+
+  @override
+  Future<void> write(WritePayload payload) async {
+    writes++;
+    throw PlatformException(
+      code: 'write_failed',
+      message: 'Failed to send bytes over USB.',
+      details: <String, Object?>{'reconnected': true, 'bytesAcknowledged': 0},
+    );
+  }
+}
+
+final class FakeDirectWriter implements NativeDirectWriter {
+  final List<(String, Uint8List)> writes = <(String, Uint8List)>[];
+
+  @override
+  Future<void> write(String sessionId, Uint8List bytes) async {
+    writes.add((sessionId, Uint8List.fromList(bytes)));
+  }
+}
+
+final class FakeRetainApi extends NativeTransportApi {
+  final List<RetainJobPayload> retained = <RetainJobPayload>[];
+  final List<bool> copies = <bool>[];
+  final List<String> released = <String>[];
+  int plainWrites = 0;
+
+  @override
+  Future<OpenConnectionResponse> openConnection(
+    EndpointPayload endpoint,
+  ) async {
+    return const OpenConnectionResponse(
+      sessionId: 'retain-0',
+      capabilities: CapabilityPayload(),
+    );
+  }
+
+  @override
+  Future<void> write(WritePayload payload) async {
+    plainWrites++;
+  }
+
+  @override
+  Future<String> retainJob(RetainJobPayload payload) async {
+    retained.add(payload);
+    return 'job-${retained.length}';
+  }
+
+  @override
+  Future<void> writeRetainedJob(RetainedJobPayload payload) async {
+    copies.add(payload.withSeparator);
+  }
+
+  @override
+  Future<void> releaseJob(RetainedJobPayload payload) async {
+    released.add(payload.jobId);
+  }
+
+  @override
+  Future<void> closeConnection(SessionPayload payload) async {}
+}
+
+final class FakeJobStreamApi extends NativeTransportApi {
+  final List<String> calls = <String>[];
+  int appendedBytes = 0;
+  int plainWrites = 0;
+
+  @override
+  Future<OpenConnectionResponse> openConnection(
+    EndpointPayload endpoint,
+  ) async {
+    return const OpenConnectionResponse(
+      sessionId: 'stream-session',
+      capabilities: CapabilityPayload(),
+    );
+  }
+
+  @override
+  Future<void> write(WritePayload payload) async {
+    plainWrites++;
+  }
+
+  @override
+  Future<String> beginJob(SessionPayload payload) async {
+    calls.add('begin');
+    return 'stream-1';
+  }
+
+  @override
+  Future<void> appendChunk(AppendChunkPayload payload) async {
+    calls.add('append');
+    appendedBytes += payload.bytes.length;
+  }
+
+  @override
+  Future<void> commitJob(JobStreamPayload payload) async {
+    calls.add('commit');
+  }
+
+  @override
+  Future<void> closeConnection(SessionPayload payload) async {}
+}
+
+/// Answers appendChunk the way the Linux plugin does once the job was
+/// aborted under it.
+final class FakeAbortedJobStreamApi extends FakeJobStreamApi {
+  int opens = 0;
+
+  @override
+  Future<OpenConnectionResponse> openConnection(
+    EndpointPayload endpoint,
+  ) {
+    opens++;
+    return super.openConnection(endpoint);
+  }
+
+  @override
+  Future<void> appendChunk(AppendChunkPayload payload) async {
+    calls.add('append');
+    throw PlatformException(code: 'job_aborted', message: 'Job was aborted.');
+  }
+
+  @override
+  Future<void> abortJob(JobStreamPayload payload) async {
+    calls.add('abort');
+  }
+}
+
+final class FakeBatchApi extends NativeTransportApi {
+  FakeBatchApi({required this.failJobOnFirstCall});
+
+  final int failJobOnFirstCall;
+  final List<int> batchCalls = <int>[];
+  int _sessionCounter = 0;
+
+  @override
+  Future<OpenConnectionResponse> openConnection(
+    EndpointPayload endpoint,
+  ) async {
+    return OpenConnectionResponse(
+      sessionId: 'batch-${_sessionCounter++}',
+      capabilities: const CapabilityPayload(),
+    );
+  }
+
+  @override
+  Future<WriteBatchResponse> writeBatch(WriteBatchPayload payload) async {
+    final failAt = batchCalls.isEmpty ? failJobOnFirstCall : -1;
+    batchCalls.add(payload.jobLengths.length);
+
+    final jobs = <BatchJobPayload>[];
+    var offset = 0;
+    for (var i = 0; i < payload.jobLengths.length; i++) {
+      final status = failAt < 0 || i < failAt
+          ? 'written'
+          : (i == failAt ? 'failed' : 'notSent');
+      jobs.add(
+        BatchJobPayload(
+          offset: offset,
+          length: payload.jobLengths[i],
+          status: status,
+        ),
+      );
+      offset += payload.jobLengths[i];
+    }
+    return WriteBatchResponse(jobs: jobs);
+  }
+
+  @override
+  Future<StatusPayload> readStatus(SessionPayload payload) async {
+    return const StatusPayload();
+  }
+
+  @override
+  Future<void> closeConnection(SessionPayload payload) async {}
+}
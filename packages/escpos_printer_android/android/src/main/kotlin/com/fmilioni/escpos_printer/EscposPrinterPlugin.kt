@@ -40,6 +40,7 @@ class EscposPrinterPlugin : FlutterPlugin, MethodCallHandler {
             when (call.method) {
                 "openConnection" -> handleOpenConnection(call, result)
                 "write" -> handleWrite(call, result)
+                "writeBatch" -> handleWriteBatch(call, result)
                 "readStatus" -> handleReadStatus(call, result)
                 "closeConnection" -> handleCloseConnection(call, result)
                 "getCapabilities" -> handleGetCapabilities(call, result)
@@ -82,6 +83,50 @@ class EscposPrinterPlugin : FlutterPlugin, MethodCallHandler {
         result.success(null)
     }
 
+    // Writes each job of the concatenated batch in order; the first failure marks that job
+    // "failed" and the remaining ones "notSent".
+    private fun handleWriteBatch(call: MethodCall, result: Result) {
+        val args = call.arguments as? Map<*, *> ?: throw IllegalArgumentException("writeBatch requires payload")
+        val sessionId = args["sessionId"] as? String ?: throw IllegalArgumentException("missing sessionId")
+        val payload = args["bytes"] as? ByteArray ?: throw IllegalArgumentException("missing bytes")
+        val jobLengths = (args["jobLengths"] as? List<*>)
+            ?.map { (it as? Number)?.toInt() ?: throw IllegalArgumentException("invalid jobLengths") }
+            ?: throw IllegalArgumentException("missing jobLengths")
+        require(jobLengths.all { it >= 0 } && jobLengths.sum() == payload.size) {
+            "jobLengths do not add up to the bytes length"
+        }
+
+        val connection = sessions[sessionId] ?: throw IllegalStateException("Session not found: $sessionId")
+        val jobs = mutableListOf<Map<String, Any>>()
+        var offset = 0
+        var bytesWritten = 0
+        var error: String? = null
+        for (length in jobLengths) {
+            val status = if (error != null) {
+                "notSent"
+            } else {
+                try {
+                    connection.write(payload.copyOfRange(offset, offset + length))
+                    bytesWritten += length
+                    "written"
+                } catch (failure: Exception) {
+                    error = failure.message ?: "Failed to write job"
+                    "failed"
+                }
+            }
+            jobs += mapOf("offset" to offset, "length" to length, "status" to status)
+            offset += length
+        }
+
+        result.success(
+            mapOf(
+                "jobs" to jobs,
+                "bytesWritten" to bytesWritten,
+                "error" to error,
+            ),
+        )
+    }
+
     private fun handleReadStatus(call: MethodCall, result: Result) {
         val args = call.arguments as? Map<*, *> ?: throw IllegalArgumentException("readStatus requires payload")
         val sessionId = args["sessionId"] as? String ?: throw IllegalArgumentException("missing sessionId")
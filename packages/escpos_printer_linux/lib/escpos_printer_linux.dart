@@ -1 +1,16 @@
 library;
+
+import 'package:escpos_printer_platform_interface/escpos_printer_platform_interface.dart';
+
+import 'src/linux_direct_writer.dart';
+
+export 'src/linux_direct_writer.dart';
+
+/// Dart side of the Linux implementation.
+final class EscposPrinterLinux {
+  /// Called by Flutter's plugin registrant. Lets direct writes go through
+  /// the plugin's C ABI; the library is only bound once an app opts in.
+  static void registerWith() {
+    NativeDirectWriter.opener ??= LinuxDirectWriter.open;
+  }
+}
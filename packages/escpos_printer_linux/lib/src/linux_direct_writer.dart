@@ -0,0 +1,170 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:escpos_printer_platform_interface/escpos_printer_platform_interface.dart';
+import 'package:flutter/services.dart';
+
+typedef _InitializeNative = IntPtr Function(Pointer<Void>);
+typedef _Initialize = int Function(Pointer<Void>);
+typedef _AllocateNative = Pointer<Uint8> Function(Size);
+typedef _Allocate = Pointer<Uint8> Function(int);
+typedef _FreeNative = Void Function(Pointer<Uint8>);
+typedef _Free = void Function(Pointer<Uint8>);
+typedef _WriteNative =
+    Int32 Function(Pointer<Uint8>, Size, Pointer<Uint8>, Size, Int64, Int64);
+typedef _Write =
+    int Function(Pointer<Uint8>, int, Pointer<Uint8>, int, int, int);
+
+/// [NativeDirectWriter] that calls the Linux plugin's C ABI
+/// (`escpos_printer_ffi.h`) through `dart:ffi`.
+///
+/// Bytes are copied once, into a buffer the plugin owns, and queued from
+/// the calling isolate. A plugin thread writes them and posts the result
+/// to a [ReceivePort], so neither the platform channel nor the GTK main
+/// thread is involved.
+final class LinuxDirectWriter implements NativeDirectWriter {
+  LinuxDirectWriter._(DynamicLibrary library)
+    : _allocate = library.lookupFunction<_AllocateNative, _Allocate>(
+        'escpos_printer_ffi_allocate',
+      ),
+      _free = library.lookupFunction<_FreeNative, _Free>(
+        'escpos_printer_ffi_free',
+      ),
+      _write = library.lookupFunction<_WriteNative, _Write>(
+        'escpos_printer_ffi_write',
+      );
+
+  /// Binds to the loaded plugin library, or returns `null` when it is not
+  /// loaded or has no C ABI.
+  static LinuxDirectWriter? open() {
+    try {
+      final library = DynamicLibrary.open('libescpos_printer_plugin.so');
+      final initialize = library
+          .lookupFunction<_InitializeNative, _Initialize>(
+            'escpos_printer_ffi_initialize',
+          );
+      if (initialize(NativeApi.postCObject.cast<Void>()) != 0) {
+        return null;
+      }
+      return LinuxDirectWriter._(library);
+    } on ArgumentError {
+      return null;
+    }
+  }
+
+  static const int _queued = 0;
+  static const int _invalidSession = -2;
+
+  final _Allocate _allocate;
+  final _Free _free;
+  final _Write _write;
+
+  final Map<int, Completer<void>> _pending = <int, Completer<void>>{};
+  int _nextRequest = 0;
+
+  /// Receives `[requestId, error, reconnected]` from the plugin; open from
+  /// the first write until [close].
+  ReceivePort? _replies;
+  bool _closed = false;
+
+  /// Rejects further writes and closes the reply port once the pending ones
+  /// have completed, so it no longer keeps the isolate alive.
+  void close() {
+    _closed = true;
+    _closeIfIdle();
+  }
+
+  @override
+  Future<void> write(String sessionId, Uint8List bytes) {
+    if (_closed) {
+      return Future<void>.error(
+        PlatformException(
+          code: 'writer_closed',
+          message: 'The direct writer was closed.',
+        ),
+      );
+    }
+    if (bytes.isEmpty) {
+      return Future<void>.value();
+    }
+
+    final id = utf8.encode(sessionId);
+    final session = _allocate(id.length);
+    final buffer = _allocate(bytes.length);
+    if (session == nullptr || buffer == nullptr) {
+      _free(session);
+      _free(buffer);
+      return Future<void>.error(
+        PlatformException(
+          code: 'out_of_memory',
+          message: 'Failed to allocate a native write buffer.',
+        ),
+      );
+    }
+    session.asTypedList(id.length).setAll(0, id);
+    buffer.asTypedList(bytes.length).setAll(0, bytes);
+
+    final replies = _replies ??= ReceivePort()..listen(_onReply);
+    final requestId = _nextRequest++;
+    final completer = Completer<void>();
+    _pending[requestId] = completer;
+    // The plugin owns buffer from here on, also when it rejects the write.
+    final result = _write(
+      session,
+      id.length,
+      buffer,
+      bytes.length,
+      requestId,
+      replies.sendPort.nativePort,
+    );
+    _free(session);
+    if (result != _queued) {
+      _pending.remove(requestId);
+      return Future<void>.error(
+        result == _invalidSession
+            ? PlatformException(
+                code: 'invalid_session',
+                message: 'Session not found.',
+              )
+            : PlatformException(
+                code: 'not_initialized',
+                message: 'The plugin C ABI is not initialized.',
+              ),
+      );
+    }
+    return completer.future;
+  }
+
+  void _onReply(Object? message) {
+    if (message case [
+      final int requestId,
+      final String? error,
+      final bool reconnected,
+    ]) {
+      final completer = _pending.remove(requestId);
+      if (error == null) {
+        completer?.complete();
+      } else {
+        // Same details as a failed channel write.
+        completer?.completeError(
+          PlatformException(
+            code: 'write_failed',
+            message: error,
+            details: <String, Object?>{'reconnected': reconnected},
+          ),
+        );
+      }
+      _closeIfIdle();
+    }
+  }
+
+  void _closeIfIdle() {
+    if (_closed && _pending.isEmpty) {
+      _replies?.close();
+      _replies = null;
+    }
+  }
+}
@@ -0,0 +1,188 @@
+// Exercises the device-node transport (device_writer.h) against stand-ins for a usblp printer: a FIFO with a slow
+// reader, a FIFO nobody drains, and a pty. Prints every check and exits non-zero if any failed.
+//
+//   device_stand_in_check
+
+#include "../device_writer.h"
+
+#include <fcntl.h>
+#include <linux/lp.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+int g_failures = 0;
+
+void Check(bool condition, const char *what)
+{
+    std::printf("%s %s\n", condition ? "ok  " : "FAIL", what);
+    if (!condition)
+    {
+        g_failures++;
+    }
+}
+
+std::vector<uint8_t> Pattern(size_t length)
+{
+    std::vector<uint8_t> bytes(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        bytes[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    return bytes;
+}
+
+// Reads everything from fd until the writer closes, slowly enough that the pipe fills and the writer has to poll.
+std::vector<uint8_t> DrainSlowly(int fd)
+{
+    std::vector<uint8_t> received;
+    uint8_t buffer[4096];
+    for (;;)
+    {
+        ssize_t got = read(fd, buffer, sizeof(buffer));
+        if (got > 0)
+        {
+            received.insert(received.end(), buffer, buffer + got);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        else if (got == 0)
+        {
+            return received;
+        }
+        else if (errno != EAGAIN && errno != EINTR)
+        {
+            return received;
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void CheckFifo(const std::string &directory)
+{
+    std::string path = directory + "/lp0";
+    Check(mkfifo(path.c_str(), 0600) == 0, "creates a FIFO stand-in");
+
+    // A FIFO opened for non-blocking writes needs a reader first.
+    int reader = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    std::string error;
+    int fd = escpos_printer::OpenDeviceFile(path, &error);
+    Check(fd >= 0, "opens the FIFO as a device");
+
+    std::vector<uint8_t> sent = Pattern(1024 * 1024);
+    std::vector<uint8_t> received;
+    std::thread drain([reader, &received]() { received = DrainSlowly(reader); });
+    bool ok = escpos_printer::WriteToDevice(fd, sent.data(), sent.size(), &error);
+    close(fd);
+    drain.join();
+    close(reader);
+    Check(ok, "writes 1 MiB through a full pipe");
+    Check(received == sent, "the reader gets every byte in order");
+
+    escpos_printer::LpStatus status;
+    fd = escpos_printer::OpenDeviceFile(path, &error);
+    Check(fd < 0, "refuses a FIFO without a reader");
+
+    reader = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    fd = escpos_printer::OpenDeviceFile(path, &error);
+    Check(!escpos_printer::ReadLpStatus(fd, &status), "a FIFO has no LPGETSTATUS");
+
+    // Nobody drains the pipe now, so the write stalls until cancelled.
+    std::atomic<bool> cancel{false};
+    std::thread canceller([&cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        cancel = true;
+    });
+    auto start = std::chrono::steady_clock::now();
+    ok = escpos_printer::WriteToDevice(fd, sent.data(), sent.size(), &error, &cancel);
+    auto waited = std::chrono::steady_clock::now() - start;
+    canceller.join();
+    Check(!ok && error == "Write was cancelled.", "a cancelled write fails");
+    Check(waited < std::chrono::milliseconds(200 + 4 * escpos_printer::kWriteCancelCheckMs), "and stops promptly");
+
+    start = std::chrono::steady_clock::now();
+    ok = escpos_printer::WriteToDevice(fd, sent.data(), sent.size(), &error);
+    waited = std::chrono::steady_clock::now() - start;
+    Check(!ok && error == "Timed out writing to device.", "a stalled write times out");
+    // The deadline is checked in whole milliseconds, so allow the last one to round down.
+    Check(waited >= std::chrono::milliseconds(escpos_printer::kDeviceWriteTimeoutMs - 1), "after kDeviceWriteTimeoutMs");
+
+    close(fd);
+    close(reader);
+    unlink(path.c_str());
+}
+
+void CheckPty()
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    Check(master >= 0 && grantpt(master) == 0 && unlockpt(master) == 0, "opens a pty");
+    std::string path = ptsname(master);
+
+    std::string error;
+    int fd = escpos_printer::OpenDeviceFile(path, &error);
+    Check(fd >= 0 && isatty(fd), "opens the pty as a terminal device");
+
+    std::vector<uint8_t> sent = Pattern(256);
+    Check(escpos_printer::WriteToDevice(fd, sent.data(), sent.size(), &error), "writes to the pty");
+    close(fd);
+
+    // The line discipline may still be cooking the bytes; give it a moment.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::vector<uint8_t> received(sent.size() * 2);
+    ssize_t got = read(master, received.data(), received.size());
+    Check(got > 0, "the other end receives the bytes");
+    close(master);
+}
+
+void CheckRegularFile(const std::string &directory)
+{
+    std::string path = directory + "/file";
+    close(open(path.c_str(), O_WRONLY | O_CREAT, 0600));
+    std::string error;
+    Check(escpos_printer::OpenDeviceFile(path, &error) < 0 && error == path + " is not a character device.", "refuses a regular file");
+    unlink(path.c_str());
+}
+
+void CheckLpStatus()
+{
+    escpos_printer::LpStatus ready = escpos_printer::DecodeLpStatus(LP_PSELECD | LP_PERRORP | LP_PBUSY);
+    Check(!ready.paper_out && !ready.offline, "selected with paper is ready");
+    escpos_printer::LpStatus empty = escpos_printer::DecodeLpStatus(LP_PSELECD | LP_POUTPA);
+    Check(empty.paper_out && !empty.offline, "LP_POUTPA is paper out");
+    escpos_printer::LpStatus deselected = escpos_printer::DecodeLpStatus(0);
+    Check(!deselected.paper_out && deselected.offline, "no LP_PSELECD is offline");
+}
+
+} // namespace
+
+int main()
+{
+    char directory[] = "/tmp/escpos_device_check_XXXXXX";
+    if (mkdtemp(directory) == nullptr)
+    {
+        std::perror("mkdtemp");
+        return 1;
+    }
+
+    CheckFifo(directory);
+    CheckPty();
+    CheckRegularFile(directory);
+    CheckLpStatus();
+
+    rmdir(directory);
+    std::printf("%d failed\n", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
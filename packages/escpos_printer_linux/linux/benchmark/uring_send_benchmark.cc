@@ -0,0 +1,267 @@
+// Compares blocking send() against UringWriter for many concurrent TCP sessions.
+//
+// Each session is a loopback connection drained by its own reader thread, standing in for a network printer. The
+// send() path writes the sessions one after another from a single thread, as the plugin's main thread does; the
+// io_uring path queues every write at once and lets the writer batch them. With a reader rate the sessions get small
+// socket buffers and drain at that speed, which is closer to real printers than an unthrottled loopback.
+//
+//   uring_send_benchmark [sessions] [megabytes per session] [write size in KiB] [reader KiB/s, 0 = unlimited]
+
+#include "../uring_writer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Sessions
+{
+    std::vector<int> writers;
+    std::vector<std::thread> readers;
+    std::atomic<size_t> received{0};
+};
+
+// Wall time until every byte was received, and how long the submitting thread was blocked in the write calls.
+struct Timing
+{
+    double total_seconds;
+    double caller_seconds;
+};
+
+size_t g_reader_rate = 0;
+
+double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool OpenSessions(int count, Sessions *sessions)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof(address);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, count) != 0 || getsockname(listener, reinterpret_cast<sockaddr *>(&address), &address_length) != 0)
+    {
+        std::perror("listen");
+        return false;
+    }
+
+    for (int index = 0; index < count; index++)
+    {
+        int writer = socket(AF_INET, SOCK_STREAM, 0);
+        if (writer < 0 || connect(writer, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            std::perror("connect");
+            return false;
+        }
+        int reader = accept(listener, nullptr, nullptr);
+        if (reader < 0)
+        {
+            std::perror("accept");
+            return false;
+        }
+
+        if (g_reader_rate > 0)
+        {
+            int buffer_size = 64 * 1024;
+            setsockopt(writer, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+            setsockopt(reader, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+        }
+
+        sessions->writers.push_back(writer);
+        sessions->readers.emplace_back([reader, sessions] {
+            std::vector<uint8_t> buffer(g_reader_rate > 0 ? 16 * 1024 : 256 * 1024);
+            auto start = std::chrono::steady_clock::now();
+            size_t total = 0;
+            for (;;)
+            {
+                ssize_t read_bytes = read(reader, buffer.data(), buffer.size());
+                if (read_bytes <= 0)
+                {
+                    break;
+                }
+                sessions->received += static_cast<size_t>(read_bytes);
+                total += static_cast<size_t>(read_bytes);
+                if (g_reader_rate > 0)
+                {
+                    std::this_thread::sleep_until(start + std::chrono::microseconds(total * 1000000 / g_reader_rate));
+                }
+            }
+            close(reader);
+        });
+    }
+
+    close(listener);
+    return true;
+}
+
+void CloseSessions(Sessions *sessions)
+{
+    for (int writer : sessions->writers)
+    {
+        shutdown(writer, SHUT_WR);
+        close(writer);
+    }
+    for (std::thread &reader : sessions->readers)
+    {
+        reader.join();
+    }
+}
+
+void WaitForReaders(const Sessions &sessions, size_t total)
+{
+    while (sessions.received.load() < total)
+    {
+        std::this_thread::yield();
+    }
+}
+
+Timing RunSend(int session_count, size_t per_session, const std::vector<uint8_t> &payload)
+{
+    Sessions sessions;
+    if (!OpenSessions(session_count, &sessions))
+    {
+        std::exit(1);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < per_session; offset += payload.size())
+    {
+        for (int writer : sessions.writers)
+        {
+            size_t sent = 0;
+            while (sent < payload.size())
+            {
+                ssize_t written = send(writer, payload.data() + sent, payload.size() - sent, MSG_NOSIGNAL);
+                if (written <= 0)
+                {
+                    std::perror("send");
+                    std::exit(1);
+                }
+                sent += static_cast<size_t>(written);
+            }
+        }
+    }
+    double caller_seconds = SecondsSince(start);
+    WaitForReaders(sessions, per_session * session_count);
+    Timing timing = {SecondsSince(start), caller_seconds};
+
+    CloseSessions(&sessions);
+    return timing;
+}
+
+Timing RunUring(escpos_printer::UringWriter *writer, bool zero_copy, int session_count, size_t per_session,
+                const std::vector<uint8_t> &payload)
+{
+    Sessions sessions;
+    if (!OpenSessions(session_count, &sessions))
+    {
+        std::exit(1);
+    }
+
+    std::mutex mutex;
+    std::condition_variable done_changed;
+    size_t pending = 0;
+    bool failed = false;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < per_session; offset += payload.size())
+    {
+        for (int fd : sessions.writers)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending++;
+            }
+            writer->WriteAsync(fd, payload.data(), payload.size(), zero_copy, [&](bool ok, const std::string &error) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!ok && !failed)
+                {
+                    std::fprintf(stderr, "%s\n", error.c_str());
+                    failed = true;
+                }
+                pending--;
+                done_changed.notify_one();
+            });
+        }
+    }
+    double caller_seconds = SecondsSince(start);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_changed.wait(lock, [&pending] { return pending == 0; });
+    }
+    if (failed)
+    {
+        std::exit(1);
+    }
+    WaitForReaders(sessions, per_session * session_count);
+    Timing timing = {SecondsSince(start), caller_seconds};
+
+    CloseSessions(&sessions);
+    return timing;
+}
+
+void Report(const char *name, int session_count, size_t per_session, Timing timing)
+{
+    double megabytes = static_cast<double>(per_session) * session_count / (1024.0 * 1024.0);
+    std::printf("%-18s %4d sessions %8.1f MiB %9.1f ms %9.1f MiB/s %9.1f ms blocked\n", name, session_count, megabytes,
+                timing.total_seconds * 1000.0, megabytes / timing.total_seconds, timing.caller_seconds * 1000.0);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int session_count = argc > 1 ? std::atoi(argv[1]) : 32;
+    size_t per_session = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8) * 1024 * 1024;
+    size_t write_size = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 256) * 1024;
+    g_reader_rate = (argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0) * 1024;
+    if (session_count <= 0 || per_session == 0 || write_size == 0)
+    {
+        std::fprintf(stderr, "usage: %s [sessions] [megabytes per session] [write size in KiB] [reader KiB/s]\n", argv[0]);
+        return 2;
+    }
+    per_session = (per_session + write_size - 1) / write_size * write_size;
+
+    std::vector<uint8_t> payload(write_size);
+    for (size_t index = 0; index < payload.size(); index++)
+    {
+        payload[index] = static_cast<uint8_t>(index * 31);
+    }
+
+    Report("send", session_count, per_session, RunSend(session_count, per_session, payload));
+
+    escpos_printer::UringWriter *writer = escpos_printer::UringWriter::Instance();
+    if (writer == nullptr)
+    {
+        std::printf("io_uring is not available on this kernel; only send() was measured.\n");
+        return 0;
+    }
+    Report("io_uring send", session_count, per_session, RunUring(writer, false, session_count, per_session, payload));
+    if (writer->SupportsZeroCopy())
+    {
+        Report("io_uring send_zc", session_count, per_session, RunUring(writer, true, session_count, per_session, payload));
+    }
+    else
+    {
+        std::printf("IORING_OP_SEND_ZC or buffer registration is unavailable; zero-copy was not measured.\n");
+    }
+    return 0;
+}
@@ -0,0 +1,278 @@
+#include "capability_probe.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace escpos_printer
+{
+
+namespace
+{
+
+enum class ReplyKind
+{
+    kRealtimeStatus,
+    kTypeId,
+    kModel,
+    kFirmwareVersion,
+    kManufacturer,
+};
+
+struct ProbeQuery
+{
+    uint8_t bytes[3];
+    ReplyKind kind;
+};
+
+constexpr ProbeQuery kQueries[] = {
+    {{0x10, 0x04, 0x01}, ReplyKind::kRealtimeStatus}, {{0x1D, 0x49, 0x02}, ReplyKind::kTypeId},
+    {{0x1D, 0x49, 0x43}, ReplyKind::kModel},          {{0x1D, 0x49, 0x41}, ReplyKind::kFirmwareVersion},
+    {{0x1D, 0x49, 0x42}, ReplyKind::kManufacturer},
+};
+
+constexpr size_t kQueryCount = sizeof(kQueries) / sizeof(kQueries[0]);
+
+// GS I text replies are framed as 0x5F, the text, NUL.
+constexpr uint8_t kTextReplyHeader = 0x5F;
+
+// Printer text ends up in a tab-separated file and in method channel maps.
+std::string Sanitize(const std::string &value)
+{
+    std::string out = value;
+    for (char &c : out)
+    {
+        if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F)
+        {
+            c = ' ';
+        }
+    }
+    size_t begin = out.find_first_not_of(' ');
+    size_t end = out.find_last_not_of(' ');
+    return begin == std::string::npos ? std::string() : out.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> SplitTabs(const std::string &line)
+{
+    std::vector<std::string> fields;
+    std::string field;
+    std::istringstream in(line);
+    while (std::getline(in, field, '\t'))
+    {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+} // namespace
+
+std::vector<uint8_t> CapabilityProbe::Query() const
+{
+    if (Done())
+    {
+        return std::vector<uint8_t>();
+    }
+    const ProbeQuery &query = kQueries[step_];
+    return std::vector<uint8_t>(query.bytes, query.bytes + sizeof(query.bytes));
+}
+
+bool CapabilityProbe::Feed(const uint8_t *bytes, size_t length)
+{
+    for (size_t index = 0; index < length && !Done(); index++)
+    {
+        uint8_t byte = bytes[index];
+        switch (kQueries[step_].kind)
+        {
+        case ReplyKind::kRealtimeStatus:
+            // Bits 1 and 4 are always set and bits 0 and 7 always clear in a DLE EOT 1 reply.
+            if ((byte & 0x93) == 0x12)
+            {
+                info_.responsive = true;
+                info_.supports_realtime_status = true;
+                Advance();
+                return true;
+            }
+            break;
+        case ReplyKind::kTypeId:
+            if ((byte & 0x90) == 0)
+            {
+                bool has_cutter = (byte & 0x02) != 0;
+                info_.supports_partial_cut = has_cutter;
+                info_.supports_full_cut = has_cutter;
+                Advance();
+                return true;
+            }
+            break;
+        default:
+            if (reply_.empty() && byte != kTextReplyHeader)
+            {
+                break;
+            }
+            if (byte != 0)
+            {
+                reply_.push_back(byte);
+                break;
+            }
+            {
+                std::string text = Sanitize(std::string(reply_.begin() + 1, reply_.end()));
+                ReplyKind kind = kQueries[step_].kind;
+                (kind == ReplyKind::kModel ? info_.model : kind == ReplyKind::kFirmwareVersion ? info_.firmware_version : info_.manufacturer) = text;
+            }
+            Advance();
+            return true;
+        }
+    }
+    return false;
+}
+
+void CapabilityProbe::Timeout()
+{
+    if (step_ == 0)
+    {
+        // No realtime reply: the link is write-only or the printer does not speak ESC/POS queries.
+        step_ = kQueryCount;
+        reply_.clear();
+        return;
+    }
+    Advance();
+}
+
+bool CapabilityProbe::Done() const
+{
+    return step_ >= kQueryCount;
+}
+
+void CapabilityProbe::Advance()
+{
+    step_++;
+    reply_.clear();
+}
+
+CapabilityCache &CapabilityCache::Instance()
+{
+    static CapabilityCache cache;
+    return cache;
+}
+
+bool CapabilityCache::Find(const std::string &key, PrinterInfo *out)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Load();
+    auto iterator = entries_.find(Sanitize(key));
+    if (iterator == entries_.end())
+    {
+        return false;
+    }
+    *out = iterator->second;
+    return true;
+}
+
+void CapabilityCache::Store(const std::string &key, const PrinterInfo &info)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Load();
+    entries_[Sanitize(key)] = info;
+    while (entries_.size() > kMaxEntries)
+    {
+        auto oldest = std::min_element(entries_.begin(), entries_.end(),
+                                       [](const auto &a, const auto &b) { return a.second.probed_at < b.second.probed_at; });
+        entries_.erase(oldest);
+    }
+    Save();
+}
+
+void CapabilityCache::Load()
+{
+    if (loaded_)
+    {
+        return;
+    }
+    loaded_ = true;
+
+    const char *cache_home = std::getenv("XDG_CACHE_HOME");
+    const char *home = std::getenv("HOME");
+    if (cache_home != nullptr && cache_home[0] == '/')
+    {
+        path_ = std::string(cache_home) + "/escpos_printer";
+    }
+    else if (home != nullptr && home[0] == '/')
+    {
+        path_ = std::string(home) + "/.cache/escpos_printer";
+    }
+    else
+    {
+        // Nowhere to persist; the cache still lasts for the process.
+        return;
+    }
+    path_ += "/capabilities.tsv";
+
+    // key, probed_at, flags, model, firmware version, manufacturer. Flags are eight 0/1 characters: responsive,
+    // partial cut, full cut, drawer kick, realtime status, QR code, barcode, image.
+    std::ifstream in(path_);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::vector<std::string> fields = SplitTabs(line);
+        if (fields.size() < 3 || fields[2].size() != 8)
+        {
+            continue;
+        }
+        PrinterInfo info;
+        info.probed_at = std::strtoll(fields[1].c_str(), nullptr, 10);
+        const std::string &flags = fields[2];
+        info.responsive = flags[0] == '1';
+        info.supports_partial_cut = flags[1] == '1';
+        info.supports_full_cut = flags[2] == '1';
+        info.supports_drawer_kick = flags[3] == '1';
+        info.supports_realtime_status = flags[4] == '1';
+        info.supports_qr_code = flags[5] == '1';
+        info.supports_barcode = flags[6] == '1';
+        info.supports_image = flags[7] == '1';
+        info.model = fields.size() > 3 ? fields[3] : std::string();
+        info.firmware_version = fields.size() > 4 ? fields[4] : std::string();
+        info.manufacturer = fields.size() > 5 ? fields[5] : std::string();
+        entries_[fields[0]] = info;
+    }
+}
+
+void CapabilityCache::Save()
+{
+    if (path_.empty())
+    {
+        return;
+    }
+
+    std::string directory = path_.substr(0, path_.rfind('/'));
+    mkdir(directory.substr(0, directory.rfind('/')).c_str(), 0700);
+    mkdir(directory.c_str(), 0700);
+
+    // Written next to the file and renamed over it, so a crash never leaves a torn cache.
+    std::string temporary = path_ + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out)
+        {
+            return;
+        }
+        for (const auto &entry : entries_)
+        {
+            const PrinterInfo &info = entry.second;
+            out << entry.first << '\t' << info.probed_at << '\t' << info.responsive << info.supports_partial_cut << info.supports_full_cut
+                << info.supports_drawer_kick << info.supports_realtime_status << info.supports_qr_code << info.supports_barcode
+                << info.supports_image << '\t' << Sanitize(info.model) << '\t' << Sanitize(info.firmware_version) << '\t'
+                << Sanitize(info.manufacturer) << '\n';
+        }
+        if (!out.flush())
+        {
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    std::rename(temporary.c_str(), path_.c_str());
+}
+
+} // namespace escpos_printer
@@ -0,0 +1,98 @@
+#ifndef ESCPOS_PRINTER_CAPABILITY_PROBE_H_
+#define ESCPOS_PRINTER_CAPABILITY_PROBE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace escpos_printer
+{
+
+// What a printer reported about itself, or the assumed defaults when it never answered.
+struct PrinterInfo
+{
+    bool responsive = false;
+    bool supports_partial_cut = true;
+    bool supports_full_cut = true;
+    bool supports_drawer_kick = true;
+    bool supports_realtime_status = false;
+    // Never probed: ESC/POS has no query for these, so they keep the defaults.
+    bool supports_qr_code = true;
+    bool supports_barcode = true;
+    bool supports_image = true;
+    std::string model;
+    std::string firmware_version;
+    std::string manufacturer;
+    // Unix time of the probe that produced this entry.
+    int64_t probed_at = 0;
+};
+
+// Asks a printer for its identity and features, one query at a time.
+//
+// The caller writes Query(), feeds every received byte to Feed() and calls Timeout() when no complete reply arrived
+// within kReplyTimeoutMs; both move on to the next query. Queries are DLE EOT 1 (does the printer answer at all),
+// GS I 2 (type ID: autocutter fitted) and GS I 67/65/66 (model name, firmware version, manufacturer). When the
+// first one goes unanswered the printer is treated as write-only and probing stops.
+class CapabilityProbe
+{
+  public:
+    static constexpr int kReplyTimeoutMs = 500;
+
+    // Bytes of the current query; empty once probing is complete.
+    std::vector<uint8_t> Query() const;
+
+    // Consumes received bytes. Returns true when they completed the reply to the current query.
+    bool Feed(const uint8_t *bytes, size_t length);
+
+    void Timeout();
+
+    bool Done() const;
+
+    const PrinterInfo &Result() const
+    {
+        return info_;
+    }
+
+  private:
+    void Advance();
+
+    size_t step_ = 0;
+    std::vector<uint8_t> reply_;
+    PrinterInfo info_;
+};
+
+// Probe results kept on disk per device identity (USB VID/PID/serial, MAC address, host), so later connections get
+// them without probing. The file lives in $XDG_CACHE_HOME/escpos_printer (or ~/.cache/escpos_printer) and keeps the
+// kMaxEntries most recently probed devices.
+class CapabilityCache
+{
+  public:
+    static constexpr size_t kMaxEntries = 256;
+
+    static CapabilityCache &Instance();
+
+    bool Find(const std::string &key, PrinterInfo *out);
+    void Store(const std::string &key, const PrinterInfo &info);
+
+    CapabilityCache(const CapabilityCache &) = delete;
+    CapabilityCache &operator=(const CapabilityCache &) = delete;
+
+  private:
+    CapabilityCache() = default;
+
+    void Load();
+    void Save();
+
+    std::mutex mutex_;
+    bool loaded_ = false;
+    std::string path_;
+    std::unordered_map<std::string, PrinterInfo> entries_;
+};
+
+} // namespace escpos_printer
+
+#endif // ESCPOS_PRINTER_CAPABILITY_PROBE_H_
@@ -0,0 +1,48 @@
+#ifndef ESCPOS_PRINTER_DART_MESSAGE_H_
+#define ESCPOS_PRINTER_DART_MESSAGE_H_
+
+#include <cstdint>
+
+namespace escpos_printer
+{
+
+// The part of the Dart VM's message ABI (Dart_CObject in the SDK's dart_native_api.h) used to post write completions
+// to a Dart port. Dart passes NativeApi.postCObject to the plugin when it initializes the C ABI, so the plugin builds
+// without the Dart SDK's headers or its dynamically linked API.
+//
+// Type values and the member layout must stay as in the SDK. Only the members the plugin sets are named; padding
+// makes the union as large as the SDK's.
+enum DartMessageType : int32_t
+{
+    kDartMessageNull = 0,
+    kDartMessageBool = 1,
+    kDartMessageInt32 = 2,
+    kDartMessageInt64 = 3,
+    kDartMessageDouble = 4,
+    kDartMessageString = 5,
+    kDartMessageArray = 6,
+};
+
+struct DartMessage
+{
+    DartMessageType type;
+    union
+    {
+        bool as_bool;
+        int64_t as_int64;
+        const char *as_string;
+        struct
+        {
+            intptr_t length;
+            DartMessage **values;
+        } as_array;
+        unsigned char padding[40];
+    } value;
+};
+
+// Dart_PostCObject: copies message and queues it for port. Returns false when the port is closed.
+using DartPostMessage = bool (*)(int64_t port, DartMessage *message);
+
+} // namespace escpos_printer
+
+#endif // ESCPOS_PRINTER_DART_MESSAGE_H_
@@ -0,0 +1,127 @@
+#include "device_writer.h"
+
+#include <fcntl.h>
+#include <linux/lp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace escpos_printer
+{
+
+namespace
+{
+
+std::string ErrnoText(const std::string &context)
+{
+    return context + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+int OpenDeviceFile(const std::string &path, std::string *error)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        *error = ErrnoText("Failed to open " + path);
+        return -1;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !(S_ISCHR(info.st_mode) || S_ISFIFO(info.st_mode)))
+    {
+        close(fd);
+        *error = path + " is not a character device.";
+        return -1;
+    }
+    return fd;
+}
+
+bool WriteCancelled(const std::atomic<bool> *cancel, std::string *error)
+{
+    if (cancel == nullptr || !cancel->load())
+    {
+        return false;
+    }
+    *error = "Write was cancelled.";
+    return true;
+}
+
+bool WriteToDevice(int fd, const uint8_t *bytes, size_t length, std::string *error, const std::atomic<bool> *cancel)
+{
+    size_t offset = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kDeviceWriteTimeoutMs);
+    while (offset < length)
+    {
+        if (WriteCancelled(cancel, error))
+        {
+            return false;
+        }
+        ssize_t written = write(fd, bytes + offset, length - offset);
+        if (written > 0)
+        {
+            offset += static_cast<size_t>(written);
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kDeviceWriteTimeoutMs);
+            continue;
+        }
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            *error = ErrnoText("Failed to write to device");
+            return false;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0)
+        {
+            *error = "Timed out writing to device.";
+            return false;
+        }
+
+        pollfd descriptor = {fd, POLLOUT, 0};
+        int ready = poll(&descriptor, 1, static_cast<int>(std::min<int64_t>(remaining, kWriteCancelCheckMs)));
+        if (ready < 0 && errno != EINTR)
+        {
+            *error = ErrnoText("Failed to wait for device");
+            return false;
+        }
+        if (ready > 0 && (descriptor.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0)
+        {
+            *error = "Device was disconnected.";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+LpStatus DecodeLpStatus(int lines)
+{
+    LpStatus status;
+    status.paper_out = (lines & LP_POUTPA) != 0;
+    status.offline = (lines & LP_PSELECD) == 0;
+    return status;
+}
+
+bool ReadLpStatus(int fd, LpStatus *out)
+{
+    int lines = 0;
+    if (ioctl(fd, LPGETSTATUS, &lines) != 0)
+    {
+        return false;
+    }
+    *out = DecodeLpStatus(lines);
+    return true;
+}
+
+} // namespace escpos_printer
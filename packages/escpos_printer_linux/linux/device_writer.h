@@ -0,0 +1,44 @@
+#ifndef ESCPOS_PRINTER_DEVICE_WRITER_H_
+#define ESCPOS_PRINTER_DEVICE_WRITER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace escpos_printer
+{
+
+// A device write fails when the device accepts no bytes for this long.
+constexpr int kDeviceWriteTimeoutMs = 4000;
+
+// Paced device and serial writes check whether they were cancelled at least this often.
+constexpr int kWriteCancelCheckMs = 50;
+
+// Opens a printer device node (/dev/usb/lp*, a serial port) for non-blocking writes. FIFOs are accepted as stand-ins.
+// Returns the fd, or -1 with error set.
+int OpenDeviceFile(const std::string &path, std::string *error);
+
+// Writes to a non-blocking device fd, waiting in poll() while it is full. The deadline restarts after every accepted
+// chunk, so a slow printer keeps going and a stalled one fails after kDeviceWriteTimeoutMs. Gives up once cancel is
+// set.
+bool WriteToDevice(int fd, const uint8_t *bytes, size_t length, std::string *error, const std::atomic<bool> *cancel = nullptr);
+
+// Sets error and returns true when cancel is set.
+bool WriteCancelled(const std::atomic<bool> *cancel, std::string *error);
+
+// The parallel port status lines usblp emulates for LPGETSTATUS. They carry no cover, cutter or drawer state.
+struct LpStatus
+{
+    bool paper_out = false;
+    bool offline = false;
+};
+
+LpStatus DecodeLpStatus(int lines);
+
+// Reads the status lines of fd. Returns false for devices without LPGETSTATUS (serial ports, FIFOs).
+bool ReadLpStatus(int fd, LpStatus *out);
+
+} // namespace escpos_printer
+
+#endif // ESCPOS_PRINTER_DEVICE_WRITER_H_
@@ -1,9 +1,23 @@
 #include "include/escpos_printer/escpos_printer_plugin.h"
+#include "include/escpos_printer/escpos_printer_ffi.h"
+
+#include "capability_probe.h"
+#include "dart_message.h"
+#include "device_writer.h"
+#include "printer_profiles.h"
+#include "uring_writer.h"
+#include "usb_input_reader.h"
 
 #include <flutter_linux/flutter_linux.h>
 #include <gio/gio.h>
+#include <dirent.h>
+#include <fcntl.h>
 #include <libusb-1.0/libusb.h>
+#include <poll.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <termios.h>
 #include <unistd.h>
 
 #include <bluetooth/bluetooth.h>
@@ -11,16 +25,29 @@
 
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cctype>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #define ESCPOS_PRINTER_PLUGIN(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), escpos_printer_plugin_get_type(), EscposPrinterPlugin))
@@ -40,8 +67,160 @@ enum class SessionKind
     kWifi,
     kBluetooth,
     kUsb,
+    // usblp node (/dev/usb/lp*) or any other writable character device, opened by path.
+    kDevice,
+    // Serial port (/dev/ttyS*, /dev/ttyUSB*, /dev/rfcomm*): a device path that is a terminal, configured with termios.
+    kTty,
+};
+
+// Bytes a serial write may run ahead of the line rate, roughly a UART FIFO.
+constexpr size_t kTtyBurstBytes = 64;
+
+// A cached capability entry younger than this is used without probing the printer again, so reconnect loops do not
+// query it every time.
+constexpr int64_t kCapabilityRevalidateSeconds = 600;
+
+// TCP connect timeout when openConnection gives no timeoutMs.
+constexpr int kConnectTimeoutMs = 5000;
+
+// A failed write reconnects the session up to kReconnectAttempts times, waiting kReconnectBaseDelayMs before the
+// first attempt and twice as long before each further one.
+constexpr int kReconnectAttempts = 3;
+constexpr int kReconnectBaseDelayMs = 250;
+
+// TCP sessions give up on unacknowledged data after kTcpUserTimeoutMs and send keepalive probes after
+// kTcpKeepIdleSeconds of silence, kTcpKeepIntervalSeconds apart, so a printer that lost power is noticed in seconds.
+constexpr unsigned kTcpUserTimeoutMs = 5000;
+constexpr int kTcpKeepIdleSeconds = 3;
+constexpr int kTcpKeepIntervalSeconds = 1;
+constexpr int kTcpKeepCount = 3;
+
+// The link watcher checks every session this often, and reports a TCP session as degraded when data has waited this
+// long for an acknowledgement.
+constexpr guint kLinkWatchIntervalMs = 1000;
+constexpr uint32_t kDegradedAckMs = 1500;
+
+// Discovery deadline when searchPrinters or startDiscovery gives no timeoutMs, and the longest a BlueZ query may take.
+constexpr int kDiscoveryTimeoutMs = 8000;
+constexpr int kBluetoothQueryTimeoutMs = 2500;
+
+// How often a running capability probe checks for reply bytes.
+constexpr guint kProbePollMs = 20;
+
+// Bytes of retained jobs (job plus separator) one session may hold.
+constexpr size_t kMaxRetainedBytes = 32 * 1024 * 1024;
+
+// Ring buffer of a job stream. appendChunk waits for room once it is full, so a job of any size needs this much.
+constexpr size_t kJobRingBytes = 256 * 1024;
+
+// Most the drainer writes at once, so an abort waits for at most this much to reach a slow link.
+constexpr size_t kJobSpanBytes = 4 * 1024;
+
+enum class LinkState
+{
+    kConnected,
+    // Still open, but the printer is slow to acknowledge (retransmissions, unanswered keepalives).
+    kDegraded,
+    kLost,
+};
+
+// Main-thread side of a USB session's bulk IN endpoint: at most one readBytes call waits for data or its timeout.
+struct UsbInput
+{
+    std::unique_ptr<escpos_printer::UsbInputReader> reader;
+    FlMethodCall *pending_call = nullptr;
+    size_t pending_max_bytes = 0;
+    guint pending_timeout = 0;
+    // Set while a capability probe waits for its reply; bytes arriving then are the probe's, not readBytes'.
+    bool probing = false;
+};
+
+// A job kept on the native side by retainJob so it can be written again without crossing the channel. bytes holds
+// the job followed by its separator, so a copy with separator is a single write.
+struct RetainedJob
+{
+    std::vector<uint8_t> bytes;
+    size_t job_length = 0;
+};
+
+// A job sent in chunks (beginJob, appendChunk, commitJob). Chunks are copied into the ring on the main thread and a
+// drainer thread writes them to the printer, so memory stays at kJobRingBytes however long the job is.
+struct WriteTurn;
+
+struct JobStream
+{
+    std::string id;
+    std::string session_id;
+    std::thread drainer;
+    // The session's write turn, which the drainer holds from its first span until the stream ends.
+    WriteTurn *write_turn = nullptr;
+    // Set with aborted; stops the span being written and a drainer waiting for the turn.
+    std::atomic<bool> stop{false};
+
+    // Guards everything below except the calls.
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<uint8_t> ring = std::vector<uint8_t>(kJobRingBytes);
+    size_t head = 0;
+    size_t size = 0;
+    bool committed = false;
+    bool aborted = false;
+    bool failed = false;
+    bool finished = false;
+    std::string error;
+
+    // Calls answered later, main thread only: an appendChunk waiting for room (with its chunk and how much of it is
+    // in the ring) and a commitJob waiting for the drainer.
+    FlMethodCall *append_call = nullptr;
+    FlValue *append_chunk = nullptr;
+    size_t append_offset = 0;
+    FlMethodCall *commit_call = nullptr;
+};
+
+// A write queued through escpos_printer_ffi_write: a buffer the plugin owns and where to post its completion.
+struct DirectWrite
+{
+    uint8_t *bytes = nullptr;
+    size_t length = 0;
+    int64_t request_id = 0;
+    int64_t port = 0;
+};
+
+// The right to write to a session's printer or replace its link. The session writer holds it for a task (a write and
+// the reconnects after it). A flag rather than a mutex, so that whoever takes it can give it back from another
+// callback. closing makes waiting takers give up.
+struct WriteTurn
+{
+    std::mutex mutex;
+    std::condition_variable released;
+    bool taken = false;
+    bool closing = false;
 };
 
+struct NativeConnection;
+
+// Work for a session's writer thread. run is called holding the write turn; cancel instead when the session closes
+// first.
+struct WriteTask
+{
+    std::function<void(NativeConnection *)> run;
+    std::function<void(const char *)> cancel;
+};
+
+// Runs a session's writes in order on its own thread: write, writeBatch and writeRetainedJob calls and direct writes
+// from Dart. After a failed write the thread also reconnects the link, so neither the main thread nor the Dart isolate
+// waits for the printer or for a reconnect.
+struct SessionWriter
+{
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<WriteTask> queue;
+    bool stopping = false;
+};
+
+// The link fields (fd through tty_bytes_per_second) change only while the write turn is held, and then under
+// link_mutex too: the turn's holder reads them freely, anyone else takes link_mutex. kind and use_uring are set once.
 struct NativeConnection
 {
     SessionKind kind;
@@ -51,27 +230,163 @@ struct NativeConnection
     libusb_device_handle *usb_handle = nullptr;
     int usb_interface_number = -1;
     uint8_t usb_endpoint_out = 0;
+    uint8_t usb_endpoint_in = 0;
+    std::shared_ptr<UsbInput> usb_input;
+
+    // Line rate of a kTty session; writes are paced to it. 0 when the speed is unknown.
+    size_t tty_bytes_per_second = 0;
+
+    // Socket writes go through the shared UringWriter instead of send() on the calling thread.
+    bool use_uring = false;
+
+    std::mutex link_mutex;
+    WriteTurn write_turn;
+    // Set first thing when the session closes; device and serial writes in progress stop at it.
+    std::atomic<bool> closing{false};
+
+    // The openConnection args, kept to reopen the link after a write error. Read by the session writer, which the
+    // main thread stops before dropping them.
+    FlValue *open_args = nullptr;
+
+    // Last state reported on the connection events channel.
+    LinkState link_state = LinkState::kConnected;
+
+    // Known model of a USB printer, matched by VID/PID.
+    const escpos_printer::PrinterProfile *profile = nullptr;
+
+    // Stable identity used as the capability cache key; empty for sessions that cannot be probed.
+    std::string device_key;
+    escpos_printer::PrinterInfo printer_info;
+    // "assumed", "cached" or "probed".
+    std::string capability_source = "assumed";
+
+    // Jobs kept by retainJob, by job ID, and their total size. Dropped with the session; a copy being written keeps
+    // its job alive until it is done.
+    std::unordered_map<std::string, std::shared_ptr<const RetainedJob>> retained_jobs;
+    size_t retained_bytes = 0;
+    uint64_t next_retained_job = 1;
+
+    // The session's open job stream, if any, and the ID for the next one.
+    std::shared_ptr<JobStream> job_stream;
+    uint64_t next_job_stream = 1;
+
+    // Started when the session opens; also listed in g_session_writers.
+    std::shared_ptr<SessionWriter> writer;
 };
 
 std::unordered_map<std::string, std::unique_ptr<NativeConnection>> g_sessions;
 std::mutex g_sessions_mutex;
 std::atomic<int64_t> g_session_counter{1};
 
+// Writers of the open sessions, for escpos_printer_ffi_write. Kept apart from g_sessions so the Dart isolate never
+// waits for g_sessions_mutex; this lock is only held to find, add or remove an entry.
+std::unordered_map<std::string, std::shared_ptr<SessionWriter>> g_session_writers;
+std::mutex g_session_writers_mutex;
+
+// Dart_PostCObject, from escpos_printer_ffi_initialize.
+std::atomic<escpos_printer::DartPostMessage> g_post_message{nullptr};
+
+// Connection state events for Dart; only used on the main thread.
+FlEventChannel *g_connection_events = nullptr;
+bool g_connection_events_listening = false;
+guint g_link_watch = 0;
+
+struct DiscoveryRun;
+
+// Discovery events for Dart and the runs that feed them; only used on the main thread.
+FlEventChannel *g_discovery_events = nullptr;
+bool g_discovery_events_listening = false;
+std::unordered_map<std::string, std::shared_ptr<DiscoveryRun>> g_discoveries;
+
 FlMethodResponse *MakeErrorResponse(const std::string &code, const std::string &message)
 {
     return FL_METHOD_RESPONSE(fl_method_error_response_new(code.c_str(), message.c_str(), nullptr));
 }
 
-FlValue *MakeCapabilitiesValue(bool realtime_status = false)
+gboolean RunMainLoopTask(gpointer data)
+{
+    (*static_cast<std::function<void()> *>(data))();
+    return G_SOURCE_REMOVE;
+}
+
+void DeleteMainLoopTask(gpointer data)
+{
+    delete static_cast<std::function<void()> *>(data);
+}
+
+// Runs task on the main thread. Callable from any thread; FlMethodCall and FlValue references taken on the main thread
+// are dropped through here.
+void RunOnMainLoop(std::function<void()> task)
+{
+    g_idle_add_full(G_PRIORITY_DEFAULT, RunMainLoopTask, new std::function<void()>(std::move(task)), DeleteMainLoopTask);
+}
+
+const char *ImageFormatName(escpos_printer::ImageFormat format)
+{
+    switch (format)
+    {
+    case escpos_printer::ImageFormat::kColumn24:
+        return "column24";
+    case escpos_printer::ImageFormat::kColumn8:
+        return "column8";
+    case escpos_printer::ImageFormat::kRaster:
+        break;
+    }
+    return "raster";
+}
+
+FlValue *MakeProfileValue(const escpos_printer::PrinterProfile &profile)
+{
+    g_autoptr(FlValue) code_pages = fl_value_new_list();
+    for (int table = 0; table < 64; table++)
+    {
+        if ((profile.code_pages >> table) & 1)
+        {
+            fl_value_append_take(code_pages, fl_value_new_int(table));
+        }
+    }
+
+    g_autoptr(FlValue) value = fl_value_new_map();
+    fl_value_set_string(value, "name", fl_value_new_string(profile.name));
+    fl_value_set_string(value, "dotsPerLine", fl_value_new_int(profile.dots_per_line));
+    fl_value_set_string(value, "fontAColumns", fl_value_new_int(profile.font_a_columns));
+    fl_value_set_string(value, "fontBColumns", fl_value_new_int(profile.font_b_columns));
+    fl_value_set_string(value, "maxRasterWidth", fl_value_new_int(profile.max_raster_width));
+    fl_value_set_string(value, "hasCutter", fl_value_new_bool(profile.has_cutter));
+    fl_value_set_string(value, "nvGraphicsKb", fl_value_new_int(profile.nv_graphics_kb));
+    fl_value_set_string(value, "codePages", fl_value_ref(code_pages));
+    fl_value_set_string(value, "imageFormat", fl_value_new_string(ImageFormatName(profile.image_format)));
+    return fl_value_ref(value);
+}
+
+FlValue *MakeCapabilitiesValue(const NativeConnection &connection)
 {
+    const escpos_printer::PrinterInfo &info = connection.printer_info;
     g_autoptr(FlValue) caps = fl_value_new_map();
-    fl_value_set_string(caps, "supportsPartialCut", fl_value_new_bool(true));
-    fl_value_set_string(caps, "supportsFullCut", fl_value_new_bool(true));
-    fl_value_set_string(caps, "supportsDrawerKick", fl_value_new_bool(true));
-    fl_value_set_string(caps, "supportsRealtimeStatus", fl_value_new_bool(realtime_status));
-    fl_value_set_string(caps, "supportsQrCode", fl_value_new_bool(true));
-    fl_value_set_string(caps, "supportsBarcode", fl_value_new_bool(true));
-    fl_value_set_string(caps, "supportsImage", fl_value_new_bool(true));
+    fl_value_set_string(caps, "supportsPartialCut", fl_value_new_bool(info.supports_partial_cut));
+    fl_value_set_string(caps, "supportsFullCut", fl_value_new_bool(info.supports_full_cut));
+    fl_value_set_string(caps, "supportsDrawerKick", fl_value_new_bool(info.supports_drawer_kick));
+    fl_value_set_string(caps, "supportsRealtimeStatus", fl_value_new_bool(info.supports_realtime_status));
+    fl_value_set_string(caps, "supportsQrCode", fl_value_new_bool(info.supports_qr_code));
+    fl_value_set_string(caps, "supportsBarcode", fl_value_new_bool(info.supports_barcode));
+    fl_value_set_string(caps, "supportsImage", fl_value_new_bool(info.supports_image));
+    fl_value_set_string(caps, "source", fl_value_new_string(connection.capability_source.c_str()));
+    if (!info.model.empty())
+    {
+        fl_value_set_string(caps, "model", fl_value_new_string(info.model.c_str()));
+    }
+    if (!info.firmware_version.empty())
+    {
+        fl_value_set_string(caps, "firmwareVersion", fl_value_new_string(info.firmware_version.c_str()));
+    }
+    if (!info.manufacturer.empty())
+    {
+        fl_value_set_string(caps, "manufacturer", fl_value_new_string(info.manufacturer.c_str()));
+    }
+    if (connection.profile != nullptr)
+    {
+        fl_value_set_string(caps, "profile", MakeProfileValue(*connection.profile));
+    }
 
     return fl_value_ref(caps);
 }
@@ -137,6 +452,18 @@ bool ReadOptionalInt(FlValue *map, const char *key, int *out)
     return true;
 }
 
+bool ReadOptionalString(FlValue *map, const char *key, std::string *out)
+{
+    FlValue *value = fl_value_lookup_string(map, key);
+    if (IsNullValue(value) || fl_value_get_type(value) != FL_VALUE_TYPE_STRING)
+    {
+        return false;
+    }
+
+    *out = fl_value_get_string(value);
+    return true;
+}
+
 bool ShouldDiscoverTransport(FlValue *args, const char *transport)
 {
     if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
@@ -177,7 +504,10 @@ bool ShouldDiscoverTransport(FlValue *args, const char *transport)
     return false;
 }
 
-bool FindUsbBulkOutInConfig(const libusb_config_descriptor *config, int preferred_interface, int *interface_number, uint8_t *endpoint_out)
+// Finds the first bulk OUT endpoint and, when endpoint_in is given, a bulk IN endpoint on the same interface setting
+// (0 when the printer has none).
+bool FindUsbBulkOutInConfig(const libusb_config_descriptor *config, int preferred_interface, int *interface_number, uint8_t *endpoint_out,
+                            uint8_t *endpoint_in)
 {
     if (config == nullptr)
     {
@@ -204,6 +534,20 @@ bool FindUsbBulkOutInConfig(const libusb_config_descriptor *config, int preferre
                 {
                     *interface_number = alt.bInterfaceNumber;
                     *endpoint_out = ep.bEndpointAddress;
+                    if (endpoint_in != nullptr)
+                    {
+                        *endpoint_in = 0;
+                        for (int m = 0; m < alt.bNumEndpoints; m++)
+                        {
+                            const libusb_endpoint_descriptor &in = alt.endpoint[m];
+                            if ((in.bmAttributes & LIBUSB_TRANSFER_TYPE_MASK) == LIBUSB_TRANSFER_TYPE_BULK &&
+                                (in.bEndpointAddress & LIBUSB_ENDPOINT_DIR_MASK) == LIBUSB_ENDPOINT_IN)
+                            {
+                                *endpoint_in = in.bEndpointAddress;
+                                break;
+                            }
+                        }
+                    }
                     return true;
                 }
             }
@@ -220,7 +564,8 @@ std::string LastErrnoText(const char *context)
     return out.str();
 }
 
-bool FindUsbBulkOutEndpoint(libusb_device_handle *handle, int preferred_interface, int *interface_number, uint8_t *endpoint_out)
+bool FindUsbBulkEndpoints(libusb_device_handle *handle, int preferred_interface, int *interface_number, uint8_t *endpoint_out,
+                          uint8_t *endpoint_in)
 {
     libusb_device *device = libusb_get_device(handle);
     if (device == nullptr)
@@ -235,7 +580,7 @@ bool FindUsbBulkOutEndpoint(libusb_device_handle *handle, int preferred_interfac
         return false;
     }
 
-    bool found = FindUsbBulkOutInConfig(config, preferred_interface, interface_number, endpoint_out);
+    bool found = FindUsbBulkOutInConfig(config, preferred_interface, interface_number, endpoint_out, endpoint_in);
 
     libusb_free_config_descriptor(config);
     return found;
@@ -259,7 +604,7 @@ bool FindUsbBulkOutOnDevice(libusb_device *device, int *interface_number, uint8_
         }
     }
 
-    bool found = FindUsbBulkOutInConfig(config, -1, interface_number, endpoint_out);
+    bool found = FindUsbBulkOutInConfig(config, -1, interface_number, endpoint_out, nullptr);
     libusb_free_config_descriptor(config);
     return found;
 }
@@ -279,7 +624,10 @@ std::string BuildUsbId(libusb_device *device, uint16_t vendor_id, uint16_t produ
     return out.str();
 }
 
-void AppendUsbDiscoveryDevices(FlValue *list)
+// Takes ownership of one discovered device map. Runs on a discovery thread; returns false once discovery has ended.
+using DeviceSink = std::function<bool(FlValue *device)>;
+
+void DiscoverUsbDevices(const DeviceSink &sink)
 {
     libusb_context *context = nullptr;
     if (libusb_init(&context) != 0 || context == nullptr)
@@ -311,25 +659,76 @@ void AppendUsbDiscoveryDevices(FlValue *list)
             continue;
         }
 
+        const escpos_printer::PrinterProfile *profile = escpos_printer::FindPrinterProfile(desc.idVendor, desc.idProduct);
         std::ostringstream name;
-        name << "USB VID:" << FormatHex4(desc.idVendor) << " PID:" << FormatHex4(desc.idProduct);
+        if (profile != nullptr)
+        {
+            name << profile->name;
+        }
+        else
+        {
+            name << "USB VID:" << FormatHex4(desc.idVendor) << " PID:" << FormatHex4(desc.idProduct);
+        }
 
-        g_autoptr(FlValue) item = fl_value_new_map();
-        fl_value_set_string(item, "id", fl_value_new_string(BuildUsbId(device, desc.idVendor, desc.idProduct).c_str()));
-        fl_value_set_string(item, "name", fl_value_new_string(name.str().c_str()));
-        fl_value_set_string(item, "transport", fl_value_new_string("usb"));
-        fl_value_set_string(item, "vendorId", fl_value_new_int(desc.idVendor));
-        fl_value_set_string(item, "productId", fl_value_new_int(desc.idProduct));
-        fl_value_set_string(item, "interfaceNumber", fl_value_new_int(interface_number));
-        fl_value_set_string(item, "metadata", fl_value_new_map());
-        fl_value_append_take(list, fl_value_ref(item));
+        FlValue *item = fl_value_new_map();
+        fl_value_set_string_take(item, "id", fl_value_new_string(BuildUsbId(device, desc.idVendor, desc.idProduct).c_str()));
+        fl_value_set_string_take(item, "name", fl_value_new_string(name.str().c_str()));
+        fl_value_set_string_take(item, "transport", fl_value_new_string("usb"));
+        fl_value_set_string_take(item, "vendorId", fl_value_new_int(desc.idVendor));
+        fl_value_set_string_take(item, "productId", fl_value_new_int(desc.idProduct));
+        fl_value_set_string_take(item, "interfaceNumber", fl_value_new_int(interface_number));
+        fl_value_set_string_take(item, "metadata", fl_value_new_map());
+        if (profile != nullptr)
+        {
+            fl_value_set_string_take(item, "profile", MakeProfileValue(*profile));
+        }
+        if (!sink(item))
+        {
+            break;
+        }
     }
 
     libusb_free_device_list(devices, 1);
     libusb_exit(context);
 }
 
-void AppendBluetoothDiscoveryDevices(FlValue *list)
+// Lists usblp nodes; they print through the kernel driver, alongside CUPS, without claiming the interface.
+void DiscoverLpDevices(const DeviceSink &sink)
+{
+    DIR *directory = opendir("/dev/usb");
+    if (directory == nullptr)
+    {
+        return;
+    }
+
+    std::vector<std::string> names;
+    for (dirent *entry = readdir(directory); entry != nullptr; entry = readdir(directory))
+    {
+        if (std::strncmp(entry->d_name, "lp", 2) == 0)
+        {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(directory);
+    std::sort(names.begin(), names.end());
+
+    for (const std::string &name : names)
+    {
+        std::string path = "/dev/usb/" + name;
+        FlValue *item = fl_value_new_map();
+        fl_value_set_string_take(item, "id", fl_value_new_string(("usblp:" + path).c_str()));
+        fl_value_set_string_take(item, "name", fl_value_new_string(("USB printer (" + name + ")").c_str()));
+        fl_value_set_string_take(item, "transport", fl_value_new_string("usb"));
+        fl_value_set_string_take(item, "serialNumber", fl_value_new_string(path.c_str()));
+        fl_value_set_string_take(item, "metadata", fl_value_new_map());
+        if (!sink(item))
+        {
+            return;
+        }
+    }
+}
+
+void DiscoverBluetoothDevices(const DeviceSink &sink, int timeout_ms)
 {
     g_autoptr(GError) error = nullptr;
     g_autoptr(GDBusConnection) connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &error);
@@ -338,8 +737,9 @@ void AppendBluetoothDiscoveryDevices(FlValue *list)
         return;
     }
 
+    int call_timeout_ms = std::min(timeout_ms, kBluetoothQueryTimeoutMs);
     g_autoptr(GVariant) reply = g_dbus_connection_call_sync(connection, "org.bluez", "/", "org.freedesktop.DBus.ObjectManager", "GetManagedObjects", nullptr,
-                                                            G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE, 2500, nullptr, &error);
+                                                            G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE, call_timeout_ms, nullptr, &error);
     if (reply == nullptr)
     {
         return;
@@ -392,17 +792,21 @@ void AppendBluetoothDiscoveryDevices(FlValue *list)
             std::string default_name = address;
             std::string id = std::string("bluetooth:") + address;
 
-            g_autoptr(FlValue) item = fl_value_new_map();
-            fl_value_set_string(item, "id", fl_value_new_string(id.c_str()));
-            fl_value_set_string(item, "name", fl_value_new_string(name != nullptr ? name : default_name.c_str()));
-            fl_value_set_string(item, "transport", fl_value_new_string("bluetooth"));
-            fl_value_set_string(item, "address", fl_value_new_string(address));
-            fl_value_set_string(item, "mode", fl_value_new_string("classic"));
-            fl_value_set_string(item, "isPaired", fl_value_new_bool(true));
-            g_autoptr(FlValue) metadata = fl_value_new_map();
-            fl_value_set_string(metadata, "objectPath", fl_value_new_string(object_path != nullptr ? object_path : ""));
-            fl_value_set_string(item, "metadata", fl_value_ref(metadata));
-            fl_value_append_take(list, fl_value_ref(item));
+            FlValue *item = fl_value_new_map();
+            fl_value_set_string_take(item, "id", fl_value_new_string(id.c_str()));
+            fl_value_set_string_take(item, "name", fl_value_new_string(name != nullptr ? name : default_name.c_str()));
+            fl_value_set_string_take(item, "transport", fl_value_new_string("bluetooth"));
+            fl_value_set_string_take(item, "address", fl_value_new_string(address));
+            fl_value_set_string_take(item, "mode", fl_value_new_string("classic"));
+            fl_value_set_string_take(item, "isPaired", fl_value_new_bool(true));
+            FlValue *metadata = fl_value_new_map();
+            fl_value_set_string_take(metadata, "objectPath", fl_value_new_string(object_path != nullptr ? object_path : ""));
+            fl_value_set_string_take(item, "metadata", metadata);
+            if (!sink(item))
+            {
+                g_variant_unref(interfaces);
+                break;
+            }
         }
 
         g_variant_unref(interfaces);
@@ -411,7 +815,49 @@ void AppendBluetoothDiscoveryDevices(FlValue *list)
     g_variant_iter_free(objects_iter);
 }
 
-int OpenTcpSocket(const std::string &host, int port, std::string *error)
+// connect() bounded by timeout_ms. The socket is blocking again afterwards.
+bool ConnectWithTimeout(int fd, const sockaddr *address, socklen_t address_length, int timeout_ms)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int rc = connect(fd, address, address_length);
+    if (rc != 0 && errno == EINPROGRESS)
+    {
+        pollfd descriptor = {fd, POLLOUT, 0};
+        rc = poll(&descriptor, 1, timeout_ms);
+        if (rc > 0)
+        {
+            int socket_error = 0;
+            socklen_t length = sizeof(socket_error);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &socket_error, &length);
+            errno = socket_error;
+            rc = socket_error == 0 ? 0 : -1;
+        }
+        else
+        {
+            errno = rc == 0 ? ETIMEDOUT : errno;
+            rc = -1;
+        }
+    }
+    fcntl(fd, F_SETFL, flags);
+    return rc == 0;
+}
+
+void ConfigureDeadPeerDetection(int fd)
+{
+    int enable = 1;
+    int idle = kTcpKeepIdleSeconds;
+    int interval = kTcpKeepIntervalSeconds;
+    int count = kTcpKeepCount;
+    unsigned user_timeout = kTcpUserTimeoutMs;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+    setsockopt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_timeout, sizeof(user_timeout));
+}
+
+int OpenTcpSocket(const std::string &host, int port, int timeout_ms, std::string *error)
 {
     struct addrinfo hints;
     std::memset(&hints, 0, sizeof(hints));
@@ -438,7 +884,7 @@ int OpenTcpSocket(const std::string &host, int port, std::string *error)
             continue;
         }
 
-        if (connect(socket_fd, addr->ai_addr, addr->ai_addrlen) == 0)
+        if (ConnectWithTimeout(socket_fd, addr->ai_addr, addr->ai_addrlen, timeout_ms))
         {
             break;
         }
@@ -457,183 +903,2067 @@ int OpenTcpSocket(const std::string &host, int port, std::string *error)
     return socket_fd;
 }
 
-void CloseNativeConnection(NativeConnection *connection)
+struct BaudRate
 {
-    if (connection == nullptr)
-    {
-        return;
-    }
+    int rate;
+    speed_t speed;
+};
 
-    if (connection->fd >= 0)
+constexpr BaudRate kBaudRates[] = {
+    {1200, B1200},     {2400, B2400},     {4800, B4800},     {9600, B9600},     {19200, B19200},   {38400, B38400},
+    {57600, B57600},   {115200, B115200}, {230400, B230400}, {460800, B460800}, {921600, B921600},
+};
+
+// Puts a terminal in raw mode with the baudRate, dataBits, parity, stopBits and flowControl fields of args; a missing
+// baudRate keeps the port's speed. Records the resulting line rate on the connection for write pacing.
+bool ConfigureTty(int fd, FlValue *args, NativeConnection *connection, std::string *error)
+{
+    termios attributes;
+    if (tcgetattr(fd, &attributes) != 0)
     {
-        close(connection->fd);
-        connection->fd = -1;
+        *error = LastErrnoText("Failed to read serial port settings");
+        return false;
     }
 
-    if (connection->usb_handle != nullptr)
+    cfmakeraw(&attributes);
+    attributes.c_cflag |= CLOCAL | CREAD;
+    attributes.c_cc[VMIN] = 0;
+    attributes.c_cc[VTIME] = 0;
+
+    int baud_rate = 0;
+    if (ReadOptionalInt(args, "baudRate", &baud_rate))
     {
-        if (connection->usb_interface_number >= 0)
+        auto same_rate = [baud_rate](const BaudRate &entry) { return entry.rate == baud_rate; };
+        const BaudRate *match = std::find_if(std::begin(kBaudRates), std::end(kBaudRates), same_rate);
+        if (match == std::end(kBaudRates))
         {
-            libusb_release_interface(connection->usb_handle, connection->usb_interface_number);
+            *error = "Unsupported baud rate: " + std::to_string(baud_rate);
+            return false;
         }
-        libusb_close(connection->usb_handle);
-        connection->usb_handle = nullptr;
+        cfsetispeed(&attributes, match->speed);
+        cfsetospeed(&attributes, match->speed);
     }
-
-    if (connection->usb_context != nullptr)
+    else
     {
-        libusb_exit(connection->usb_context);
-        connection->usb_context = nullptr;
+        speed_t speed = cfgetospeed(&attributes);
+        auto same_speed = [speed](const BaudRate &entry) { return entry.speed == speed; };
+        const BaudRate *match = std::find_if(std::begin(kBaudRates), std::end(kBaudRates), same_speed);
+        baud_rate = match == std::end(kBaudRates) ? 0 : match->rate;
     }
-}
 
-FlMethodResponse *HandleOpenConnection(FlValue *args)
-{
-    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+    int data_bits = 8;
+    ReadOptionalInt(args, "dataBits", &data_bits);
+    attributes.c_cflag &= ~CSIZE;
+    switch (data_bits)
     {
-        return MakeErrorResponse("invalid_args", "openConnection requires a map payload.");
+    case 5:
+        attributes.c_cflag |= CS5;
+        break;
+    case 6:
+        attributes.c_cflag |= CS6;
+        break;
+    case 7:
+        attributes.c_cflag |= CS7;
+        break;
+    default:
+        data_bits = 8;
+        attributes.c_cflag |= CS8;
+        break;
     }
 
-    std::string transport;
-    std::string parse_error;
-    if (!ReadRequiredString(args, "transport", &transport, &parse_error))
+    std::string parity = "none";
+    ReadOptionalString(args, "parity", &parity);
+    attributes.c_cflag &= ~(PARENB | PARODD);
+    if (parity == "even")
     {
-        return MakeErrorResponse("invalid_args", parse_error);
+        attributes.c_cflag |= PARENB;
+    }
+    else if (parity == "odd")
+    {
+        attributes.c_cflag |= PARENB | PARODD;
     }
 
-    std::unique_ptr<NativeConnection> connection = std::make_unique<NativeConnection>();
+    int stop_bits = 1;
+    ReadOptionalInt(args, "stopBits", &stop_bits);
+    if (stop_bits == 2)
+    {
+        attributes.c_cflag |= CSTOPB;
+    }
+    else
+    {
+        stop_bits = 1;
+        attributes.c_cflag &= ~CSTOPB;
+    }
 
-    if (transport == "wifi")
+    std::string flow_control = "none";
+    ReadOptionalString(args, "flowControl", &flow_control);
+    attributes.c_cflag &= ~CRTSCTS;
+    attributes.c_iflag &= ~(IXON | IXOFF | IXANY);
+    if (flow_control == "rtsCts")
     {
-        std::string host;
-        if (!ReadRequiredString(args, "host", &host, &parse_error))
-        {
-            return MakeErrorResponse("invalid_args", parse_error);
-        }
+        attributes.c_cflag |= CRTSCTS;
+    }
+    else if (flow_control == "xonXoff")
+    {
+        attributes.c_iflag |= IXON | IXOFF;
+    }
 
-        int port = 9100;
-        ReadOptionalInt(args, "port", &port);
+    if (tcsetattr(fd, TCSANOW, &attributes) != 0)
+    {
+        *error = LastErrnoText("Failed to apply serial port settings");
+        return false;
+    }
 
-        std::string socket_error;
-        int fd = OpenTcpSocket(host, port, &socket_error);
-        if (fd < 0)
-        {
-            return MakeErrorResponse("connect_failed", socket_error);
-        }
+    int bits_per_byte = 1 + data_bits + (parity == "even" || parity == "odd" ? 1 : 0) + stop_bits;
+    connection->tty_bytes_per_second = static_cast<size_t>(baud_rate / bits_per_byte);
+    return true;
+}
 
-        connection->kind = SessionKind::kWifi;
-        connection->fd = fd;
-    }
-    else if (transport == "bluetooth")
+// Waits until the terminal has transmitted its output queue, failing when the queue stops shrinking for
+// kDeviceWriteTimeoutMs (e.g. CTS held low), then lets tcdrain() wait for the UART itself.
+bool DrainTty(int fd, std::string *error)
+{
+    int last_queued = -1;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(escpos_printer::kDeviceWriteTimeoutMs);
+    for (;;)
     {
-        std::string address;
-        if (!ReadRequiredString(args, "address", &address, &parse_error))
+        int queued = 0;
+        if (ioctl(fd, TIOCOUTQ, &queued) != 0 || queued <= 0)
         {
-            return MakeErrorResponse("invalid_args", parse_error);
-        }
-
-        int channel = 1;
-        int socket_fd = socket(AF_BLUETOOTH, SOCK_STREAM, BTPROTO_RFCOMM);
-        if (socket_fd < 0)
-        {
-            return MakeErrorResponse("connect_failed", LastErrnoText("Failed to create Bluetooth socket"));
+            break;
         }
-
-        sockaddr_rc addr = {};
-        addr.rc_family = AF_BLUETOOTH;
-        addr.rc_channel = static_cast<uint8_t>(channel);
-        if (str2ba(address.c_str(), &addr.rc_bdaddr) != 0)
+        if (queued != last_queued)
         {
-            close(socket_fd);
-            return MakeErrorResponse("invalid_args", "Invalid Bluetooth address.");
+            last_queued = queued;
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(escpos_printer::kDeviceWriteTimeoutMs);
         }
-
-        if (connect(socket_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+        else if (std::chrono::steady_clock::now() >= deadline)
         {
-            std::string err = LastErrnoText("Failed to connect Bluetooth RFCOMM");
-            close(socket_fd);
-            return MakeErrorResponse("connect_failed", err);
+            *error = "Timed out waiting for the serial port to transmit.";
+            return false;
         }
-
-        connection->kind = SessionKind::kBluetooth;
-        connection->fd = socket_fd;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
     }
-    else if (transport == "usb")
+
+    while (tcdrain(fd) != 0)
     {
-        int vendor_id = 0;
-        int product_id = 0;
-        if (!ReadOptionalInt(args, "vendorId", &vendor_id) || !ReadOptionalInt(args, "productId", &product_id))
+        if (errno != EINTR)
         {
-            return MakeErrorResponse("invalid_args", "vendorId and productId are required for USB.");
+            *error = LastErrnoText("Failed to drain serial port");
+            return false;
         }
+    }
+    return true;
+}
 
-        int preferred_interface = -1;
-        ReadOptionalInt(args, "interfaceNumber", &preferred_interface);
-
-        libusb_context *usb_context = nullptr;
-        int rc = libusb_init(&usb_context);
-        if (rc != 0 || usb_context == nullptr)
+// Writes at the session's line rate, at most kTtyBurstBytes ahead of it, so printers without flow control are not
+// overrun, and returns once the bytes have left the port. Gives up once cancel is set.
+bool WriteToTty(NativeConnection *connection, const uint8_t *bytes, size_t length, std::string *error, const std::atomic<bool> *cancel)
+{
+    size_t offset = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (offset < length)
+    {
+        if (escpos_printer::WriteCancelled(cancel, error))
         {
-            return MakeErrorResponse("connect_failed", "Failed to initialize libusb.");
+            return false;
         }
-
-        libusb_device_handle *usb_handle = libusb_open_device_with_vid_pid(usb_context, vendor_id, product_id);
-        if (usb_handle == nullptr)
+        size_t chunk = length - offset;
+        if (connection->tty_bytes_per_second > 0)
         {
-            libusb_exit(usb_context);
-            return MakeErrorResponse("connect_failed", "USB device not found (vendorId/productId).");
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            size_t allowed = kTtyBurstBytes + static_cast<size_t>(elapsed * connection->tty_bytes_per_second);
+            if (allowed <= offset)
+            {
+                double wait = static_cast<double>(offset + 1 - allowed) / connection->tty_bytes_per_second;
+                std::this_thread::sleep_for(std::min<std::chrono::duration<double>>(std::chrono::duration<double>(wait),
+                                                                                    std::chrono::milliseconds(escpos_printer::kWriteCancelCheckMs)));
+                continue;
+            }
+            chunk = std::min(chunk, allowed - offset);
         }
 
-        int interface_number = -1;
-        uint8_t endpoint_out = 0;
-        if (!FindUsbBulkOutEndpoint(usb_handle, preferred_interface, &interface_number, &endpoint_out))
+        if (!escpos_printer::WriteToDevice(connection->fd, bytes + offset, chunk, error, cancel))
         {
-            libusb_close(usb_handle);
-            libusb_exit(usb_context);
-            return MakeErrorResponse("connect_failed", "BULK OUT endpoint not found for USB.");
+            return false;
         }
+        offset += chunk;
+    }
 
-        if (libusb_kernel_driver_active(usb_handle, interface_number) == 1)
-        {
-            libusb_detach_kernel_driver(usb_handle, interface_number);
-        }
+    return DrainTty(connection->fd, error);
+}
+
+// Maps LPGETSTATUS (usblp's emulation of the parallel port status lines) onto the status map; the lines carry no
+// cover, cutter or drawer state. Devices without the ioctl report unknown.
+FlValue *ReadDeviceStatusValue(int fd)
+{
+    escpos_printer::LpStatus lines;
+    if (!escpos_printer::ReadLpStatus(fd, &lines))
+    {
+        return MakeUnknownStatusValue();
+    }
+
+    g_autoptr(FlValue) status = fl_value_new_map();
+    fl_value_set_string(status, "paperOut", fl_value_new_string(lines.paper_out ? "yes" : "no"));
+    fl_value_set_string(status, "paperNearEnd", fl_value_new_string("unknown"));
+    fl_value_set_string(status, "coverOpen", fl_value_new_string("unknown"));
+    fl_value_set_string(status, "cutterError", fl_value_new_string("unknown"));
+    fl_value_set_string(status, "offline", fl_value_new_string(lines.offline ? "yes" : "no"));
+    fl_value_set_string(status, "drawerSignal", fl_value_new_string("unknown"));
+
+    return fl_value_ref(status);
+}
+
+FlMethodResponse *TakeBytesResponse(UsbInput *input, size_t max_bytes)
+{
+    std::vector<uint8_t> bytes;
+    if (!input->probing)
+    {
+        input->reader->Take(max_bytes, &bytes);
+    }
+    if (bytes.empty())
+    {
+        std::string error = input->reader->Error();
+        if (!error.empty())
+        {
+            return MakeErrorResponse("read_failed", error);
+        }
+    }
+
+    g_autoptr(FlValue) value = fl_value_new_uint8_list(bytes.data(), bytes.size());
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(value));
+}
+
+void FinishPendingRead(UsbInput *input, FlMethodResponse *response)
+{
+    if (input->pending_timeout != 0)
+    {
+        g_source_remove(input->pending_timeout);
+        input->pending_timeout = 0;
+    }
+
+    FlMethodCall *method_call = input->pending_call;
+    input->pending_call = nullptr;
+    fl_method_call_respond(method_call, response, nullptr);
+    g_object_unref(response);
+    g_object_unref(method_call);
+}
+
+void DeleteUsbInputRef(gpointer data)
+{
+    delete static_cast<std::weak_ptr<UsbInput> *>(data);
+}
+
+gboolean DeliverPendingRead(gpointer data)
+{
+    std::shared_ptr<UsbInput> input = static_cast<std::weak_ptr<UsbInput> *>(data)->lock();
+    if (input != nullptr && input->pending_call != nullptr && !input->probing && (input->reader->Available() > 0 || !input->reader->Error().empty()))
+    {
+        FinishPendingRead(input.get(), TakeBytesResponse(input.get(), input->pending_max_bytes));
+    }
+    return G_SOURCE_REMOVE;
+}
+
+gboolean ExpirePendingRead(gpointer data)
+{
+    std::shared_ptr<UsbInput> input = static_cast<std::weak_ptr<UsbInput> *>(data)->lock();
+    if (input != nullptr && input->pending_call != nullptr)
+    {
+        input->pending_timeout = 0;
+        FinishPendingRead(input.get(), TakeBytesResponse(input.get(), input->pending_max_bytes));
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// Starts buffering the bulk IN endpoint. Arriving bytes wake a waiting readBytes call through the main loop. A printer
+// whose IN endpoint cannot be read still prints, so failures leave the session write-only.
+void StartUsbInput(NativeConnection *connection)
+{
+    std::shared_ptr<UsbInput> input = std::make_shared<UsbInput>();
+    std::weak_ptr<UsbInput> weak_input = input;
+    auto on_data = [weak_input]() { g_idle_add_full(G_PRIORITY_DEFAULT, DeliverPendingRead, new std::weak_ptr<UsbInput>(weak_input), DeleteUsbInputRef); };
+    input->reader = std::make_unique<escpos_printer::UsbInputReader>(connection->usb_context, connection->usb_handle, connection->usb_endpoint_in, on_data);
+
+    std::string error;
+    if (input->reader->Start(&error))
+    {
+        connection->usb_input = input;
+    }
+}
+
+// Closes the fd or USB handle but keeps the session's settings, so the link can be opened again.
+void CloseNativeLink(NativeConnection *connection)
+{
+    if (connection->fd >= 0)
+    {
+        if (connection->use_uring)
+        {
+            escpos_printer::UringWriter::Instance()->CloseWhenIdle(connection->fd);
+        }
+        else
+        {
+            close(connection->fd);
+        }
+        connection->fd = -1;
+    }
+
+    if (connection->usb_input != nullptr)
+    {
+        connection->usb_input->reader->Stop();
+        if (connection->usb_input->pending_call != nullptr)
+        {
+            FinishPendingRead(connection->usb_input.get(), MakeErrorResponse("read_failed", "Session was closed."));
+        }
+        connection->usb_input.reset();
+    }
+
+    if (connection->usb_handle != nullptr)
+    {
+        if (connection->usb_interface_number >= 0)
+        {
+            libusb_release_interface(connection->usb_handle, connection->usb_interface_number);
+        }
+        libusb_close(connection->usb_handle);
+        connection->usb_handle = nullptr;
+    }
+
+    if (connection->usb_context != nullptr)
+    {
+        libusb_exit(connection->usb_context);
+        connection->usb_context = nullptr;
+    }
+    connection->usb_interface_number = -1;
+}
+
+void RespondJobCall(FlMethodCall **call, FlMethodResponse *response)
+{
+    fl_method_call_respond(*call, response, nullptr);
+    g_object_unref(response);
+    g_object_unref(*call);
+    *call = nullptr;
+}
+
+// Stops the drainer, drops unwritten bytes and fails calls still waiting on the stream. Main thread only.
+void StopJobStream(const std::shared_ptr<JobStream> &stream, const char *reason)
+{
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->aborted = true;
+        stream->stop = true;
+    }
+    stream->wake.notify_all();
+    if (stream->write_turn != nullptr)
+    {
+        // Taken so a drainer between checking stop and waiting for the turn cannot miss the wakeup.
+        {
+            std::lock_guard<std::mutex> lock(stream->write_turn->mutex);
+        }
+        stream->write_turn->released.notify_all();
+    }
+    if (stream->drainer.joinable())
+    {
+        stream->drainer.join();
+    }
+
+    if (stream->append_call != nullptr)
+    {
+        RespondJobCall(&stream->append_call, MakeErrorResponse("job_aborted", reason));
+        fl_value_unref(stream->append_chunk);
+        stream->append_chunk = nullptr;
+    }
+    if (stream->commit_call != nullptr)
+    {
+        RespondJobCall(&stream->commit_call, MakeErrorResponse("job_aborted", reason));
+    }
+}
+
+// Posts [request_id, error, reconnected] to the Dart port of a direct write and frees its buffer. error is null on
+// success; reconnected says the link was reopened after the write failed.
+void FinishDirectWrite(DirectWrite *write, const char *error, bool reconnected)
+{
+    escpos_printer::DartMessage request_id;
+    request_id.type = escpos_printer::kDartMessageInt64;
+    request_id.value.as_int64 = write->request_id;
+    escpos_printer::DartMessage error_value;
+    if (error == nullptr)
+    {
+        error_value.type = escpos_printer::kDartMessageNull;
+    }
+    else
+    {
+        error_value.type = escpos_printer::kDartMessageString;
+        error_value.value.as_string = error;
+    }
+    escpos_printer::DartMessage reconnected_value;
+    reconnected_value.type = escpos_printer::kDartMessageBool;
+    reconnected_value.value.as_bool = reconnected;
+    escpos_printer::DartMessage *values[] = {&request_id, &error_value, &reconnected_value};
+    escpos_printer::DartMessage message;
+    message.type = escpos_printer::kDartMessageArray;
+    message.value.as_array.length = 3;
+    message.value.as_array.values = values;
+    g_post_message.load()(write->port, &message);
+
+    free(write->bytes);
+    write->bytes = nullptr;
+}
+
+// Waits for the session's write turn. Returns false, without it, once the session is closing or cancel is set.
+bool TakeWriteTurn(WriteTurn *turn, const std::atomic<bool> *cancel = nullptr)
+{
+    std::unique_lock<std::mutex> lock(turn->mutex);
+    auto cancelled = [cancel]() { return cancel != nullptr && cancel->load(); };
+    turn->released.wait(lock, [turn, &cancelled]() { return !turn->taken || turn->closing || cancelled(); });
+    if (turn->closing || cancelled())
+    {
+        return false;
+    }
+    turn->taken = true;
+    return true;
+}
+
+void ReleaseWriteTurn(WriteTurn *turn)
+{
+    {
+        std::lock_guard<std::mutex> lock(turn->mutex);
+        turn->taken = false;
+    }
+    turn->released.notify_all();
+}
+
+// Lets the task in progress finish, then cancels the ones still queued. Tasks queued from here on are refused.
+void StopSessionWriter(SessionWriter *writer, const char *reason)
+{
+    {
+        std::lock_guard<std::mutex> lock(writer->mutex);
+        writer->stopping = true;
+    }
+    writer->wake.notify_all();
+    if (writer->thread.joinable())
+    {
+        writer->thread.join();
+    }
+
+    for (WriteTask &task : writer->queue)
+    {
+        task.cancel(reason);
+    }
+    writer->queue.clear();
+}
+
+void CloseNativeConnection(NativeConnection *connection)
+{
+    if (connection == nullptr)
+    {
+        return;
+    }
+
+    // Whoever waits for the turn gives up; whoever holds it finishes the write in progress, or stops it early on
+    // device and serial links.
+    connection->closing = true;
+    {
+        std::lock_guard<std::mutex> lock(connection->write_turn.mutex);
+        connection->write_turn.closing = true;
+    }
+    connection->write_turn.released.notify_all();
+    if (connection->writer != nullptr)
+    {
+        StopSessionWriter(connection->writer.get(), "Session was closed.");
+        connection->writer.reset();
+    }
+    if (connection->job_stream != nullptr)
+    {
+        StopJobStream(connection->job_stream, "Session was closed.");
+        connection->job_stream.reset();
+    }
+    CloseNativeLink(connection);
+    if (connection->open_args != nullptr)
+    {
+        fl_value_unref(connection->open_args);
+        connection->open_args = nullptr;
+    }
+}
+
+// The session writer's thread: runs queued tasks in order, each holding the write turn.
+void RunSessionWriter(NativeConnection *connection, SessionWriter *writer)
+{
+    std::unique_lock<std::mutex> lock(writer->mutex);
+    for (;;)
+    {
+        writer->wake.wait(lock, [writer]() { return !writer->queue.empty() || writer->stopping; });
+        if (writer->stopping)
+        {
+            break;
+        }
+
+        WriteTask task = std::move(writer->queue.front());
+        writer->queue.pop_front();
+        lock.unlock();
+        if (TakeWriteTurn(&connection->write_turn))
+        {
+            task.run(connection);
+            ReleaseWriteTurn(&connection->write_turn);
+        }
+        else
+        {
+            task.cancel("Session was closed.");
+        }
+        lock.lock();
+    }
+}
+
+void StartSessionWriter(NativeConnection *connection)
+{
+    connection->writer = std::make_shared<SessionWriter>();
+    connection->writer->thread = std::thread(RunSessionWriter, connection, connection->writer.get());
+}
+
+// Queues task behind the session's other writes. Returns false when the writer is stopping; task is dropped then,
+// without being cancelled. Writers of sessions in g_sessions are never stopping.
+bool QueueWriteTask(SessionWriter *writer, WriteTask task)
+{
+    {
+        std::lock_guard<std::mutex> lock(writer->mutex);
+        if (writer->stopping)
+        {
+            return false;
+        }
+        writer->queue.push_back(std::move(task));
+    }
+    writer->wake.notify_one();
+    return true;
+}
+
+void UnlistSessionWriter(const std::string &session_id)
+{
+    std::lock_guard<std::mutex> lock(g_session_writers_mutex);
+    g_session_writers.erase(session_id);
+}
+
+// MAC address of a neighbour from the kernel ARP table, or an empty string when ip is not a resolved neighbour.
+std::string LookupArpMac(const std::string &ip)
+{
+    std::ifstream arp("/proc/net/arp");
+    std::string line;
+    std::getline(arp, line);
+    while (std::getline(arp, line))
+    {
+        std::istringstream fields(line);
+        std::string address, hw_type, flags, mac;
+        if (fields >> address >> hw_type >> flags >> mac && address == ip && mac != "00:00:00:00:00:00")
+        {
+            return mac;
+        }
+    }
+    return std::string();
+}
+
+// Capability cache key: USB VID/PID plus the serial string descriptor, the printer's MAC address, or the host when
+// the MAC is not known (routed networks). Empty when the session cannot be probed.
+std::string BuildDeviceKey(const NativeConnection &connection, FlValue *args)
+{
+    if (connection.kind == SessionKind::kUsb)
+    {
+        libusb_device_descriptor desc;
+        if (libusb_get_device_descriptor(libusb_get_device(connection.usb_handle), &desc) != 0)
+        {
+            return std::string();
+        }
+        std::string key = "usb:" + FormatHex4(desc.idVendor) + ":" + FormatHex4(desc.idProduct);
+        unsigned char serial[128];
+        if (desc.iSerialNumber != 0 && libusb_get_string_descriptor_ascii(connection.usb_handle, desc.iSerialNumber, serial, sizeof(serial)) > 0)
+        {
+            key += ":" + std::string(reinterpret_cast<char *>(serial));
+        }
+        return key;
+    }
+    if (connection.kind == SessionKind::kBluetooth)
+    {
+        std::string address;
+        ReadOptionalString(args, "address", &address);
+        std::transform(address.begin(), address.end(), address.begin(), [](unsigned char c) { return std::toupper(c); });
+        return "bluetooth:" + address;
+    }
+    if (connection.kind == SessionKind::kWifi)
+    {
+        std::string host;
+        int port = 9100;
+        ReadOptionalString(args, "host", &host);
+        ReadOptionalInt(args, "port", &port);
+        std::string mac = LookupArpMac(host);
+        return mac.empty() ? "wifi:" + host + ":" + std::to_string(port) : "wifi:" + mac;
+    }
+    return std::string();
+}
+
+FlValue *MakeOpenConnectionValue(const std::string &session_id, const NativeConnection &connection)
+{
+    g_autoptr(FlValue) response_map = fl_value_new_map();
+    fl_value_set_string(response_map, "sessionId", fl_value_new_string(session_id.c_str()));
+    fl_value_set_string(response_map, "capabilities", MakeCapabilitiesValue(connection));
+    fl_value_set_string(response_map, "ioBackend", fl_value_new_string(connection.use_uring ? "ioUring" : "standard"));
+    return fl_value_ref(response_map);
+}
+
+// A probe query handed to the session writer. The writer sends it and then keeps the write turn until the main loop
+// has the reply or gave up on it, so no other write reaches the printer in between. Guarded by the writer's mutex.
+struct ProbeExchange
+{
+    bool sent = false;
+    bool failed = false;
+    // Set by the main loop: the reply arrived or timed out. A query still queued then is not sent.
+    bool finished = false;
+};
+
+// One capability probe, driven from the main loop by a kProbePollMs timer. Only reply polling runs there; queries are
+// written by the session writer.
+struct ProbeRun
+{
+    std::string session_id;
+    escpos_printer::CapabilityProbe probe;
+    // When the current query times out: kReplyTimeoutMs after it was sent, or after it became due when it never was.
+    gint64 reply_deadline = 0;
+    // The query in flight, from queueing it until its reply or timeout; nullptr between queries.
+    std::shared_ptr<ProbeExchange> exchange;
+    bool query_sent = false;
+    // Whether the session started from a cache entry that found the printer responsive.
+    bool cached_responsive = false;
+    // openConnection call answered once probing ends; nullptr when revalidating a cached entry in the background.
+    FlMethodCall *method_call = nullptr;
+};
+
+bool WriteToConnection(NativeConnection *connection, const uint8_t *bytes, size_t length, std::string *error, size_t *acknowledged = nullptr,
+                       const std::atomic<bool> *cancel = nullptr);
+
+// Lets the writer go on after a query and lets a readBytes call that waited behind it have its bytes.
+void EndProbeQuery(NativeConnection *connection, ProbeRun *run)
+{
+    if (run->exchange == nullptr)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(connection->writer->mutex);
+        run->exchange->finished = true;
+    }
+    connection->writer->wake.notify_all();
+    run->exchange.reset();
+    run->query_sent = false;
+
+    UsbInput *input = connection->usb_input.get();
+    if (input != nullptr && input->probing)
+    {
+        input->probing = false;
+        if (input->pending_call != nullptr && (input->reader->Available() > 0 || !input->reader->Error().empty()))
+        {
+            FinishPendingRead(input, TakeBytesResponse(input, input->pending_max_bytes));
+        }
+    }
+}
+
+// Queues the current query on the session writer once the session is quiet: no job stream is open, and on USB no
+// readBytes call waits and nothing is buffered for one. The writer sends it in turn with the session's other writes.
+// Returns false when the query cannot be sent.
+bool QueueProbeQuery(NativeConnection *connection, ProbeRun *run)
+{
+    // A job stream keeps the turn between its spans only once it has written the first one.
+    if (connection->job_stream != nullptr)
+    {
+        return true;
+    }
+    UsbInput *input = nullptr;
+    {
+        std::lock_guard<std::mutex> link_lock(connection->link_mutex);
+        input = connection->usb_input.get();
+    }
+    if (connection->kind == SessionKind::kUsb)
+    {
+        // The reader is gone when a reconnect could not restart it.
+        if (input == nullptr)
+        {
+            return false;
+        }
+        if (input->pending_call != nullptr || input->reader->Available() > 0)
+        {
+            return true;
+        }
+    }
+
+    auto exchange = std::make_shared<ProbeExchange>();
+    SessionWriter *writer = connection->writer.get();
+    WriteTask task;
+    task.run = [exchange, writer, query = run->probe.Query()](NativeConnection *connection) {
+        {
+            std::lock_guard<std::mutex> lock(writer->mutex);
+            if (exchange->finished)
+            {
+                return;
+            }
+        }
+        std::string error;
+        bool ok = WriteToConnection(connection, query.data(), query.size(), &error, nullptr, &connection->closing);
+        std::unique_lock<std::mutex> lock(writer->mutex);
+        (ok ? exchange->sent : exchange->failed) = true;
+        if (ok)
+        {
+            // The reply times out on the main loop after kReplyTimeoutMs; the bound only matters if that never runs.
+            writer->wake.wait_for(lock, std::chrono::milliseconds(4 * escpos_printer::CapabilityProbe::kReplyTimeoutMs),
+                                  [exchange, writer]() { return exchange->finished || writer->stopping; });
+        }
+    };
+    task.cancel = [exchange, writer](const char *) {
+        std::lock_guard<std::mutex> lock(writer->mutex);
+        exchange->failed = true;
+    };
+    if (!QueueWriteTask(writer, std::move(task)))
+    {
+        return false;
+    }
+    run->exchange = exchange;
+    if (input != nullptr)
+    {
+        input->probing = true;
+    }
+    return true;
+}
+
+// Feeds whatever the printer sent since the last poll to the probe. Returns true when it completed a reply.
+bool ReceiveProbeBytes(NativeConnection *connection, ProbeRun *run)
+{
+    if (connection->kind == SessionKind::kUsb)
+    {
+        std::vector<uint8_t> bytes;
+        connection->usb_input->reader->Take(escpos_printer::UsbInputReader::kBufferLimit, &bytes);
+        return run->probe.Feed(bytes.data(), bytes.size());
+    }
+
+    uint8_t buffer[256];
+    ssize_t received;
+    while ((received = recv(connection->fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+    {
+        if (run->probe.Feed(buffer, static_cast<size_t>(received)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+gboolean StepCapabilityProbe(gpointer data)
+{
+    ProbeRun *run = static_cast<ProbeRun *>(data);
+    g_autoptr(FlValue) open_value = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_sessions_mutex);
+        auto iterator = g_sessions.find(run->session_id);
+        NativeConnection *connection = iterator == g_sessions.end() ? nullptr : iterator->second.get();
+        if (connection != nullptr)
+        {
+            bool sent = false;
+            bool failed = false;
+            if (run->exchange != nullptr)
+            {
+                std::lock_guard<std::mutex> writer_lock(connection->writer->mutex);
+                sent = run->exchange->sent;
+                failed = run->exchange->failed;
+            }
+            if (sent && !run->query_sent)
+            {
+                run->query_sent = true;
+                run->reply_deadline = g_get_monotonic_time() + escpos_printer::CapabilityProbe::kReplyTimeoutMs * 1000;
+            }
+
+            // The writer holds the turn until EndProbeQuery, so the link cannot change under the read.
+            bool replied = sent && ReceiveProbeBytes(connection, run);
+            if (!replied && !failed && g_get_monotonic_time() >= run->reply_deadline)
+            {
+                run->probe.Timeout();
+                replied = true;
+            }
+            if (replied)
+            {
+                EndProbeQuery(connection, run);
+                run->reply_deadline = g_get_monotonic_time() + escpos_printer::CapabilityProbe::kReplyTimeoutMs * 1000;
+            }
+            if (failed || (!run->probe.Done() && run->exchange == nullptr && !QueueProbeQuery(connection, run)))
+            {
+                // The session failed under the probe; the write path reports it on the next print.
+                EndProbeQuery(connection, run);
+                while (!run->probe.Done())
+                {
+                    run->probe.Timeout();
+                }
+            }
+            if (!run->probe.Done())
+            {
+                return G_SOURCE_CONTINUE;
+            }
+
+            escpos_printer::PrinterInfo info = run->probe.Result();
+            info.probed_at = static_cast<int64_t>(std::time(nullptr));
+            // A busy printer can miss one revalidation; that alone does not overwrite what it answered before.
+            if (info.responsive || !run->cached_responsive)
+            {
+                escpos_printer::CapabilityCache::Instance().Store(connection->device_key, info);
+                connection->printer_info = info;
+                connection->capability_source = "probed";
+            }
+            if (run->method_call != nullptr)
+            {
+                open_value = MakeOpenConnectionValue(run->session_id, *connection);
+            }
+        }
+    }
+
+    if (run->method_call != nullptr)
+    {
+        g_autoptr(FlMethodResponse) response = open_value != nullptr ? FL_METHOD_RESPONSE(fl_method_success_response_new(open_value))
+                                                                     : MakeErrorResponse("connect_failed", "Session was closed.");
+        fl_method_call_respond(run->method_call, response, nullptr);
+        g_object_unref(run->method_call);
+    }
+    delete run;
+    return G_SOURCE_REMOVE;
+}
+
+// Starts probing the session's printer. Must be called with g_sessions_mutex held.
+void StartCapabilityProbe(const std::string &session_id, NativeConnection *connection, FlMethodCall *method_call)
+{
+    ProbeRun *run = new ProbeRun();
+    run->session_id = session_id;
+    run->cached_responsive = connection->capability_source == "cached" && connection->printer_info.responsive;
+    run->method_call = method_call != nullptr ? FL_METHOD_CALL(g_object_ref(method_call)) : nullptr;
+    run->reply_deadline = g_get_monotonic_time() + escpos_printer::CapabilityProbe::kReplyTimeoutMs * 1000;
+    if (!QueueProbeQuery(connection, run))
+    {
+        run->probe.Timeout();
+    }
+    g_timeout_add(kProbePollMs, StepCapabilityProbe, run);
+}
+
+const char *LinkStateName(LinkState state)
+{
+    switch (state)
+    {
+    case LinkState::kConnected:
+        return "connected";
+    case LinkState::kDegraded:
+        return "degraded";
+    default:
+        return "lost";
+    }
+}
+
+// Current health of a session's link, from state the kernel or libusb already has; nothing is sent to the printer.
+LinkState CheckLink(const NativeConnection &connection, std::string *reason)
+{
+    if (connection.kind == SessionKind::kUsb)
+    {
+        if (connection.usb_handle == nullptr)
+        {
+            *reason = "USB link is closed.";
+            return LinkState::kLost;
+        }
+        std::string input_error = connection.usb_input != nullptr ? connection.usb_input->reader->Error() : std::string();
+        if (!input_error.empty())
+        {
+            *reason = input_error;
+            return LinkState::kLost;
+        }
+        return LinkState::kConnected;
+    }
+
+    if (connection.fd < 0)
+    {
+        *reason = "Link is closed.";
+        return LinkState::kLost;
+    }
+
+    pollfd descriptor = {connection.fd, 0, 0};
+    if (poll(&descriptor, 1, 0) > 0 && (descriptor.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0)
+    {
+        int socket_error = 0;
+        socklen_t length = sizeof(socket_error);
+        bool is_socket = connection.kind == SessionKind::kWifi || connection.kind == SessionKind::kBluetooth;
+        if (is_socket && getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &socket_error, &length) == 0 && socket_error != 0)
+        {
+            *reason = std::strerror(socket_error);
+        }
+        else
+        {
+            *reason = "Peer closed the connection.";
+        }
+        return LinkState::kLost;
+    }
+
+    if (connection.kind == SessionKind::kWifi)
+    {
+        tcp_info info = {};
+        socklen_t length = sizeof(info);
+        if (getsockopt(connection.fd, IPPROTO_TCP, TCP_INFO, &info, &length) == 0)
+        {
+            if (info.tcpi_state != TCP_ESTABLISHED)
+            {
+                *reason = "TCP connection is no longer established.";
+                return LinkState::kLost;
+            }
+            if (info.tcpi_retransmits > 0 || info.tcpi_probes > 0 || (info.tcpi_unacked > 0 && info.tcpi_last_ack_recv >= kDegradedAckMs))
+            {
+                *reason = "Printer is not acknowledging data.";
+                return LinkState::kDegraded;
+            }
+        }
+    }
+    return LinkState::kConnected;
+}
+
+void SendConnectionEvent(const std::string &session_id, LinkState state, const std::string &reason)
+{
+    if (g_connection_events == nullptr || !g_connection_events_listening)
+    {
+        return;
+    }
+    g_autoptr(FlValue) event = fl_value_new_map();
+    fl_value_set_string_take(event, "sessionId", fl_value_new_string(session_id.c_str()));
+    fl_value_set_string_take(event, "state", fl_value_new_string(LinkStateName(state)));
+    if (!reason.empty())
+    {
+        fl_value_set_string_take(event, "reason", fl_value_new_string(reason.c_str()));
+    }
+    fl_event_channel_send(g_connection_events, event, nullptr, nullptr);
+}
+
+// Runs every kLinkWatchIntervalMs while sessions are open and reports state changes. A lost link is left to the next
+// write, which reconnects it; the watcher reports "connected" again once that has happened.
+gboolean WatchSessionLinks(gpointer data)
+{
+    struct Change
+    {
+        std::string session_id;
+        LinkState state;
+        std::string reason;
+    };
+    std::vector<Change> changes;
+    {
+        std::lock_guard<std::mutex> lock(g_sessions_mutex);
+        if (g_sessions.empty())
+        {
+            g_link_watch = 0;
+            return G_SOURCE_REMOVE;
+        }
+        for (auto &entry : g_sessions)
+        {
+            std::string reason;
+            LinkState state;
+            {
+                std::lock_guard<std::mutex> link_lock(entry.second->link_mutex);
+                state = CheckLink(*entry.second, &reason);
+            }
+            if (state != entry.second->link_state)
+            {
+                entry.second->link_state = state;
+                changes.push_back(Change{entry.first, state, reason});
+            }
+        }
+    }
+
+    for (const Change &change : changes)
+    {
+        SendConnectionEvent(change.session_id, change.state, change.reason);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+void EnsureLinkWatch()
+{
+    if (g_link_watch == 0)
+    {
+        g_link_watch = g_timeout_add(kLinkWatchIntervalMs, WatchSessionLinks, nullptr);
+    }
+}
+
+FlMethodErrorResponse *ListenConnectionEvents(FlEventChannel *channel, FlValue *args, gpointer user_data)
+{
+    g_connection_events_listening = true;
+    return nullptr;
+}
+
+FlMethodErrorResponse *CancelConnectionEvents(FlEventChannel *channel, FlValue *args, gpointer user_data)
+{
+    g_connection_events_listening = false;
+    return nullptr;
+}
+
+bool FailLink(std::string *error_code, std::string *error, const char *code, const std::string &message)
+{
+    *error_code = code;
+    *error = message;
+    return false;
+}
+
+// Opens the link described by openConnection args into connection, for a new session or when reconnecting one. On
+// failure error_code is "invalid_args" or "connect_failed".
+bool OpenNativeLink(FlValue *args, NativeConnection *connection, std::string *error_code, std::string *error)
+{
+    std::string transport;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "transport", &transport, &parse_error))
+    {
+        return FailLink(error_code, error, "invalid_args", parse_error);
+    }
+
+    // Like COM ports on Windows, an absolute serialNumber names a device node to open directly.
+    std::string device_path;
+    bool is_device_path = transport == "usb" && ReadOptionalString(args, "serialNumber", &device_path) && !device_path.empty() && device_path[0] == '/';
+
+    if (transport == "wifi")
+    {
+        std::string host;
+        if (!ReadRequiredString(args, "host", &host, &parse_error))
+        {
+            return FailLink(error_code, error, "invalid_args", parse_error);
+        }
+
+        int port = 9100;
+        ReadOptionalInt(args, "port", &port);
+        int timeout_ms = kConnectTimeoutMs;
+        ReadOptionalInt(args, "timeoutMs", &timeout_ms);
+
+        std::string socket_error;
+        int fd = OpenTcpSocket(host, port, timeout_ms, &socket_error);
+        if (fd < 0)
+        {
+            return FailLink(error_code, error, "connect_failed", socket_error);
+        }
+
+        ConfigureDeadPeerDetection(fd);
+        connection->kind = SessionKind::kWifi;
+        connection->fd = fd;
+    }
+    else if (transport == "bluetooth")
+    {
+        std::string address;
+        if (!ReadRequiredString(args, "address", &address, &parse_error))
+        {
+            return FailLink(error_code, error, "invalid_args", parse_error);
+        }
+
+        int channel = 1;
+        int socket_fd = socket(AF_BLUETOOTH, SOCK_STREAM, BTPROTO_RFCOMM);
+        if (socket_fd < 0)
+        {
+            return FailLink(error_code, error, "connect_failed", LastErrnoText("Failed to create Bluetooth socket"));
+        }
+
+        sockaddr_rc addr = {};
+        addr.rc_family = AF_BLUETOOTH;
+        addr.rc_channel = static_cast<uint8_t>(channel);
+        if (str2ba(address.c_str(), &addr.rc_bdaddr) != 0)
+        {
+            close(socket_fd);
+            return FailLink(error_code, error, "invalid_args", "Invalid Bluetooth address.");
+        }
+
+        // Bounded like TCP, since reconnects run on the session writer, which the main thread joins on close.
+        if (!ConnectWithTimeout(socket_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr), kConnectTimeoutMs))
+        {
+            std::string err = LastErrnoText("Failed to connect Bluetooth RFCOMM");
+            close(socket_fd);
+            return FailLink(error_code, error, "connect_failed", err);
+        }
+
+        connection->kind = SessionKind::kBluetooth;
+        connection->fd = socket_fd;
+    }
+    else if (is_device_path)
+    {
+        std::string open_error;
+        int fd = escpos_printer::OpenDeviceFile(device_path, &open_error);
+        if (fd < 0)
+        {
+            return FailLink(error_code, error, "connect_failed", open_error);
+        }
+
+        connection->kind = SessionKind::kDevice;
+        connection->fd = fd;
+        if (isatty(fd))
+        {
+            std::string tty_error;
+            if (!ConfigureTty(fd, args, connection, &tty_error))
+            {
+                close(fd);
+                return FailLink(error_code, error, "connect_failed", tty_error);
+            }
+            connection->kind = SessionKind::kTty;
+        }
+    }
+    else if (transport == "usb")
+    {
+        int vendor_id = 0;
+        int product_id = 0;
+        if (!ReadOptionalInt(args, "vendorId", &vendor_id) || !ReadOptionalInt(args, "productId", &product_id))
+        {
+            return FailLink(error_code, error, "invalid_args", "vendorId and productId are required for USB.");
+        }
+
+        int preferred_interface = -1;
+        ReadOptionalInt(args, "interfaceNumber", &preferred_interface);
+
+        libusb_context *usb_context = nullptr;
+        int rc = libusb_init(&usb_context);
+        if (rc != 0 || usb_context == nullptr)
+        {
+            return FailLink(error_code, error, "connect_failed", "Failed to initialize libusb.");
+        }
+
+        libusb_device_handle *usb_handle = libusb_open_device_with_vid_pid(usb_context, vendor_id, product_id);
+        if (usb_handle == nullptr)
+        {
+            libusb_exit(usb_context);
+            return FailLink(error_code, error, "connect_failed", "USB device not found (vendorId/productId).");
+        }
+
+        int interface_number = -1;
+        uint8_t endpoint_out = 0;
+        uint8_t endpoint_in = 0;
+        if (!FindUsbBulkEndpoints(usb_handle, preferred_interface, &interface_number, &endpoint_out, &endpoint_in))
+        {
+            libusb_close(usb_handle);
+            libusb_exit(usb_context);
+            return FailLink(error_code, error, "connect_failed", "BULK OUT endpoint not found for USB.");
+        }
+
+        if (libusb_kernel_driver_active(usb_handle, interface_number) == 1)
+        {
+            libusb_detach_kernel_driver(usb_handle, interface_number);
+        }
 
         rc = libusb_claim_interface(usb_handle, interface_number);
         if (rc != 0)
         {
-            libusb_close(usb_handle);
-            libusb_exit(usb_context);
-            return MakeErrorResponse("connect_failed", "Failed to claim USB interface.");
+            libusb_close(usb_handle);
+            libusb_exit(usb_context);
+            return FailLink(error_code, error, "connect_failed", "Failed to claim USB interface.");
+        }
+
+        connection->kind = SessionKind::kUsb;
+        connection->usb_context = usb_context;
+        connection->usb_handle = usb_handle;
+        connection->usb_interface_number = interface_number;
+        connection->usb_endpoint_out = endpoint_out;
+        connection->usb_endpoint_in = endpoint_in;
+        if (endpoint_in != 0)
+        {
+            StartUsbInput(connection);
+        }
+    }
+    else
+    {
+        return FailLink(error_code, error, "invalid_args", "Invalid transport. Use wifi, usb, or bluetooth.");
+    }
+
+    // "ioUring" is a request: sessions silently keep send() when the kernel has no usable io_uring.
+    std::string io_backend;
+    bool is_socket = connection->kind == SessionKind::kWifi || connection->kind == SessionKind::kBluetooth;
+    if (is_socket && ReadOptionalString(args, "ioBackend", &io_backend) && io_backend == "ioUring")
+    {
+        connection->use_uring = escpos_printer::UringWriter::Instance() != nullptr;
+    }
+    return true;
+}
+
+// Moves the open link of from (fd, or USB handle and input) into to, leaving from closed.
+void MoveNativeLink(NativeConnection *from, NativeConnection *to)
+{
+    to->fd = std::exchange(from->fd, -1);
+    to->usb_context = std::exchange(from->usb_context, nullptr);
+    to->usb_handle = std::exchange(from->usb_handle, nullptr);
+    to->usb_interface_number = std::exchange(from->usb_interface_number, -1);
+    to->usb_endpoint_out = from->usb_endpoint_out;
+    to->usb_endpoint_in = from->usb_endpoint_in;
+    to->usb_input = std::move(from->usb_input);
+    to->tty_bytes_per_second = from->tty_bytes_per_second;
+}
+
+// Closes the link and opens it again from the session's openConnection args. Runs on the session writer, holding the
+// write turn. The old link is detached and the new one attached under link_mutex, so the main thread sees one link or
+// none; a readBytes call waiting on the old link fails.
+bool ReconnectNativeLink(NativeConnection *connection, std::string *error)
+{
+    NativeConnection old;
+    old.kind = connection->kind;
+    old.use_uring = connection->use_uring;
+    {
+        std::lock_guard<std::mutex> lock(connection->link_mutex);
+        MoveNativeLink(connection, &old);
+    }
+    std::shared_ptr<UsbInput> input = std::move(old.usb_input);
+    if (input != nullptr)
+    {
+        input->reader->Stop();
+        RunOnMainLoop([input]() {
+            if (input->pending_call != nullptr)
+            {
+                FinishPendingRead(input.get(), MakeErrorResponse("read_failed", "Link was reconnected."));
+            }
+        });
+    }
+    CloseNativeLink(&old);
+
+    NativeConnection fresh;
+    std::string error_code;
+    if (!OpenNativeLink(connection->open_args, &fresh, &error_code, error))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(connection->link_mutex);
+    MoveNativeLink(&fresh, connection);
+    return true;
+}
+
+// Opens a session. A printer seen before gets its cached capabilities at once and is re-probed in the background
+// when the entry is older than kCapabilityRevalidateSeconds; an unknown printer that can answer is probed first, and
+// the call is answered when probing ends (nullptr is returned in that case).
+FlMethodResponse *HandleOpenConnection(FlMethodCall *method_call, FlValue *args)
+{
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+    {
+        return MakeErrorResponse("invalid_args", "openConnection requires a map payload.");
+    }
+
+    std::unique_ptr<NativeConnection> connection = std::make_unique<NativeConnection>();
+    std::string error_code;
+    std::string open_error;
+    if (!OpenNativeLink(args, connection.get(), &error_code, &open_error))
+    {
+        return MakeErrorResponse(error_code, open_error);
+    }
+    connection->open_args = fl_value_ref(args);
+
+    int vendor_id = 0;
+    int product_id = 0;
+    if (connection->kind == SessionKind::kUsb && ReadOptionalInt(args, "vendorId", &vendor_id) && ReadOptionalInt(args, "productId", &product_id))
+    {
+        connection->profile = escpos_printer::FindPrinterProfile(static_cast<uint16_t>(vendor_id), static_cast<uint16_t>(product_id));
+        if (connection->profile != nullptr && !connection->profile->has_cutter)
+        {
+            connection->printer_info.supports_partial_cut = false;
+            connection->printer_info.supports_full_cut = false;
+        }
+    }
+
+    // Only links that carry replies back can be probed; device nodes and ttys are opened write-only.
+    bool can_probe = connection->kind == SessionKind::kWifi || connection->kind == SessionKind::kBluetooth ||
+                     (connection->kind == SessionKind::kUsb && connection->usb_input != nullptr);
+    bool probe_now = false;
+    bool revalidate = false;
+    if (can_probe)
+    {
+        connection->device_key = BuildDeviceKey(*connection, args);
+        escpos_printer::PrinterInfo cached;
+        if (escpos_printer::CapabilityCache::Instance().Find(connection->device_key, &cached))
+        {
+            connection->printer_info = cached;
+            connection->capability_source = "cached";
+            revalidate = static_cast<int64_t>(std::time(nullptr)) - cached.probed_at >= kCapabilityRevalidateSeconds;
+        }
+        else
+        {
+            probe_now = true;
+        }
+    }
+
+    std::string session_id = BuildSessionId();
+    StartSessionWriter(connection.get());
+    EnsureLinkWatch();
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    NativeConnection *session = connection.get();
+    {
+        std::lock_guard<std::mutex> writers_lock(g_session_writers_mutex);
+        g_session_writers[session_id] = session->writer;
+    }
+    g_sessions[session_id] = std::move(connection);
+    if (probe_now)
+    {
+        StartCapabilityProbe(session_id, session, method_call);
+        return nullptr;
+    }
+    if (revalidate)
+    {
+        StartCapabilityProbe(session_id, session, nullptr);
+    }
+
+    g_autoptr(FlValue) response_map = MakeOpenConnectionValue(session_id, *session);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(response_map));
+}
+
+// Writes all bytes. When given, acknowledged receives how many of them the printer is known to have received: every
+// byte libusb transferred, or, on sockets, what the peer acknowledged going by the send queue (TIOCOUTQ). It stays 0
+// for paths that cannot tell.
+bool WriteToConnection(NativeConnection *connection, const uint8_t *bytes, size_t length, std::string *error, size_t *acknowledged,
+                       const std::atomic<bool> *cancel)
+{
+    size_t offset = 0;
+    while (offset < length)
+    {
+        if (connection->kind == SessionKind::kUsb)
+        {
+            int transferred = 0;
+            int rc = libusb_bulk_transfer(connection->usb_handle, connection->usb_endpoint_out, const_cast<unsigned char *>(bytes + offset),
+                                          static_cast<int>(length - offset), &transferred, 4000);
+            if (rc != 0 && !(rc == LIBUSB_ERROR_TIMEOUT && transferred > 0))
+            {
+                *error = "Failed to send bytes over USB.";
+                return false;
+            }
+            offset += static_cast<size_t>(transferred);
+            if (acknowledged != nullptr)
+            {
+                *acknowledged = offset;
+            }
+        }
+        else if (connection->kind == SessionKind::kDevice)
+        {
+            return escpos_printer::WriteToDevice(connection->fd, bytes + offset, length - offset, error, cancel);
+        }
+        else if (connection->kind == SessionKind::kTty)
+        {
+            return WriteToTty(connection, bytes + offset, length - offset, error, cancel);
+        }
+        else if (connection->use_uring)
+        {
+            return escpos_printer::UringWriter::Instance()->Write(connection->fd, bytes + offset, length - offset,
+                                                                   connection->kind == SessionKind::kWifi, error);
+        }
+        else
+        {
+            ssize_t written = send(connection->fd, bytes + offset, length - offset, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (written <= 0)
+            {
+                *error = LastErrnoText("Failed to send bytes");
+                return false;
+            }
+            offset += static_cast<size_t>(written);
+            int queued = 0;
+            if (acknowledged != nullptr && ioctl(connection->fd, TIOCOUTQ, &queued) == 0)
+            {
+                // The queue can still hold earlier writes, so this undercounts rather than overcounts.
+                *acknowledged = offset - std::min(offset, static_cast<size_t>(queued));
+            }
+        }
+    }
+
+    return true;
+}
+
+// Sleeps delay_ms before a reconnect attempt. Returns false, at once, when the session is closing.
+bool WaitBeforeReconnect(SessionWriter *writer, int delay_ms)
+{
+    std::unique_lock<std::mutex> lock(writer->mutex);
+    return !writer->wake.wait_for(lock, std::chrono::milliseconds(delay_ms), [writer]() { return writer->stopping; });
+}
+
+// Writes bytes on the session writer, reconnecting the link when it fails. boundaries are the offsets where a job
+// starts, ascending and starting with 0: after a reconnect the write continues from the last one the printer had fully
+// received, so finished jobs are not printed twice and a cut-off job is sent again whole. Without boundaries nothing is
+// sent again: the link is reopened so the session stays usable, and the write fails. reached is how far the printer is
+// known to have got, and reconnected whether the link was reopened.
+bool WriteResumable(NativeConnection *connection, const uint8_t *bytes, size_t length, const std::vector<size_t> &boundaries, size_t *reached,
+                    bool *reconnected, std::string *error)
+{
+    size_t start = 0;
+    size_t confirmed = 0;
+    int attempt = 0;
+    *reconnected = false;
+    for (;;)
+    {
+        size_t acknowledged = 0;
+        if (WriteToConnection(connection, bytes + start, length - start, error, &acknowledged, &connection->closing))
+        {
+            *reached = length;
+            return true;
+        }
+        confirmed = std::max(confirmed, start + acknowledged);
+        *reached = confirmed;
+
+        std::string write_error = *error;
+        bool linked = false;
+        while (!linked && connection->open_args != nullptr && attempt < kReconnectAttempts &&
+               WaitBeforeReconnect(connection->writer.get(), kReconnectBaseDelayMs << attempt))
+        {
+            attempt++;
+            linked = ReconnectNativeLink(connection, error);
+        }
+        if (!linked)
+        {
+            return false;
+        }
+        *reconnected = true;
+        if (boundaries.empty())
+        {
+            *error = write_error;
+            return false;
+        }
+
+        auto boundary = std::upper_bound(boundaries.begin(), boundaries.end(), confirmed);
+        start = boundary == boundaries.begin() ? 0 : *(boundary - 1);
+    }
+}
+
+// Answers a write or writeRetainedJob call from the main loop and drops the references its task held. A failure is
+// write_failed with details {reconnected, bytesAcknowledged}; reconnected means the link was reopened and the session
+// can be written to again, but the cut-off write was not resent.
+void RespondWriteLater(FlMethodCall *method_call, FlValue *bytes, bool ok, const std::string &error, bool reconnected, size_t reached)
+{
+    RunOnMainLoop([method_call, bytes, ok, error, reconnected, reached]() {
+        g_autoptr(FlMethodResponse) response = nullptr;
+        if (ok)
+        {
+            response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+        }
+        else
+        {
+            g_autoptr(FlValue) details = fl_value_new_map();
+            fl_value_set_string_take(details, "reconnected", fl_value_new_bool(reconnected));
+            fl_value_set_string_take(details, "bytesAcknowledged", fl_value_new_int(static_cast<int64_t>(reached)));
+            response = FL_METHOD_RESPONSE(fl_method_error_response_new("write_failed", error.c_str(), details));
+        }
+        fl_method_call_respond(method_call, response, nullptr);
+        g_object_unref(method_call);
+        if (bytes != nullptr)
+        {
+            fl_value_unref(bytes);
+        }
+    });
+}
+
+// Queues the bytes on the session writer and answers once they are written; returns nullptr in that case. A single
+// write is not resumable: after a reconnect it is reported as failed rather than printed again from its start.
+FlMethodResponse *HandleWrite(FlMethodCall *method_call, FlValue *args)
+{
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+    {
+        return MakeErrorResponse("invalid_args", "write requires a map payload.");
+    }
+
+    std::string session_id;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "sessionId", &session_id, &parse_error))
+    {
+        return MakeErrorResponse("invalid_args", parse_error);
+    }
+
+    FlValue *bytes_value = fl_value_lookup_string(args, "bytes");
+    if (IsNullValue(bytes_value) || fl_value_get_type(bytes_value) != FL_VALUE_TYPE_UINT8_LIST)
+    {
+        return MakeErrorResponse("invalid_args", "bytes field must be Uint8List.");
+    }
+
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    auto iterator = g_sessions.find(session_id);
+    if (iterator == g_sessions.end())
+    {
+        return MakeErrorResponse("invalid_session", "Session not found.");
+    }
+
+    FlMethodCall *call = FL_METHOD_CALL(g_object_ref(method_call));
+    FlValue *bytes = fl_value_ref(bytes_value);
+    WriteTask task;
+    task.run = [call, bytes](NativeConnection *connection) {
+        std::string error;
+        size_t reached = 0;
+        bool reconnected = false;
+        bool ok = WriteResumable(connection, fl_value_get_uint8_list(bytes), fl_value_get_length(bytes), {}, &reached, &reconnected, &error);
+        RespondWriteLater(call, bytes, ok, error, reconnected, reached);
+    };
+    task.cancel = [call, bytes](const char *reason) { RespondWriteLater(call, bytes, false, reason, false, 0); };
+    QueueWriteTask(iterator->second->writer.get(), std::move(task));
+    return nullptr;
+}
+
+// writeBatch answer: per-job offset, length and status, bytesWritten, error and whether the session reconnected.
+FlMethodResponse *MakeBatchResponse(const std::vector<size_t> &job_lengths, bool failed, size_t reached, bool reconnected, const std::string &error)
+{
+    g_autoptr(FlValue) jobs = fl_value_new_list();
+    bool failure_reported = false;
+    size_t offset = 0;
+    size_t bytes_written = 0;
+    for (size_t job_length : job_lengths)
+    {
+        const char *status = "notSent";
+        if (!failed || offset + job_length <= reached)
+        {
+            status = "written";
+            bytes_written += job_length;
+        }
+        else if (!failure_reported)
+        {
+            status = "failed";
+            failure_reported = true;
+        }
+
+        g_autoptr(FlValue) job = fl_value_new_map();
+        fl_value_set_string_take(job, "offset", fl_value_new_int(static_cast<int64_t>(offset)));
+        fl_value_set_string_take(job, "length", fl_value_new_int(static_cast<int64_t>(job_length)));
+        fl_value_set_string_take(job, "status", fl_value_new_string(status));
+        fl_value_append(jobs, job);
+        offset += job_length;
+    }
+
+    g_autoptr(FlValue) response_map = fl_value_new_map();
+    fl_value_set_string(response_map, "jobs", jobs);
+    fl_value_set_string_take(response_map, "bytesWritten", fl_value_new_int(static_cast<int64_t>(bytes_written)));
+    fl_value_set_string_take(response_map, "error", failed ? fl_value_new_string(error.c_str()) : fl_value_new_null());
+    fl_value_set_string_take(response_map, "reconnected", fl_value_new_bool(reconnected));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(response_map));
+}
+
+// Writes each job of a concatenated batch in turn on the session writer and reports per-job offset, length and
+// status; returns nullptr once the batch is queued. After a reconnect the write resumes at the first job the printer
+// had not fully received. A failure that outlasts the reconnects stops the batch: the first job not fully received is
+// "failed" and the rest "notSent".
+FlMethodResponse *HandleWriteBatch(FlMethodCall *method_call, FlValue *args)
+{
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+    {
+        return MakeErrorResponse("invalid_args", "writeBatch requires a map payload.");
+    }
+
+    std::string session_id;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "sessionId", &session_id, &parse_error))
+    {
+        return MakeErrorResponse("invalid_args", parse_error);
+    }
+
+    FlValue *bytes_value = fl_value_lookup_string(args, "bytes");
+    if (IsNullValue(bytes_value) || fl_value_get_type(bytes_value) != FL_VALUE_TYPE_UINT8_LIST)
+    {
+        return MakeErrorResponse("invalid_args", "bytes field must be Uint8List.");
+    }
+
+    FlValue *lengths_value = fl_value_lookup_string(args, "jobLengths");
+    if (IsNullValue(lengths_value) || fl_value_get_type(lengths_value) != FL_VALUE_TYPE_LIST)
+    {
+        return MakeErrorResponse("invalid_args", "jobLengths field must be a list.");
+    }
+
+    std::vector<size_t> job_lengths;
+    size_t total = 0;
+    for (size_t i = 0; i < fl_value_get_length(lengths_value); i++)
+    {
+        FlValue *item = fl_value_get_list_value(lengths_value, i);
+        if (fl_value_get_type(item) != FL_VALUE_TYPE_INT || fl_value_get_int(item) < 0)
+        {
+            return MakeErrorResponse("invalid_args", "jobLengths must contain non-negative integers.");
+        }
+        job_lengths.push_back(static_cast<size_t>(fl_value_get_int(item)));
+        total += job_lengths.back();
+    }
+    if (total != fl_value_get_length(bytes_value))
+    {
+        return MakeErrorResponse("invalid_args", "jobLengths do not add up to the bytes length.");
+    }
+
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    auto iterator = g_sessions.find(session_id);
+    if (iterator == g_sessions.end())
+    {
+        return MakeErrorResponse("invalid_session", "Session not found.");
+    }
+
+    FlMethodCall *call = FL_METHOD_CALL(g_object_ref(method_call));
+    FlValue *bytes = fl_value_ref(bytes_value);
+    auto respond = [call, bytes, job_lengths](bool failed, size_t reached, bool reconnected, const std::string &error) {
+        RunOnMainLoop([call, bytes, job_lengths, failed, reached, reconnected, error]() {
+            g_autoptr(FlMethodResponse) response = MakeBatchResponse(job_lengths, failed, reached, reconnected, error);
+            fl_method_call_respond(call, response, nullptr);
+            g_object_unref(call);
+            fl_value_unref(bytes);
+        });
+    };
+    WriteTask task;
+    task.run = [bytes, job_lengths, respond](NativeConnection *connection) {
+        std::vector<size_t> job_starts;
+        size_t start = 0;
+        for (size_t job_length : job_lengths)
+        {
+            job_starts.push_back(start);
+            start += job_length;
+        }
+
+        std::string error;
+        size_t reached = 0;
+        bool reconnected = false;
+        bool ok = WriteResumable(connection, fl_value_get_uint8_list(bytes), fl_value_get_length(bytes), job_starts, &reached, &reconnected, &error);
+        respond(!ok, reached, reconnected, error);
+    };
+    task.cancel = [respond](const char *reason) { respond(true, 0, false, reason); };
+    QueueWriteTask(iterator->second->writer.get(), std::move(task));
+    return nullptr;
+}
+
+// Keeps a job (and an optional separator, such as a cut between copies) on the session and answers with its job ID.
+// writeRetainedJob then prints it as often as needed while the bytes cross the channel once.
+FlMethodResponse *HandleRetainJob(FlValue *args)
+{
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+    {
+        return MakeErrorResponse("invalid_args", "retainJob requires a map payload.");
+    }
+
+    std::string session_id;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "sessionId", &session_id, &parse_error))
+    {
+        return MakeErrorResponse("invalid_args", parse_error);
+    }
+
+    FlValue *bytes_value = fl_value_lookup_string(args, "bytes");
+    if (IsNullValue(bytes_value) || fl_value_get_type(bytes_value) != FL_VALUE_TYPE_UINT8_LIST)
+    {
+        return MakeErrorResponse("invalid_args", "bytes field must be Uint8List.");
+    }
+    FlValue *separator_value = fl_value_lookup_string(args, "separator");
+    if (!IsNullValue(separator_value) && fl_value_get_type(separator_value) != FL_VALUE_TYPE_UINT8_LIST)
+    {
+        return MakeErrorResponse("invalid_args", "separator field must be Uint8List.");
+    }
+
+    const uint8_t *bytes = fl_value_get_uint8_list(bytes_value);
+    size_t length = fl_value_get_length(bytes_value);
+    const uint8_t *separator = IsNullValue(separator_value) ? nullptr : fl_value_get_uint8_list(separator_value);
+    size_t separator_length = separator == nullptr ? 0 : fl_value_get_length(separator_value);
+
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    auto iterator = g_sessions.find(session_id);
+    if (iterator == g_sessions.end())
+    {
+        return MakeErrorResponse("invalid_session", "Session not found.");
+    }
+
+    NativeConnection *connection = iterator->second.get();
+    if (connection->retained_bytes + length + separator_length > kMaxRetainedBytes)
+    {
+        return MakeErrorResponse("retain_limit", "The session already retains too many bytes; release a job first.");
+    }
+
+    RetainedJob job;
+    job.bytes.reserve(length + separator_length);
+    job.bytes.insert(job.bytes.end(), bytes, bytes + length);
+    if (separator != nullptr)
+    {
+        job.bytes.insert(job.bytes.end(), separator, separator + separator_length);
+    }
+    job.job_length = length;
+
+    std::string job_id = "job-" + std::to_string(connection->next_retained_job++);
+    connection->retained_bytes += job.bytes.size();
+    connection->retained_jobs.emplace(job_id, std::make_shared<const RetainedJob>(std::move(job)));
+
+    g_autoptr(FlValue) response_map = fl_value_new_map();
+    fl_value_set_string_take(response_map, "jobId", fl_value_new_string(job_id.c_str()));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(response_map));
+}
+
+// Writes one copy of a retained job, followed by its separator when withSeparator is true, on the session writer;
+// returns nullptr once it is queued. Like write, a copy cut off by a reconnect is reported, not printed again.
+FlMethodResponse *HandleWriteRetainedJob(FlMethodCall *method_call, FlValue *args)
+{
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+    {
+        return MakeErrorResponse("invalid_args", "writeRetainedJob requires a map payload.");
+    }
+
+    std::string session_id;
+    std::string job_id;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "sessionId", &session_id, &parse_error) || !ReadRequiredString(args, "jobId", &job_id, &parse_error))
+    {
+        return MakeErrorResponse("invalid_args", parse_error);
+    }
+    FlValue *separator_value = fl_value_lookup_string(args, "withSeparator");
+    bool with_separator = !IsNullValue(separator_value) && fl_value_get_type(separator_value) == FL_VALUE_TYPE_BOOL &&
+                          fl_value_get_bool(separator_value);
+
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    auto iterator = g_sessions.find(session_id);
+    if (iterator == g_sessions.end())
+    {
+        return MakeErrorResponse("invalid_session", "Session not found.");
+    }
+
+    NativeConnection *connection = iterator->second.get();
+    auto job = connection->retained_jobs.find(job_id);
+    if (job == connection->retained_jobs.end())
+    {
+        return MakeErrorResponse("invalid_job", "Retained job not found.");
+    }
+
+    std::shared_ptr<const RetainedJob> retained = job->second;
+    size_t length = with_separator ? retained->bytes.size() : retained->job_length;
+    FlMethodCall *call = FL_METHOD_CALL(g_object_ref(method_call));
+    WriteTask task;
+    task.run = [call, retained, length](NativeConnection *connection) {
+        std::string error;
+        size_t reached = 0;
+        bool reconnected = false;
+        bool ok = WriteResumable(connection, retained->bytes.data(), length, {}, &reached, &reconnected, &error);
+        RespondWriteLater(call, nullptr, ok, error, reconnected, reached);
+    };
+    task.cancel = [call](const char *reason) { RespondWriteLater(call, nullptr, false, reason, false, 0); };
+    QueueWriteTask(connection->writer.get(), std::move(task));
+    return nullptr;
+}
+
+FlMethodResponse *HandleReleaseJob(FlValue *args)
+{
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+    {
+        return MakeErrorResponse("invalid_args", "releaseJob requires a map payload.");
+    }
+
+    std::string session_id;
+    std::string job_id;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "sessionId", &session_id, &parse_error) || !ReadRequiredString(args, "jobId", &job_id, &parse_error))
+    {
+        return MakeErrorResponse("invalid_args", parse_error);
+    }
+
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    auto iterator = g_sessions.find(session_id);
+    if (iterator != g_sessions.end())
+    {
+        NativeConnection *connection = iterator->second.get();
+        auto job = connection->retained_jobs.find(job_id);
+        if (job != connection->retained_jobs.end())
+        {
+            connection->retained_bytes -= job->second->bytes.size();
+            connection->retained_jobs.erase(job);
+        }
+    }
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+void DeleteJobStreamRef(gpointer data)
+{
+    delete static_cast<std::weak_ptr<JobStream> *>(data);
+}
+
+gboolean ServiceJobStream(gpointer data);
+
+void ScheduleJobStreamService(const std::shared_ptr<JobStream> &stream)
+{
+    g_idle_add_full(G_PRIORITY_DEFAULT, ServiceJobStream, new std::weak_ptr<JobStream>(stream), DeleteJobStreamRef);
+}
+
+// Writes ring contents to the printer until the job is committed and drained, aborted, or a write fails. Only reads
+// the occupied part of the ring, which the main thread does not touch, so the write runs without the lock.
+//
+// The write turn is held from the first span to the end of the stream. Spans end at arbitrary ring offsets, possibly
+// inside a command or raster data, so nothing else may write to the printer until the whole job is out.
+void DrainJobStream(NativeConnection *connection, JobStream *stream, std::weak_ptr<JobStream> weak_stream)
+{
+    bool holding_turn = false;
+    std::unique_lock<std::mutex> lock(stream->mutex);
+    for (;;)
+    {
+        stream->wake.wait(lock, [stream]() { return stream->size > 0 || stream->committed || stream->aborted; });
+        if (stream->aborted || stream->size == 0)
+        {
+            break;
+        }
+
+        size_t span = std::min({stream->size, kJobRingBytes - stream->head, kJobSpanBytes});
+        const uint8_t *bytes = stream->ring.data() + stream->head;
+        lock.unlock();
+        std::string error;
+        bool ok = false;
+        if (!holding_turn && !TakeWriteTurn(stream->write_turn, &stream->stop))
+        {
+            error = "Session was closed.";
+        }
+        else
+        {
+            holding_turn = true;
+            ok = WriteToConnection(connection, bytes, span, &error, nullptr, &stream->stop);
+        }
+        lock.lock();
+        if (!ok)
+        {
+            stream->failed = true;
+            stream->error = error;
+            break;
+        }
+        stream->head = (stream->head + span) % kJobRingBytes;
+        stream->size -= span;
+        // There is room now; a waiting appendChunk can continue.
+        g_idle_add_full(G_PRIORITY_DEFAULT, ServiceJobStream, new std::weak_ptr<JobStream>(weak_stream), DeleteJobStreamRef);
+    }
+    stream->finished = true;
+    lock.unlock();
+    if (holding_turn)
+    {
+        ReleaseWriteTurn(stream->write_turn);
+    }
+    g_idle_add_full(G_PRIORITY_DEFAULT, ServiceJobStream, new std::weak_ptr<JobStream>(weak_stream), DeleteJobStreamRef);
+}
+
+// Copies as much of the waiting appendChunk as fits into the ring. Returns true once the whole chunk is in.
+bool FillJobRing(JobStream *stream)
+{
+    const uint8_t *bytes = fl_value_get_uint8_list(stream->append_chunk);
+    size_t length = fl_value_get_length(stream->append_chunk);
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        while (stream->append_offset < length && stream->size < kJobRingBytes)
+        {
+            size_t tail = (stream->head + stream->size) % kJobRingBytes;
+            size_t span = std::min({length - stream->append_offset, kJobRingBytes - stream->size, kJobRingBytes - tail});
+            memcpy(stream->ring.data() + tail, bytes + stream->append_offset, span);
+            stream->size += span;
+            stream->append_offset += span;
+        }
+    }
+    stream->wake.notify_one();
+    return stream->append_offset == length;
+}
+
+void FinishJobAppend(JobStream *stream, FlMethodResponse *response)
+{
+    RespondJobCall(&stream->append_call, response);
+    fl_value_unref(stream->append_chunk);
+    stream->append_chunk = nullptr;
+    stream->append_offset = 0;
+}
+
+// Ends a drained stream: detaches it from its session and answers commitJob.
+void FinishJobStream(const std::shared_ptr<JobStream> &stream)
+{
+    if (stream->drainer.joinable())
+    {
+        stream->drainer.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_sessions_mutex);
+        auto iterator = g_sessions.find(stream->session_id);
+        if (iterator != g_sessions.end() && iterator->second->job_stream == stream)
+        {
+            iterator->second->job_stream.reset();
+        }
+    }
+    RespondJobCall(&stream->commit_call, stream->failed ? MakeErrorResponse("write_failed", stream->error)
+                                                        : FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr)));
+}
+
+// Main-thread follow-up to the drainer: refills the ring for a waiting appendChunk and answers commitJob once done.
+gboolean ServiceJobStream(gpointer data)
+{
+    std::shared_ptr<JobStream> stream = static_cast<std::weak_ptr<JobStream> *>(data)->lock();
+    if (stream == nullptr)
+    {
+        return G_SOURCE_REMOVE;
+    }
+
+    bool failed = false;
+    bool finished = false;
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        failed = stream->failed;
+        finished = stream->finished;
+        error = stream->error;
+    }
+
+    if (stream->append_call != nullptr)
+    {
+        if (failed)
+        {
+            FinishJobAppend(stream.get(), MakeErrorResponse("write_failed", error));
+        }
+        else if (FillJobRing(stream.get()))
+        {
+            FinishJobAppend(stream.get(), FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr)));
+        }
+    }
+    if (finished && stream->commit_call != nullptr)
+    {
+        FinishJobStream(stream);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// Looks up the job stream named by args. On failure returns the error response to send.
+FlMethodResponse *FindJobStream(FlValue *args, const char *method, std::shared_ptr<JobStream> *stream)
+{
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+    {
+        return MakeErrorResponse("invalid_args", std::string(method) + " requires a map payload.");
+    }
+
+    std::string session_id;
+    std::string job_id;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "sessionId", &session_id, &parse_error) || !ReadRequiredString(args, "jobId", &job_id, &parse_error))
+    {
+        return MakeErrorResponse("invalid_args", parse_error);
+    }
+
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    auto iterator = g_sessions.find(session_id);
+    if (iterator == g_sessions.end())
+    {
+        return MakeErrorResponse("invalid_session", "Session not found.");
+    }
+    const std::shared_ptr<JobStream> &current = iterator->second->job_stream;
+    if (current == nullptr || current->id != job_id)
+    {
+        return MakeErrorResponse("invalid_job", "Job stream not found.");
+    }
+    *stream = current;
+    return nullptr;
+}
+
+// Opens a job stream on the session and starts its drainer. A session has at most one.
+FlMethodResponse *HandleBeginJob(FlValue *args)
+{
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
+    {
+        return MakeErrorResponse("invalid_args", "beginJob requires a map payload.");
+    }
+
+    std::string session_id;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "sessionId", &session_id, &parse_error))
+    {
+        return MakeErrorResponse("invalid_args", parse_error);
+    }
+
+    std::lock_guard<std::mutex> lock(g_sessions_mutex);
+    auto iterator = g_sessions.find(session_id);
+    if (iterator == g_sessions.end())
+    {
+        return MakeErrorResponse("invalid_session", "Session not found.");
+    }
+
+    NativeConnection *connection = iterator->second.get();
+    if (connection->job_stream != nullptr)
+    {
+        return MakeErrorResponse("job_in_progress", "The session already has an open job stream.");
+    }
+
+    auto stream = std::make_shared<JobStream>();
+    stream->id = "stream-" + std::to_string(connection->next_job_stream++);
+    stream->session_id = session_id;
+    stream->write_turn = &connection->write_turn;
+    stream->drainer = std::thread(DrainJobStream, connection, stream.get(), std::weak_ptr<JobStream>(stream));
+    connection->job_stream = stream;
+
+    g_autoptr(FlValue) response_map = fl_value_new_map();
+    fl_value_set_string_take(response_map, "jobId", fl_value_new_string(stream->id.c_str()));
+    fl_value_set_string_take(response_map, "capacity", fl_value_new_int(static_cast<int64_t>(kJobRingBytes)));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(response_map));
+}
+
+// Copies a chunk into the ring. When it does not fit, the call is answered once the drainer has made room for all of
+// it, which is how Dart is slowed to the printer's pace. Returns nullptr once the call is taken; it is answered from
+// here or from ServiceJobStream. One appendChunk at a time.
+FlMethodResponse *HandleAppendChunk(FlMethodCall *method_call, FlValue *args)
+{
+    std::shared_ptr<JobStream> stream;
+    FlMethodResponse *error_response = FindJobStream(args, "appendChunk", &stream);
+    if (error_response != nullptr)
+    {
+        return error_response;
+    }
+
+    FlValue *bytes_value = fl_value_lookup_string(args, "bytes");
+    if (IsNullValue(bytes_value) || fl_value_get_type(bytes_value) != FL_VALUE_TYPE_UINT8_LIST)
+    {
+        return MakeErrorResponse("invalid_args", "bytes field must be Uint8List.");
+    }
+    if (stream->append_call != nullptr || stream->commit_call != nullptr)
+    {
+        return MakeErrorResponse("invalid_state", "appendChunk called while another call on the job is pending.");
+    }
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        if (stream->failed)
+        {
+            return MakeErrorResponse("write_failed", stream->error);
         }
+    }
 
-        connection->kind = SessionKind::kUsb;
-        connection->usb_context = usb_context;
-        connection->usb_handle = usb_handle;
-        connection->usb_interface_number = interface_number;
-        connection->usb_endpoint_out = endpoint_out;
+    stream->append_call = FL_METHOD_CALL(g_object_ref(method_call));
+    stream->append_chunk = fl_value_ref(bytes_value);
+    stream->append_offset = 0;
+    if (FillJobRing(stream.get()))
+    {
+        FinishJobAppend(stream.get(), FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr)));
     }
-    else
+    return nullptr;
+}
+
+// Answered once every byte in the ring reached the printer (or a write failed); returns nullptr until then.
+FlMethodResponse *HandleCommitJob(FlMethodCall *method_call, FlValue *args)
+{
+    std::shared_ptr<JobStream> stream;
+    FlMethodResponse *error_response = FindJobStream(args, "commitJob", &stream);
+    if (error_response != nullptr)
     {
-        return MakeErrorResponse("invalid_args", "Invalid transport. Use wifi, usb, or bluetooth.");
+        return error_response;
+    }
+    if (stream->append_call != nullptr || stream->commit_call != nullptr)
+    {
+        return MakeErrorResponse("invalid_state", "commitJob called while another call on the job is pending.");
     }
 
-    std::string session_id = BuildSessionId();
+    stream->commit_call = FL_METHOD_CALL(g_object_ref(method_call));
     {
-        std::lock_guard<std::mutex> lock(g_sessions_mutex);
-        g_sessions[session_id] = std::move(connection);
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->committed = true;
     }
+    stream->wake.notify_one();
+    ScheduleJobStreamService(stream);
+    return nullptr;
+}
 
-    g_autoptr(FlValue) response_map = fl_value_new_map();
-    fl_value_set_string(response_map, "sessionId", fl_value_new_string(session_id.c_str()));
-    fl_value_set_string(response_map, "capabilities", MakeCapabilitiesValue(false));
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(response_map));
+// Drops bytes not yet written and closes the stream. Unknown jobs are already closed.
+FlMethodResponse *HandleAbortJob(FlValue *args)
+{
+    std::shared_ptr<JobStream> stream;
+    FlMethodResponse *error_response = FindJobStream(args, "abortJob", &stream);
+    if (error_response != nullptr)
+    {
+        g_object_unref(error_response);
+        return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+    }
+
+    StopJobStream(stream, "Job was aborted.");
+    {
+        std::lock_guard<std::mutex> lock(g_sessions_mutex);
+        auto iterator = g_sessions.find(stream->session_id);
+        if (iterator != g_sessions.end() && iterator->second->job_stream == stream)
+        {
+            iterator->second->job_stream.reset();
+        }
+    }
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
-FlMethodResponse *HandleWrite(FlValue *args)
+// Serves bytes buffered from the USB bulk IN endpoint. With nothing buffered the call is answered later, when bytes
+// arrive or timeoutMs expires (with an empty list); returns nullptr in that case. While a capability probe waits for
+// its reply, nothing counts as buffered.
+FlMethodResponse *HandleReadBytes(FlMethodCall *method_call, FlValue *args)
 {
     if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP)
     {
-        return MakeErrorResponse("invalid_args", "write requires a map payload.");
+        return MakeErrorResponse("invalid_args", "readBytes requires a map payload.");
     }
 
     std::string session_id;
@@ -643,43 +2973,51 @@ FlMethodResponse *HandleWrite(FlValue *args)
         return MakeErrorResponse("invalid_args", parse_error);
     }
 
-    FlValue *bytes_value = fl_value_lookup_string(args, "bytes");
-    if (IsNullValue(bytes_value) || fl_value_get_type(bytes_value) != FL_VALUE_TYPE_UINT8_LIST)
+    int max_bytes = 256;
+    ReadOptionalInt(args, "maxBytes", &max_bytes);
+    int timeout_ms = 0;
+    ReadOptionalInt(args, "timeoutMs", &timeout_ms);
+    if (max_bytes <= 0)
     {
-        return MakeErrorResponse("invalid_args", "bytes field must be Uint8List.");
+        return MakeErrorResponse("invalid_args", "maxBytes must be positive.");
     }
 
-    const uint8_t *bytes = fl_value_get_uint8_list(bytes_value);
-    size_t length = fl_value_get_length(bytes_value);
-
-    std::lock_guard<std::mutex> lock(g_sessions_mutex);
-    auto iterator = g_sessions.find(session_id);
-    if (iterator == g_sessions.end())
+    std::shared_ptr<UsbInput> input;
+    bool reconnecting = false;
     {
-        return MakeErrorResponse("invalid_session", "Session not found.");
+        std::lock_guard<std::mutex> lock(g_sessions_mutex);
+        auto iterator = g_sessions.find(session_id);
+        if (iterator == g_sessions.end())
+        {
+            return MakeErrorResponse("invalid_session", "Session not found.");
+        }
+        std::lock_guard<std::mutex> link_lock(iterator->second->link_mutex);
+        input = iterator->second->usb_input;
+        reconnecting = iterator->second->kind == SessionKind::kUsb && iterator->second->usb_handle == nullptr;
     }
 
-    NativeConnection *connection = iterator->second.get();
-    if (connection->kind == SessionKind::kUsb)
+    if (reconnecting)
     {
-        int transferred = 0;
-        int rc = libusb_bulk_transfer(connection->usb_handle, connection->usb_endpoint_out, const_cast<unsigned char *>(bytes), static_cast<int>(length),
-                                      &transferred, 4000);
-        if (rc != 0 || transferred != static_cast<int>(length))
-        {
-            return MakeErrorResponse("write_failed", "Failed to send bytes over USB.");
-        }
+        return MakeErrorResponse("read_failed", "Link is being reconnected.");
     }
-    else
+    if (input == nullptr)
     {
-        ssize_t written = send(connection->fd, bytes, length, 0);
-        if (written < 0 || static_cast<size_t>(written) != length)
-        {
-            return MakeErrorResponse("write_failed", LastErrnoText("Failed to send bytes"));
-        }
+        return MakeErrorResponse("unsupported", "This session has no readable endpoint.");
+    }
+    if (input->pending_call != nullptr)
+    {
+        return MakeErrorResponse("read_in_progress", "Another readBytes call is waiting on this session.");
+    }
+    if (timeout_ms <= 0 || (!input->probing && (input->reader->Available() > 0 || !input->reader->Error().empty())))
+    {
+        return TakeBytesResponse(input.get(), static_cast<size_t>(max_bytes));
     }
 
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+    input->pending_call = FL_METHOD_CALL(g_object_ref(method_call));
+    input->pending_max_bytes = static_cast<size_t>(max_bytes);
+    input->pending_timeout =
+        g_timeout_add_full(G_PRIORITY_DEFAULT, static_cast<guint>(timeout_ms), ExpirePendingRead, new std::weak_ptr<UsbInput>(input), DeleteUsbInputRef);
+    return nullptr;
 }
 
 FlMethodResponse *HandleReadStatus(FlValue *args)
@@ -703,6 +3041,11 @@ FlMethodResponse *HandleReadStatus(FlValue *args)
         return MakeErrorResponse("invalid_session", "Session not found.");
     }
 
+    if (iterator->second->kind == SessionKind::kDevice)
+    {
+        std::lock_guard<std::mutex> link_lock(iterator->second->link_mutex);
+        return FL_METHOD_RESPONSE(fl_method_success_response_new(ReadDeviceStatusValue(iterator->second->fd)));
+    }
     return FL_METHOD_RESPONSE(fl_method_success_response_new(MakeUnknownStatusValue()));
 }
 
@@ -732,6 +3075,7 @@ FlMethodResponse *HandleCloseConnection(FlValue *args)
         connection = std::move(iterator->second);
         g_sessions.erase(iterator);
     }
+    UnlistSessionWriter(session_id);
 
     CloseNativeConnection(connection.get());
     return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
@@ -759,24 +3103,237 @@ FlMethodResponse *HandleGetCapabilities(FlValue *args)
     }
 
     g_autoptr(FlValue) result_map = fl_value_new_map();
-    fl_value_set_string(result_map, "capabilities", MakeCapabilitiesValue(false));
+    fl_value_set_string(result_map, "capabilities", MakeCapabilitiesValue(*iterator->second));
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result_map));
 }
 
-FlMethodResponse *HandleSearchPrinters(FlValue *args)
+// One searchPrinters or startDiscovery call. Each transport is searched on its own thread and every device is handed
+// to the main thread as soon as it is found: startDiscovery sends it on the discovery events channel, searchPrinters
+// collects it for its response. The run ends when all threads are done or timeoutMs expires, whichever is first;
+// threads still running then see `finished` and drop what they find.
+struct DiscoveryRun
+{
+    std::string id;
+    // searchPrinters only: the deferred call and the devices collected for it.
+    FlMethodCall *method_call = nullptr;
+    FlValue *collected = nullptr;
+    // Main thread only.
+    int workers_left = 0;
+    guint deadline = 0;
+    std::atomic<bool> finished{false};
+};
+
+struct DiscoveredDevice
+{
+    std::shared_ptr<DiscoveryRun> run;
+    FlValue *device;
+};
+
+void SendDiscoveryEvent(const std::string &discovery_id, FlValue *device)
+{
+    if (g_discovery_events == nullptr || !g_discovery_events_listening)
+    {
+        return;
+    }
+    g_autoptr(FlValue) event = fl_value_new_map();
+    fl_value_set_string_take(event, "discoveryId", fl_value_new_string(discovery_id.c_str()));
+    if (device != nullptr)
+    {
+        fl_value_set_string(event, "device", device);
+    }
+    else
+    {
+        fl_value_set_string_take(event, "done", fl_value_new_bool(true));
+    }
+    fl_event_channel_send(g_discovery_events, event, nullptr, nullptr);
+}
+
+void FinishDiscovery(const std::shared_ptr<DiscoveryRun> &run)
+{
+    if (run->finished.exchange(true))
+    {
+        return;
+    }
+    if (run->deadline != 0)
+    {
+        g_source_remove(run->deadline);
+        run->deadline = 0;
+    }
+
+    if (run->method_call != nullptr)
+    {
+        g_autoptr(FlMethodResponse) response = FL_METHOD_RESPONSE(fl_method_success_response_new(run->collected));
+        fl_method_call_respond(run->method_call, response, nullptr);
+        g_object_unref(run->method_call);
+        fl_value_unref(run->collected);
+        run->method_call = nullptr;
+        run->collected = nullptr;
+    }
+    else
+    {
+        SendDiscoveryEvent(run->id, nullptr);
+    }
+    g_discoveries.erase(run->id);
+}
+
+gboolean DeliverDiscoveredDevice(gpointer data)
+{
+    std::unique_ptr<DiscoveredDevice> found(static_cast<DiscoveredDevice *>(data));
+    if (!found->run->finished)
+    {
+        if (found->run->method_call != nullptr)
+        {
+            fl_value_append(found->run->collected, found->device);
+        }
+        else
+        {
+            SendDiscoveryEvent(found->run->id, found->device);
+        }
+    }
+    fl_value_unref(found->device);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean FinishDiscoveryWorker(gpointer data)
 {
-    g_autoptr(FlValue) devices = fl_value_new_list();
+    std::unique_ptr<std::shared_ptr<DiscoveryRun>> run(static_cast<std::shared_ptr<DiscoveryRun> *>(data));
+    if (--(*run)->workers_left == 0)
+    {
+        FinishDiscovery(*run);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+gboolean ExpireDiscovery(gpointer data)
+{
+    std::shared_ptr<DiscoveryRun> run = *static_cast<std::shared_ptr<DiscoveryRun> *>(data);
+    run->deadline = 0;
+    FinishDiscovery(run);
+    return G_SOURCE_REMOVE;
+}
+
+void DeleteDiscoveryRunRef(gpointer data)
+{
+    delete static_cast<std::shared_ptr<DiscoveryRun> *>(data);
+}
+
+void StartDiscoveryWorker(const std::shared_ptr<DiscoveryRun> &run, std::function<void(const DeviceSink &)> search)
+{
+    run->workers_left++;
+    std::thread([run, search = std::move(search)]() {
+        search([&run](FlValue *device) {
+            if (run->finished)
+            {
+                fl_value_unref(device);
+                return false;
+            }
+            g_idle_add(DeliverDiscoveredDevice, new DiscoveredDevice{run, device});
+            return true;
+        });
+        g_idle_add(FinishDiscoveryWorker, new std::shared_ptr<DiscoveryRun>(run));
+    }).detach();
+}
+
+// Starts the transport threads of a run; a run with nothing to search finishes at once.
+void StartDiscovery(const std::shared_ptr<DiscoveryRun> &run, FlValue *args)
+{
+    int timeout_ms = kDiscoveryTimeoutMs;
+    ReadOptionalInt(args, "timeoutMs", &timeout_ms);
+    timeout_ms = std::max(timeout_ms, 0);
+    g_discoveries[run->id] = run;
 
     if (ShouldDiscoverTransport(args, "usb"))
     {
-        AppendUsbDiscoveryDevices(devices);
+        StartDiscoveryWorker(run, [](const DeviceSink &sink) {
+            DiscoverUsbDevices(sink);
+            DiscoverLpDevices(sink);
+        });
     }
     if (ShouldDiscoverTransport(args, "bluetooth"))
     {
-        AppendBluetoothDiscoveryDevices(devices);
+        StartDiscoveryWorker(run, [timeout_ms](const DeviceSink &sink) { DiscoverBluetoothDevices(sink, timeout_ms); });
+    }
+
+    if (run->workers_left == 0)
+    {
+        FinishDiscovery(run);
+        return;
+    }
+    run->deadline = g_timeout_add_full(G_PRIORITY_DEFAULT, static_cast<guint>(timeout_ms), ExpireDiscovery,
+                                       new std::shared_ptr<DiscoveryRun>(run), DeleteDiscoveryRunRef);
+}
+
+// Answered with every device found when discovery ends; returns nullptr because the response is always deferred.
+FlMethodResponse *HandleSearchPrinters(FlMethodCall *method_call, FlValue *args)
+{
+    auto run = std::make_shared<DiscoveryRun>();
+    static uint64_t search_counter = 0;
+    run->id = "search-" + std::to_string(++search_counter);
+    run->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+    run->collected = fl_value_new_list();
+    StartDiscovery(run, args);
+    return nullptr;
+}
+
+// Streams devices on the discovery events channel under the caller's discoveryId, then a `done` event.
+FlMethodResponse *HandleStartDiscovery(FlValue *args)
+{
+    std::string discovery_id;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "discoveryId", &discovery_id, &parse_error))
+    {
+        return MakeErrorResponse("invalid_args", parse_error);
+    }
+    if (g_discoveries.count(discovery_id) != 0)
+    {
+        return MakeErrorResponse("invalid_args", "Discovery is already running: " + discovery_id);
+    }
+
+    auto run = std::make_shared<DiscoveryRun>();
+    run->id = discovery_id;
+    StartDiscovery(run, args);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+FlMethodResponse *HandleCancelDiscovery(FlValue *args)
+{
+    std::string discovery_id;
+    std::string parse_error;
+    if (!ReadRequiredString(args, "discoveryId", &discovery_id, &parse_error))
+    {
+        return MakeErrorResponse("invalid_args", parse_error);
+    }
+    auto iterator = g_discoveries.find(discovery_id);
+    if (iterator != g_discoveries.end())
+    {
+        FinishDiscovery(std::shared_ptr<DiscoveryRun>(iterator->second));
     }
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+FlMethodErrorResponse *ListenDiscoveryEvents(FlEventChannel *channel, FlValue *args, gpointer user_data)
+{
+    g_discovery_events_listening = true;
+    return nullptr;
+}
+
+FlMethodErrorResponse *CancelDiscoveryEvents(FlEventChannel *channel, FlValue *args, gpointer user_data)
+{
+    g_discovery_events_listening = false;
+    return nullptr;
+}
 
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(devices));
+void FinishAllDiscoveries()
+{
+    std::vector<std::shared_ptr<DiscoveryRun>> runs;
+    for (const auto &entry : g_discoveries)
+    {
+        runs.push_back(entry.second);
+    }
+    for (const auto &run : runs)
+    {
+        FinishDiscovery(run);
+    }
 }
 
 void CloseAllSessions()
@@ -789,12 +3346,71 @@ void CloseAllSessions()
 
     for (auto &entry : current)
     {
+        UnlistSessionWriter(entry.first);
         CloseNativeConnection(entry.second.get());
     }
 }
 
 } // namespace
 
+intptr_t escpos_printer_ffi_initialize(void *post_c_object)
+{
+    if (post_c_object == nullptr)
+    {
+        return -1;
+    }
+    g_post_message = reinterpret_cast<escpos_printer::DartPostMessage>(post_c_object);
+    return 0;
+}
+
+uint8_t *escpos_printer_ffi_allocate(size_t length)
+{
+    return static_cast<uint8_t *>(malloc(length == 0 ? 1 : length));
+}
+
+void escpos_printer_ffi_free(uint8_t *buffer)
+{
+    free(buffer);
+}
+
+int32_t escpos_printer_ffi_write(const uint8_t *session_id, size_t session_id_length, uint8_t *buffer, size_t length,
+                                 int64_t request_id, int64_t port)
+{
+    if (g_post_message.load() == nullptr)
+    {
+        free(buffer);
+        return ESCPOS_PRINTER_FFI_NOT_INITIALIZED;
+    }
+
+    std::shared_ptr<SessionWriter> writer;
+    {
+        std::lock_guard<std::mutex> lock(g_session_writers_mutex);
+        auto iterator = g_session_writers.find(std::string(reinterpret_cast<const char *>(session_id), session_id_length));
+        if (iterator != g_session_writers.end())
+        {
+            writer = iterator->second;
+        }
+    }
+
+    // Written like a channel write: after a reconnect the failure is reported, not sent again.
+    DirectWrite write{buffer, length, request_id, port};
+    WriteTask task;
+    task.run = [write](NativeConnection *connection) mutable {
+        std::string error;
+        size_t reached = 0;
+        bool reconnected = false;
+        bool ok = WriteResumable(connection, write.bytes, write.length, {}, &reached, &reconnected, &error);
+        FinishDirectWrite(&write, ok ? nullptr : error.c_str(), reconnected);
+    };
+    task.cancel = [write](const char *reason) mutable { FinishDirectWrite(&write, reason, false); };
+    if (writer == nullptr || !QueueWriteTask(writer.get(), std::move(task)))
+    {
+        free(buffer);
+        return ESCPOS_PRINTER_FFI_INVALID_SESSION;
+    }
+    return ESCPOS_PRINTER_FFI_QUEUED;
+}
+
 static void escpos_printer_plugin_handle_method_call(EscposPrinterPlugin *self, FlMethodCall *method_call)
 {
     const gchar *method = fl_method_call_get_name(method_call);
@@ -804,11 +3420,75 @@ static void escpos_printer_plugin_handle_method_call(EscposPrinterPlugin *self,
 
     if (strcmp(method, "openConnection") == 0)
     {
-        response = HandleOpenConnection(args);
+        response = HandleOpenConnection(method_call, args);
+        if (response == nullptr)
+        {
+            return;
+        }
     }
     else if (strcmp(method, "write") == 0)
     {
-        response = HandleWrite(args);
+        response = HandleWrite(method_call, args);
+        if (response == nullptr)
+        {
+            return;
+        }
+    }
+    else if (strcmp(method, "writeBatch") == 0)
+    {
+        response = HandleWriteBatch(method_call, args);
+        if (response == nullptr)
+        {
+            return;
+        }
+    }
+    else if (strcmp(method, "retainJob") == 0)
+    {
+        response = HandleRetainJob(args);
+    }
+    else if (strcmp(method, "writeRetainedJob") == 0)
+    {
+        response = HandleWriteRetainedJob(method_call, args);
+        if (response == nullptr)
+        {
+            return;
+        }
+    }
+    else if (strcmp(method, "releaseJob") == 0)
+    {
+        response = HandleReleaseJob(args);
+    }
+    else if (strcmp(method, "beginJob") == 0)
+    {
+        response = HandleBeginJob(args);
+    }
+    else if (strcmp(method, "appendChunk") == 0)
+    {
+        response = HandleAppendChunk(method_call, args);
+        if (response == nullptr)
+        {
+            return;
+        }
+    }
+    else if (strcmp(method, "commitJob") == 0)
+    {
+        response = HandleCommitJob(method_call, args);
+        if (response == nullptr)
+        {
+            return;
+        }
+    }
+    else if (strcmp(method, "abortJob") == 0)
+    {
+        response = HandleAbortJob(args);
+    }
+    else if (strcmp(method, "readBytes") == 0)
+    {
+        response = HandleReadBytes(method_call, args);
+        if (response == nullptr)
+        {
+            return;
+        }
     }
     else if (strcmp(method, "readStatus") == 0)
     {
@@ -824,7 +3504,19 @@ static void escpos_printer_plugin_handle_method_call(EscposPrinterPlugin *self,
     }
     else if (strcmp(method, "searchPrinters") == 0)
     {
-        response = HandleSearchPrinters(args);
+        response = HandleSearchPrinters(method_call, args);
+        if (response == nullptr)
+        {
+            return;
+        }
+    }
+    else if (strcmp(method, "startDiscovery") == 0)
+    {
+        response = HandleStartDiscovery(args);
+    }
+    else if (strcmp(method, "cancelDiscovery") == 0)
+    {
+        response = HandleCancelDiscovery(args);
     }
     else
     {
@@ -837,6 +3529,24 @@ static void escpos_printer_plugin_handle_method_call(EscposPrinterPlugin *self,
 static void escpos_printer_plugin_dispose(GObject *object)
 {
     CloseAllSessions();
+    FinishAllDiscoveries();
+    if (g_link_watch != 0)
+    {
+        g_source_remove(g_link_watch);
+        g_link_watch = 0;
+    }
+    if (g_connection_events != nullptr)
+    {
+        g_object_unref(g_connection_events);
+        g_connection_events = nullptr;
+        g_connection_events_listening = false;
+    }
+    if (g_discovery_events != nullptr)
+    {
+        g_object_unref(g_discovery_events);
+        g_discovery_events = nullptr;
+        g_discovery_events_listening = false;
+    }
     G_OBJECT_CLASS(escpos_printer_plugin_parent_class)->dispose(object);
 }
 
@@ -864,5 +3574,11 @@ void escpos_printer_plugin_register_with_registrar(FlPluginRegistrar *registrar)
         fl_method_channel_new(fl_plugin_registrar_get_messenger(registrar), "escpos_printer/native_transport", FL_METHOD_CODEC(codec));
     fl_method_channel_set_method_call_handler(channel, method_call_cb, g_object_ref(plugin), g_object_unref);
 
+    g_connection_events = fl_event_channel_new(fl_plugin_registrar_get_messenger(registrar), "escpos_printer/connection_events", FL_METHOD_CODEC(codec));
+    fl_event_channel_set_stream_handlers(g_connection_events, ListenConnectionEvents, CancelConnectionEvents, nullptr, nullptr);
+
+    g_discovery_events = fl_event_channel_new(fl_plugin_registrar_get_messenger(registrar), "escpos_printer/discovery_events", FL_METHOD_CODEC(codec));
+    fl_event_channel_set_stream_handlers(g_discovery_events, ListenDiscoveryEvents, CancelDiscoveryEvents, nullptr, nullptr);
+
     g_object_unref(plugin);
 }
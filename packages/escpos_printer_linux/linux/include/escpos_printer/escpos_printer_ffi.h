@@ -0,0 +1,40 @@
+#ifndef FLUTTER_PLUGIN_ESCPOS_PRINTER_FFI_H_
+#define FLUTTER_PLUGIN_ESCPOS_PRINTER_FFI_H_
+
+#include "escpos_printer_plugin.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+G_BEGIN_DECLS
+
+// C ABI for writes from Dart through dart:ffi, without the method channel. Sessions are still opened and closed with
+// the channel; these functions only write to them.
+
+// Result of escpos_printer_ffi_write.
+enum
+{
+    ESCPOS_PRINTER_FFI_QUEUED = 0,
+    ESCPOS_PRINTER_FFI_NOT_INITIALIZED = -1,
+    ESCPOS_PRINTER_FFI_INVALID_SESSION = -2,
+};
+
+// Sets the function used to post completions. Pass NativeApi.postCObject; returns 0 on success.
+FLUTTER_PLUGIN_EXPORT intptr_t escpos_printer_ffi_initialize(void *post_c_object);
+
+// A buffer owned by the plugin, for Dart to fill in place. Returns NULL when out of memory.
+FLUTTER_PLUGIN_EXPORT uint8_t *escpos_printer_ffi_allocate(size_t length);
+
+// Frees a buffer from escpos_printer_ffi_allocate that was not passed to escpos_printer_ffi_write.
+FLUTTER_PLUGIN_EXPORT void escpos_printer_ffi_free(uint8_t *buffer);
+
+// Queues length bytes of buffer for the session and takes ownership of buffer, also when the write is rejected.
+// Writes run in order with the session's channel writes, on its writer thread, and reconnect like them: a failed
+// write reopens the link but is not sent again. Unless rejected, [request_id, error, reconnected] is posted to port
+// once the write is done, with error null on success and a message otherwise.
+FLUTTER_PLUGIN_EXPORT int32_t escpos_printer_ffi_write(const uint8_t *session_id, size_t session_id_length, uint8_t *buffer,
+                                                       size_t length, int64_t request_id, int64_t port);
+
+G_END_DECLS
+
+#endif // FLUTTER_PLUGIN_ESCPOS_PRINTER_FFI_H_
@@ -0,0 +1,113 @@
+#ifndef ESCPOS_PRINTER_PRINTER_PROFILES_H_
+#define ESCPOS_PRINTER_PRINTER_PROFILES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace escpos_printer
+{
+
+// How a model prints images best: GS v 0 raster, or ESC * column bands for firmware that lacks or mishandles GS v 0.
+enum class ImageFormat
+{
+    kRaster,
+    kColumn24,
+    kColumn8,
+};
+
+// Paper and memory geometry of a known printer model, looked up by USB VID/PID without talking to the device.
+struct PrinterProfile
+{
+    uint16_t vendor_id;
+    uint16_t product_id;
+    const char *name;
+    int dots_per_line;
+    // Characters per line with Font A (12x24) and Font B (9x17).
+    int font_a_columns;
+    int font_b_columns;
+    // Widest GS v 0 raster image, in dots.
+    int max_raster_width;
+    bool has_cutter;
+    // NV graphics memory in KiB; 0 when the model has none or it is not known.
+    int nv_graphics_kb;
+    // Bit n is set when the model supports ESC t n.
+    uint64_t code_pages;
+    ImageFormat image_format = ImageFormat::kRaster;
+};
+
+constexpr uint64_t CodePages(std::initializer_list<int> tables)
+{
+    uint64_t mask = 0;
+    for (int table : tables)
+    {
+        mask |= uint64_t{1} << table;
+    }
+    return mask;
+}
+
+// PC437, Katakana, PC850, PC860, PC863, PC865, WPC1252, PC866, PC852, PC858.
+constexpr uint64_t kEpsonCodePages = CodePages({0, 1, 2, 3, 4, 5, 16, 17, 18, 19});
+constexpr uint64_t kGenericCodePages = CodePages({0, 2, 3, 4, 5, 16, 17, 18, 19});
+
+// Sorted by vendor and product ID. Only models whose figures come from their technical reference belong here; the
+// README lists what each field needs when adding one. Vendors reuse a product ID across models (Epson's 0x0202 covers most older TM
+// printers), so such an entry describes the common configuration of that family. The 0x0202 family includes the TM-T88
+// and TM-T88II, which predate GS v 0, so it prints images as 24-dot columns, which every model in the family accepts.
+inline constexpr PrinterProfile kPrinterProfiles[] = {
+    {0x0416, 0x5011, "POS-58 thermal printer", 384, 32, 42, 384, false, 0, kGenericCodePages},
+    {0x04b8, 0x0202, "Epson TM-T88 series", 512, 42, 56, 512, true, 256, kEpsonCodePages, ImageFormat::kColumn24},
+    {0x04b8, 0x0e03, "Epson TM-T20", 576, 48, 64, 576, true, 256, kEpsonCodePages},
+    {0x04b8, 0x0e15, "Epson TM-T20II", 576, 48, 64, 576, true, 256, kEpsonCodePages},
+    {0x0fe6, 0x811e, "POS-80 thermal printer", 576, 48, 64, 576, true, 0, kGenericCodePages},
+};
+
+constexpr bool ProfilesSorted()
+{
+    for (size_t index = 1; index < sizeof(kPrinterProfiles) / sizeof(kPrinterProfiles[0]); index++)
+    {
+        const PrinterProfile &previous = kPrinterProfiles[index - 1];
+        const PrinterProfile &current = kPrinterProfiles[index];
+        if (previous.vendor_id > current.vendor_id || (previous.vendor_id == current.vendor_id && previous.product_id >= current.product_id))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(ProfilesSorted(), "kPrinterProfiles must be sorted by vendor and product ID");
+
+// The profile for a USB printer, or nullptr for an unknown model.
+constexpr const PrinterProfile *FindPrinterProfile(uint16_t vendor_id, uint16_t product_id)
+{
+    size_t low = 0;
+    size_t high = sizeof(kPrinterProfiles) / sizeof(kPrinterProfiles[0]);
+    uint32_t key = (uint32_t{vendor_id} << 16) | product_id;
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        uint32_t candidate = (uint32_t{kPrinterProfiles[middle].vendor_id} << 16) | kPrinterProfiles[middle].product_id;
+        if (candidate == key)
+        {
+            return &kPrinterProfiles[middle];
+        }
+        if (candidate < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return nullptr;
+}
+
+static_assert(FindPrinterProfile(0x04b8, 0x0e15)->dots_per_line == 576);
+static_assert(FindPrinterProfile(0x04b8, 0x0e16) == nullptr);
+static_assert(FindPrinterProfile(0x04b8, 0x0202)->image_format == ImageFormat::kColumn24);
+
+} // namespace escpos_printer
+
+#endif // ESCPOS_PRINTER_PRINTER_PROFILES_H_
@@ -0,0 +1,478 @@
+#include "uring_writer.h"
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+namespace escpos_printer
+{
+
+namespace
+{
+
+constexpr unsigned kRingEntries = 128;
+constexpr uint64_t kWakeTag = UINT64_MAX;
+
+int IoUringSetup(unsigned entries, io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int ring_fd, unsigned opcode, void *arg, unsigned count)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, count));
+}
+
+std::string ErrnoText(const char *context, int error_number)
+{
+    std::ostringstream out;
+    out << context << ": " << std::strerror(error_number);
+    return out.str();
+}
+
+unsigned *RingField(void *ring, uint32_t offset)
+{
+    return reinterpret_cast<unsigned *>(static_cast<uint8_t *>(ring) + offset);
+}
+
+} // namespace
+
+UringWriter *UringWriter::Instance()
+{
+    static UringWriter *instance = []() -> UringWriter * {
+        UringWriter *writer = new UringWriter();
+        if (!writer->Setup())
+        {
+            delete writer;
+            return nullptr;
+        }
+        std::thread(&UringWriter::Run, writer).detach();
+        return writer;
+    }();
+    return instance;
+}
+
+UringWriter::~UringWriter()
+{
+    if (buffers_ != nullptr)
+    {
+        munmap(buffers_, kBufferCount * kBufferSize);
+    }
+    if (sqes_ != nullptr)
+    {
+        munmap(sqes_, sqes_size_);
+    }
+    if (ring_ != nullptr)
+    {
+        munmap(ring_, ring_size_);
+    }
+    if (ring_fd_ >= 0)
+    {
+        close(ring_fd_);
+    }
+    if (wake_fd_ >= 0)
+    {
+        close(wake_fd_);
+    }
+}
+
+bool UringWriter::Setup()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring_fd_ = IoUringSetup(kRingEntries, &params);
+    if (ring_fd_ < 0)
+    {
+        return false;
+    }
+
+    // A single mapping for both rings keeps the setup short; every kernel with IORING_OP_SEND has it.
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0)
+    {
+        return false;
+    }
+
+    ring_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                          params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    void *ring = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED)
+    {
+        return false;
+    }
+    ring_ = ring;
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    sq_head_ = RingField(ring_, params.sq_off.head);
+    sq_tail_ = RingField(ring_, params.sq_off.tail);
+    sq_mask_ = *RingField(ring_, params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_array_ = RingField(ring_, params.sq_off.array);
+    cq_head_ = RingField(ring_, params.cq_off.head);
+    cq_tail_ = RingField(ring_, params.cq_off.tail);
+    cq_mask_ = *RingField(ring_, params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(static_cast<uint8_t *>(ring_) + params.cq_off.cqes);
+
+    const unsigned probe_ops = 256;
+    size_t probe_size = sizeof(io_uring_probe) + probe_ops * sizeof(io_uring_probe_op);
+    io_uring_probe *probe = static_cast<io_uring_probe *>(std::calloc(1, probe_size));
+    if (probe == nullptr)
+    {
+        return false;
+    }
+    bool probed = IoUringRegister(ring_fd_, IORING_REGISTER_PROBE, probe, probe_ops) == 0;
+    auto supported = [probe](unsigned op) { return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0; };
+    bool has_send = probed && supported(IORING_OP_SEND) && supported(IORING_OP_READ);
+    bool has_send_zc = probed && supported(IORING_OP_SEND_ZC);
+    std::free(probe);
+    if (!has_send)
+    {
+        return false;
+    }
+
+    wake_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd_ < 0)
+    {
+        return false;
+    }
+
+    for (unsigned index = kMaxInFlight; index > 0; index--)
+    {
+        free_slots_.push_back(index - 1);
+    }
+    if (has_send_zc)
+    {
+        RegisterBuffers();
+    }
+    return true;
+}
+
+// Zero-copy sends need pinned memory; without it (e.g. RLIMIT_MEMLOCK too low) every chunk uses IORING_OP_SEND.
+void UringWriter::RegisterBuffers()
+{
+    void *buffers = mmap(nullptr, kBufferCount * kBufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED)
+    {
+        return;
+    }
+
+    iovec vectors[kBufferCount];
+    for (unsigned index = 0; index < kBufferCount; index++)
+    {
+        vectors[index].iov_base = static_cast<uint8_t *>(buffers) + index * kBufferSize;
+        vectors[index].iov_len = kBufferSize;
+    }
+    if (IoUringRegister(ring_fd_, IORING_REGISTER_BUFFERS, vectors, kBufferCount) != 0)
+    {
+        munmap(buffers, kBufferCount * kBufferSize);
+        return;
+    }
+
+    buffers_ = static_cast<uint8_t *>(buffers);
+    for (int index = kBufferCount; index > 0; index--)
+    {
+        free_buffers_.push_back(index - 1);
+    }
+    zero_copy_supported_ = true;
+}
+
+void UringWriter::WriteAsync(int fd, const uint8_t *bytes, size_t length, bool allow_zero_copy, UringWriteCallback done)
+{
+    if (length == 0)
+    {
+        done(true, std::string());
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Request request;
+        request.bytes = bytes;
+        request.length = length;
+        request.allow_zero_copy = allow_zero_copy;
+        request.done = std::move(done);
+        sockets_[fd].queue.push_back(std::move(request));
+    }
+    eventfd_write(wake_fd_, 1);
+}
+
+bool UringWriter::Write(int fd, const uint8_t *bytes, size_t length, bool allow_zero_copy, std::string *error)
+{
+    std::mutex mutex;
+    std::condition_variable finished_changed;
+    bool finished = false;
+    bool ok = false;
+
+    WriteAsync(fd, bytes, length, allow_zero_copy, [&](bool result, const std::string &message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        ok = result;
+        *error = message;
+        finished_changed.notify_one();
+    });
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished_changed.wait(lock, [&finished] { return finished; });
+    return ok;
+}
+
+void UringWriter::CloseWhenIdle(int fd)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iterator = sockets_.find(fd);
+        if (iterator != sockets_.end() && (iterator->second.busy || !iterator->second.queue.empty()))
+        {
+            iterator->second.close_when_idle = true;
+            return;
+        }
+        if (iterator != sockets_.end())
+        {
+            sockets_.erase(iterator);
+        }
+    }
+    close(fd);
+}
+
+void UringWriter::Run()
+{
+    std::vector<Completion> completions;
+    for (;;)
+    {
+        unsigned to_submit;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            to_submit = FillSubmissions();
+        }
+
+        if (IoUringEnter(ring_fd_, to_submit, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EBUSY)
+        {
+            // Nothing left to wait for would be a bug; back off rather than spin.
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            unsigned head = *cq_head_;
+            unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++)
+            {
+                HandleCqe(cqes_[head & cq_mask_], &completions);
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+
+        for (Completion &completion : completions)
+        {
+            completion.done(completion.ok, completion.error);
+        }
+        completions.clear();
+    }
+}
+
+io_uring_sqe *UringWriter::NextSqe()
+{
+    unsigned tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)
+    {
+        return nullptr;
+    }
+
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+// Queues the wake-up read and the next chunk of every idle socket with pending writes.
+unsigned UringWriter::FillSubmissions()
+{
+    if (!wake_armed_)
+    {
+        io_uring_sqe *sqe = NextSqe();
+        if (sqe != nullptr)
+        {
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = wake_fd_;
+            sqe->addr = reinterpret_cast<uintptr_t>(&wake_value_);
+            sqe->len = sizeof(wake_value_);
+            sqe->user_data = kWakeTag;
+            wake_armed_ = true;
+        }
+    }
+
+    for (auto &entry : sockets_)
+    {
+        Socket &socket = entry.second;
+        if (socket.busy || socket.queue.empty())
+        {
+            continue;
+        }
+        if (free_slots_.empty())
+        {
+            break;
+        }
+
+        Request &request = socket.queue.front();
+        size_t remaining = request.length - request.offset;
+        bool zero_copy = zero_copy_supported_ && socket.zero_copy && request.allow_zero_copy && remaining >= kZeroCopyThreshold;
+        if (zero_copy && free_buffers_.empty())
+        {
+            continue;
+        }
+
+        io_uring_sqe *sqe = NextSqe();
+        if (sqe == nullptr)
+        {
+            break;
+        }
+
+        unsigned slot_index = free_slots_.back();
+        free_slots_.pop_back();
+        Slot &slot = slots_[slot_index];
+        slot.fd = entry.first;
+        slot.buffer = -1;
+        slot.awaiting_result = true;
+        slot.awaiting_notification = false;
+
+        sqe->fd = entry.first;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = slot_index;
+        if (zero_copy)
+        {
+            slot.buffer = free_buffers_.back();
+            free_buffers_.pop_back();
+            size_t chunk = std::min(remaining, kBufferSize);
+            uint8_t *buffer = buffers_ + static_cast<size_t>(slot.buffer) * kBufferSize;
+            std::memcpy(buffer, request.bytes + request.offset, chunk);
+
+            sqe->opcode = IORING_OP_SEND_ZC;
+            sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+            sqe->buf_index = static_cast<uint16_t>(slot.buffer);
+            sqe->addr = reinterpret_cast<uintptr_t>(buffer);
+            sqe->len = static_cast<uint32_t>(chunk);
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_SEND;
+            sqe->addr = reinterpret_cast<uintptr_t>(request.bytes + request.offset);
+            sqe->len = static_cast<uint32_t>(std::min<size_t>(remaining, UINT32_MAX));
+        }
+        socket.busy = true;
+    }
+
+    return *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+}
+
+void UringWriter::HandleCqe(const io_uring_cqe &cqe, std::vector<Completion> *completions)
+{
+    if (cqe.user_data == kWakeTag)
+    {
+        wake_armed_ = false;
+        return;
+    }
+
+    unsigned slot_index = static_cast<unsigned>(cqe.user_data);
+    Slot &slot = slots_[slot_index];
+    if ((cqe.flags & IORING_CQE_F_NOTIF) != 0)
+    {
+        slot.awaiting_notification = false;
+    }
+    else
+    {
+        slot.awaiting_result = false;
+        slot.awaiting_notification = (cqe.flags & IORING_CQE_F_MORE) != 0;
+        HandleResult(slot.fd, slot.buffer >= 0, cqe.res, completions);
+    }
+
+    if (!slot.awaiting_result && !slot.awaiting_notification)
+    {
+        if (slot.buffer >= 0)
+        {
+            free_buffers_.push_back(slot.buffer);
+            slot.buffer = -1;
+        }
+        free_slots_.push_back(slot_index);
+    }
+}
+
+void UringWriter::HandleResult(int fd, bool zero_copy, int result, std::vector<Completion> *completions)
+{
+    auto iterator = sockets_.find(fd);
+    if (iterator == sockets_.end())
+    {
+        return;
+    }
+
+    Socket &socket = iterator->second;
+    socket.busy = false;
+    Request &request = socket.queue.front();
+    if (zero_copy && result == -EOPNOTSUPP)
+    {
+        // Not every socket family does zero-copy; resend this chunk with a plain send.
+        socket.zero_copy = false;
+    }
+    else if (result == -EINTR)
+    {
+    }
+    else if (result <= 0)
+    {
+        completions->push_back({std::move(request.done), false, ErrnoText("Failed to send bytes", result == 0 ? EPIPE : -result)});
+        socket.queue.pop_front();
+    }
+    else
+    {
+        request.offset += static_cast<size_t>(result);
+        if (request.offset >= request.length)
+        {
+            completions->push_back({std::move(request.done), true, std::string()});
+            socket.queue.pop_front();
+        }
+    }
+
+    EraseIfIdle(fd);
+}
+
+void UringWriter::EraseIfIdle(int fd)
+{
+    auto iterator = sockets_.find(fd);
+    if (iterator == sockets_.end() || iterator->second.busy || !iterator->second.queue.empty())
+    {
+        return;
+    }
+
+    bool close_fd = iterator->second.close_when_idle;
+    sockets_.erase(iterator);
+    if (close_fd)
+    {
+        close(fd);
+    }
+}
+
+} // namespace escpos_printer
@@ -0,0 +1,134 @@
+#ifndef ESCPOS_PRINTER_URING_WRITER_H_
+#define ESCPOS_PRINTER_URING_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace escpos_printer
+{
+
+// Called on the writer thread once a write has been fully sent or has failed.
+using UringWriteCallback = std::function<void(bool ok, const std::string &error)>;
+
+// Socket writer backed by one io_uring shared by every session.
+//
+// A single thread gathers queued writes from all sockets and submits them with one io_uring_enter call. Chunks of at
+// least kZeroCopyThreshold bytes are staged in registered buffers and sent with IORING_OP_SEND_ZC when the caller
+// allows it; everything else is sent straight from the caller's memory with IORING_OP_SEND. Each socket has at most
+// one chunk in flight, so writes to one socket complete in the order they were queued.
+class UringWriter
+{
+  public:
+    static constexpr unsigned kMaxInFlight = 64;
+    static constexpr unsigned kBufferCount = 16;
+    static constexpr size_t kBufferSize = 64 * 1024;
+    static constexpr size_t kZeroCopyThreshold = 16 * 1024;
+
+    // The shared writer, or nullptr when the kernel lacks io_uring or IORING_OP_SEND.
+    static UringWriter *Instance();
+
+    // Queues a write. The bytes must stay valid until done has been called.
+    void WriteAsync(int fd, const uint8_t *bytes, size_t length, bool allow_zero_copy, UringWriteCallback done);
+
+    // Queues a write and blocks until it completes.
+    bool Write(int fd, const uint8_t *bytes, size_t length, bool allow_zero_copy, std::string *error);
+
+    // Closes fd once its queued writes have completed.
+    void CloseWhenIdle(int fd);
+
+    // Whether IORING_OP_SEND_ZC is available and the staging buffers could be registered.
+    bool SupportsZeroCopy() const
+    {
+        return zero_copy_supported_;
+    }
+
+    UringWriter(const UringWriter &) = delete;
+    UringWriter &operator=(const UringWriter &) = delete;
+
+  private:
+    struct Request
+    {
+        const uint8_t *bytes = nullptr;
+        size_t length = 0;
+        size_t offset = 0;
+        bool allow_zero_copy = false;
+        UringWriteCallback done;
+    };
+
+    struct Socket
+    {
+        std::deque<Request> queue;
+        bool busy = false;
+        bool zero_copy = true;
+        bool close_when_idle = false;
+    };
+
+    // One submitted operation. A zero-copy send keeps its buffer until the kernel posts the notification CQE.
+    struct Slot
+    {
+        int fd = -1;
+        int buffer = -1;
+        bool awaiting_result = false;
+        bool awaiting_notification = false;
+    };
+
+    struct Completion
+    {
+        UringWriteCallback done;
+        bool ok;
+        std::string error;
+    };
+
+    UringWriter() = default;
+    ~UringWriter();
+
+    bool Setup();
+    void RegisterBuffers();
+    void Run();
+    io_uring_sqe *NextSqe();
+    unsigned FillSubmissions();
+    void HandleCqe(const io_uring_cqe &cqe, std::vector<Completion> *completions);
+    void HandleResult(int fd, bool zero_copy, int result, std::vector<Completion> *completions);
+    void EraseIfIdle(int fd);
+
+    int ring_fd_ = -1;
+    int wake_fd_ = -1;
+    uint64_t wake_value_ = 0;
+    bool wake_armed_ = false;
+    bool zero_copy_supported_ = false;
+
+    void *ring_ = nullptr;
+    size_t ring_size_ = 0;
+    unsigned *sq_head_ = nullptr;
+    unsigned *sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned *sq_array_ = nullptr;
+    io_uring_sqe *sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+
+    uint8_t *buffers_ = nullptr;
+    Slot slots_[kMaxInFlight];
+    std::vector<unsigned> free_slots_;
+    std::vector<int> free_buffers_;
+
+    std::mutex mutex_;
+    std::unordered_map<int, Socket> sockets_;
+};
+
+} // namespace escpos_printer
+
+#endif // ESCPOS_PRINTER_URING_WRITER_H_
@@ -0,0 +1,147 @@
+#include "usb_input_reader.h"
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace escpos_printer
+{
+
+UsbInputReader::UsbInputReader(libusb_context *context, libusb_device_handle *handle, uint8_t endpoint, std::function<void()> on_data)
+    : context_(context), handle_(handle), endpoint_(endpoint), on_data_(std::move(on_data))
+{
+}
+
+UsbInputReader::~UsbInputReader()
+{
+    Stop();
+    if (transfer_ != nullptr)
+    {
+        libusb_free_transfer(transfer_);
+    }
+}
+
+bool UsbInputReader::Start(std::string *error)
+{
+    transfer_ = libusb_alloc_transfer(0);
+    if (transfer_ == nullptr)
+    {
+        *error = "Failed to allocate USB transfer.";
+        return false;
+    }
+
+    libusb_fill_bulk_transfer(transfer_, handle_, endpoint_, buffer_, kTransferSize, &UsbInputReader::OnTransfer, this, 0);
+    int rc = libusb_submit_transfer(transfer_);
+    if (rc != 0)
+    {
+        *error = std::string("Failed to start USB reads: ") + libusb_error_name(rc);
+        return false;
+    }
+
+    transfer_active_ = true;
+    event_thread_ = std::thread(&UsbInputReader::HandleEvents, this);
+    return true;
+}
+
+void UsbInputReader::Stop()
+{
+    if (!event_thread_.joinable())
+    {
+        return;
+    }
+
+    {
+        // Under the lock the completion callback cannot be between deciding to resubmit and resubmitting.
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        if (transfer_active_)
+        {
+            libusb_cancel_transfer(transfer_);
+        }
+    }
+    event_thread_.join();
+}
+
+void UsbInputReader::Take(size_t max_bytes, std::vector<uint8_t> *out)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = std::min(max_bytes, received_.size());
+    out->assign(received_.begin(), received_.begin() + static_cast<std::ptrdiff_t>(count));
+    received_.erase(received_.begin(), received_.begin() + static_cast<std::ptrdiff_t>(count));
+}
+
+size_t UsbInputReader::Available()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return received_.size();
+}
+
+std::string UsbInputReader::Error()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+}
+
+void LIBUSB_CALL UsbInputReader::OnTransfer(libusb_transfer *transfer)
+{
+    UsbInputReader *reader = static_cast<UsbInputReader *>(transfer->user_data);
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(reader->mutex_);
+        if (transfer->status == LIBUSB_TRANSFER_COMPLETED && transfer->actual_length > 0)
+        {
+            reader->received_.insert(reader->received_.end(), transfer->buffer, transfer->buffer + transfer->actual_length);
+            if (reader->received_.size() > kBufferLimit)
+            {
+                reader->received_.erase(reader->received_.begin(), reader->received_.end() - kBufferLimit);
+            }
+            notify = true;
+        }
+
+        bool keep_reading = transfer->status == LIBUSB_TRANSFER_COMPLETED || transfer->status == LIBUSB_TRANSFER_TIMED_OUT;
+        if (keep_reading && !reader->stopping_)
+        {
+            int rc = libusb_submit_transfer(transfer);
+            if (rc != 0)
+            {
+                reader->error_ = std::string("USB read stopped: ") + libusb_error_name(rc);
+                keep_reading = false;
+                notify = true;
+            }
+        }
+        else if (transfer->status != LIBUSB_TRANSFER_CANCELLED && !reader->stopping_)
+        {
+            reader->error_ = transfer->status == LIBUSB_TRANSFER_NO_DEVICE ? "USB device was disconnected." : "USB read failed.";
+            keep_reading = false;
+            notify = true;
+        }
+        else
+        {
+            keep_reading = false;
+        }
+        reader->transfer_active_ = keep_reading;
+    }
+
+    if (notify && reader->on_data_)
+    {
+        reader->on_data_();
+    }
+}
+
+void UsbInputReader::HandleEvents()
+{
+    while (transfer_active_ || !stopping_)
+    {
+        if (!transfer_active_)
+        {
+            // The endpoint failed; nothing is left to complete until Stop().
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
+        }
+        timeval timeout = {0, 100 * 1000};
+        libusb_handle_events_timeout_completed(context_, &timeout, nullptr);
+    }
+}
+
+} // namespace escpos_printer
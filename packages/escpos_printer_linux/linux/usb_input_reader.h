@@ -0,0 +1,72 @@
+#ifndef ESCPOS_PRINTER_USB_INPUT_READER_H_
+#define ESCPOS_PRINTER_USB_INPUT_READER_H_
+
+#include <libusb-1.0/libusb.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace escpos_printer
+{
+
+// Buffers what a printer sends on its bulk IN endpoint.
+//
+// One asynchronous transfer stays queued on the endpoint and is resubmitted as it completes; libusb events are
+// handled on a dedicated thread, so callers only ever touch the buffer. When more than kBufferLimit bytes are
+// waiting, the oldest are dropped.
+class UsbInputReader
+{
+  public:
+    static constexpr size_t kBufferLimit = 64 * 1024;
+    static constexpr int kTransferSize = 512;
+
+    // on_data runs on the event thread after bytes were buffered or the endpoint failed.
+    UsbInputReader(libusb_context *context, libusb_device_handle *handle, uint8_t endpoint, std::function<void()> on_data);
+    ~UsbInputReader();
+
+    bool Start(std::string *error);
+
+    // Cancels the transfer and joins the event thread. Must run before the device handle is closed.
+    void Stop();
+
+    // Moves up to max_bytes buffered bytes into out.
+    void Take(size_t max_bytes, std::vector<uint8_t> *out);
+
+    size_t Available();
+
+    // Set once the endpoint failed (e.g. the printer was unplugged); empty while reading.
+    std::string Error();
+
+    UsbInputReader(const UsbInputReader &) = delete;
+    UsbInputReader &operator=(const UsbInputReader &) = delete;
+
+  private:
+    static void LIBUSB_CALL OnTransfer(libusb_transfer *transfer);
+    void HandleEvents();
+
+    libusb_context *context_;
+    libusb_device_handle *handle_;
+    uint8_t endpoint_;
+    std::function<void()> on_data_;
+
+    libusb_transfer *transfer_ = nullptr;
+    unsigned char buffer_[kTransferSize];
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> transfer_active_{false};
+    std::thread event_thread_;
+
+    std::mutex mutex_;
+    std::deque<uint8_t> received_;
+    std::string error_;
+};
+
+} // namespace escpos_printer
+
+#endif // ESCPOS_PRINTER_USB_INPUT_READER_H_
@@ -30,6 +30,10 @@ public class EscposPrinterPlugin: NSObject, FlutterPlugin {
         let payload = try parseArgs(call.arguments)
         try handleWrite(payload: payload)
         result(nil)
+      case "writeBatch":
+        let payload = try parseArgs(call.arguments)
+        let response = try handleWriteBatch(payload: payload)
+        result(response)
       case "readStatus":
         let payload = try parseArgs(call.arguments)
         let status = try handleReadStatus(payload: payload)
@@ -120,6 +124,58 @@ public class EscposPrinterPlugin: NSObject, FlutterPlugin {
     try connection.write(typedBytes.data)
   }
 
+  // Writes each job of the concatenated batch in order; the first failure marks that job
+  // "failed" and the remaining ones "notSent".
+  private func handleWriteBatch(payload: [String: Any]) throws -> [String: Any] {
+    let sessionId = try requiredString(payload, key: "sessionId")
+    guard let connection = sessions[sessionId] else {
+      throw NativeTransportError.invalidSession("Session not found")
+    }
+
+    guard let typedBytes = payload["bytes"] as? FlutterStandardTypedData else {
+      throw NativeTransportError.invalidArgs("bytes field must be Uint8List")
+    }
+    guard let rawLengths = payload["jobLengths"] as? [NSNumber] else {
+      throw NativeTransportError.invalidArgs("jobLengths field must be a list")
+    }
+
+    let data = typedBytes.data
+    let jobLengths = rawLengths.map { $0.intValue }
+    guard jobLengths.allSatisfy({ $0 >= 0 }), jobLengths.reduce(0, +) == data.count else {
+      throw NativeTransportError.invalidArgs("jobLengths do not add up to the bytes length")
+    }
+
+    var jobs: [[String: Any]] = []
+    var offset = 0
+    var bytesWritten = 0
+    var failure: String?
+    for length in jobLengths {
+      var status = "notSent"
+      if failure == nil {
+        do {
+          let start = data.startIndex + offset
+          try connection.write(data.subdata(in: start..<(start + length)))
+          bytesWritten += length
+          status = "written"
+        } catch let error as NativeTransportError {
+          failure = error.message
+          status = "failed"
+        } catch {
+          failure = error.localizedDescription
+          status = "failed"
+        }
+      }
+      jobs.append(["offset": offset, "length": length, "status": status])
+      offset += length
+    }
+
+    return [
+      "jobs": jobs,
+      "bytesWritten": bytesWritten,
+      "error": failure.map { $0 as Any } ?? NSNull(),
+    ]
+  }
+
   private func handleReadStatus(payload: [String: Any]) throws -> [String: String] {
     let sessionId = try requiredString(payload, key: "sessionId")
     guard let connection = sessions[sessionId] else {
@@ -13,6 +13,12 @@ final class EndpointPayload {
     this.address,
     this.mode,
     this.serviceUuid,
+    this.ioBackend,
+    this.baudRate,
+    this.dataBits,
+    this.parity,
+    this.stopBits,
+    this.flowControl,
   });
 
   final String transport;
@@ -27,6 +33,16 @@ final class EndpointPayload {
   final String? mode;
   final String? serviceUuid;
 
+  /// Requested socket write backend: `standard` or `ioUring` (Linux only).
+  final String? ioBackend;
+
+  /// Serial line settings for device paths that are terminals (Linux).
+  final int? baudRate;
+  final int? dataBits;
+  final String? parity;
+  final int? stopBits;
+  final String? flowControl;
+
   Map<String, Object?> toMap() {
     return <String, Object?>{
       'transport': transport,
@@ -40,6 +56,12 @@ final class EndpointPayload {
       'address': address,
       'mode': mode,
       'serviceUuid': serviceUuid,
+      'ioBackend': ioBackend,
+      'baudRate': baudRate,
+      'dataBits': dataBits,
+      'parity': parity,
+      'stopBits': stopBits,
+      'flowControl': flowControl,
     };
   }
 }
@@ -50,6 +72,7 @@ final class DiscoveryRequestPayload {
     this.timeoutMs,
     this.wifiPort,
     this.wifiCidrs = const <String>[],
+    this.discoveryId,
   });
 
   final List<String> transports;
@@ -57,8 +80,12 @@ final class DiscoveryRequestPayload {
   final int? wifiPort;
   final List<String> wifiCidrs;
 
+  /// Tags the events of a `startDiscovery` run.
+  final String? discoveryId;
+
   Map<String, Object?> toMap() {
     return <String, Object?>{
+      'discoveryId': discoveryId,
       'transports': transports,
       'timeoutMs': timeoutMs,
       'wifiPort': wifiPort,
@@ -67,6 +94,74 @@ final class DiscoveryRequestPayload {
   }
 }
 
+/// Built-in model description attached by the platform (see
+/// `PrinterProfile`).
+final class ProfilePayload {
+  const ProfilePayload({
+    required this.name,
+    required this.dotsPerLine,
+    required this.fontAColumns,
+    required this.fontBColumns,
+    required this.maxRasterWidth,
+    required this.hasCutter,
+    this.nvGraphicsKb = 0,
+    this.codePages = const <int>[],
+    this.imageFormat = 'raster',
+  });
+
+  final String name;
+  final int dotsPerLine;
+  final int fontAColumns;
+  final int fontBColumns;
+  final int maxRasterWidth;
+  final bool hasCutter;
+  final int nvGraphicsKb;
+  final List<int> codePages;
+
+  /// `raster`, `column24` or `column8`.
+  final String imageFormat;
+
+  /// Null when [raw] is not a profile map.
+  static ProfilePayload? fromRaw(Object? raw) {
+    if (raw is! Map<Object?, Object?> || raw['name'] is! String) {
+      return null;
+    }
+    int readInt(String key) {
+      final value = raw[key];
+      return value is num ? value.toInt() : 0;
+    }
+
+    final rawCodePages = raw['codePages'];
+    return ProfilePayload(
+      name: raw['name']! as String,
+      dotsPerLine: readInt('dotsPerLine'),
+      fontAColumns: readInt('fontAColumns'),
+      fontBColumns: readInt('fontBColumns'),
+      maxRasterWidth: readInt('maxRasterWidth'),
+      hasCutter: raw['hasCutter'] == true,
+      nvGraphicsKb: readInt('nvGraphicsKb'),
+      codePages: rawCodePages is List<Object?>
+          ? rawCodePages.whereType<num>().map((page) => page.toInt()).toList()
+          : const <int>[],
+      imageFormat: raw['imageFormat'] as String? ?? 'raster',
+    );
+  }
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'name': name,
+      'dotsPerLine': dotsPerLine,
+      'fontAColumns': fontAColumns,
+      'fontBColumns': fontBColumns,
+      'maxRasterWidth': maxRasterWidth,
+      'hasCutter': hasCutter,
+      'nvGraphicsKb': nvGraphicsKb,
+      'codePages': codePages,
+      'imageFormat': imageFormat,
+    };
+  }
+}
+
 final class DiscoveredDevicePayload {
   const DiscoveredDevicePayload({
     this.id,
@@ -84,6 +179,7 @@ final class DiscoveredDevicePayload {
     this.serviceUuid,
     this.isPaired,
     this.metadata = const <String, Object?>{},
+    this.profile,
   });
 
   final String? id;
@@ -101,6 +197,7 @@ final class DiscoveredDevicePayload {
   final String? serviceUuid;
   final bool? isPaired;
   final Map<String, Object?> metadata;
+  final ProfilePayload? profile;
 
   factory DiscoveredDevicePayload.fromMap(Map<String, Object?> map) {
     int? readInt(String key) {
@@ -137,6 +234,7 @@ final class DiscoveredDevicePayload {
       serviceUuid: map['serviceUuid'] as String?,
       isPaired: map['isPaired'] as bool?,
       metadata: metadata,
+      profile: ProfilePayload.fromRaw(map['profile']),
     );
   }
 }
@@ -150,6 +248,11 @@ final class CapabilityPayload {
     this.supportsQrCode = true,
     this.supportsBarcode = true,
     this.supportsImage = true,
+    this.source,
+    this.model,
+    this.firmwareVersion,
+    this.manufacturer,
+    this.profile,
   });
 
   final bool supportsPartialCut;
@@ -160,12 +263,24 @@ final class CapabilityPayload {
   final bool supportsBarcode;
   final bool supportsImage;
 
+  /// `assumed`, `probed` or `cached`; null when the platform does not say.
+  final String? source;
+  final String? model;
+  final String? firmwareVersion;
+  final String? manufacturer;
+  final ProfilePayload? profile;
+
   factory CapabilityPayload.fromMap(Map<String, Object?> map) {
     bool read(String key, bool fallback) {
       final raw = map[key];
       return raw is bool ? raw : fallback;
     }
 
+    String? readText(String key) {
+      final raw = map[key];
+      return raw is String && raw.isNotEmpty ? raw : null;
+    }
+
     return CapabilityPayload(
       supportsPartialCut: read('supportsPartialCut', true),
       supportsFullCut: read('supportsFullCut', true),
@@ -174,6 +289,11 @@ final class CapabilityPayload {
       supportsQrCode: read('supportsQrCode', true),
       supportsBarcode: read('supportsBarcode', true),
       supportsImage: read('supportsImage', true),
+      source: readText('source'),
+      model: readText('model'),
+      firmwareVersion: readText('firmwareVersion'),
+      manufacturer: readText('manufacturer'),
+      profile: ProfilePayload.fromRaw(map['profile']),
     );
   }
 
@@ -186,6 +306,11 @@ final class CapabilityPayload {
       'supportsQrCode': supportsQrCode,
       'supportsBarcode': supportsBarcode,
       'supportsImage': supportsImage,
+      'source': source,
+      'model': model,
+      'firmwareVersion': firmwareVersion,
+      'manufacturer': manufacturer,
+      'profile': profile?.toMap(),
     };
   }
 }
@@ -252,6 +377,223 @@ final class WritePayload {
   }
 }
 
+/// Request for bytes the printer sent back (status, IDs, acknowledgements).
+///
+/// The platform answers with what is buffered, waiting up to [timeoutMs]
+/// for the first byte; an empty result means nothing arrived in time.
+final class ReadBytesPayload {
+  const ReadBytesPayload({
+    required this.sessionId,
+    required this.maxBytes,
+    required this.timeoutMs,
+  });
+
+  final String sessionId;
+  final int maxBytes;
+  final int timeoutMs;
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'sessionId': sessionId,
+      'maxBytes': maxBytes,
+      'timeoutMs': timeoutMs,
+    };
+  }
+}
+
+/// Several print jobs sent back to back in one call.
+///
+/// [bytes] holds every job concatenated; [jobLengths] splits it.
+final class WriteBatchPayload {
+  const WriteBatchPayload({
+    required this.sessionId,
+    required this.bytes,
+    required this.jobLengths,
+  });
+
+  final String sessionId;
+  final Uint8List bytes;
+  final List<int> jobLengths;
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'sessionId': sessionId,
+      'bytes': bytes,
+      'jobLengths': jobLengths,
+    };
+  }
+}
+
+final class BatchJobPayload {
+  const BatchJobPayload({
+    required this.offset,
+    required this.length,
+    required this.status,
+  });
+
+  final int offset;
+  final int length;
+
+  /// `written`, `failed` or `notSent`.
+  final String status;
+
+  factory BatchJobPayload.fromMap(Map<String, Object?> map) {
+    int readInt(String key) {
+      final raw = map[key];
+      return raw is num ? raw.toInt() : 0;
+    }
+
+    return BatchJobPayload(
+      offset: readInt('offset'),
+      length: readInt('length'),
+      status: map['status'] as String? ?? 'notSent',
+    );
+  }
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'offset': offset,
+      'length': length,
+      'status': status,
+    };
+  }
+}
+
+final class WriteBatchResponse {
+  const WriteBatchResponse({
+    this.jobs = const <BatchJobPayload>[],
+    this.bytesWritten = 0,
+    this.error,
+    this.reconnected = false,
+  });
+
+  final List<BatchJobPayload> jobs;
+  final int bytesWritten;
+
+  /// Native error that stopped the batch, if any.
+  final String? error;
+
+  /// Whether the platform reconnected the session during the batch and
+  /// already resumed it; the session stays open.
+  final bool reconnected;
+
+  factory WriteBatchResponse.fromMap(Map<String, Object?> map) {
+    final rawJobs = map['jobs'];
+    final jobs = <BatchJobPayload>[];
+    if (rawJobs is List<Object?>) {
+      for (final item in rawJobs) {
+        if (item is! Map<Object?, Object?>) {
+          continue;
+        }
+        jobs.add(
+          BatchJobPayload.fromMap(
+            item.map((Object? key, Object? value) {
+              return MapEntry('$key', value);
+            }),
+          ),
+        );
+      }
+    }
+
+    final rawBytesWritten = map['bytesWritten'];
+    return WriteBatchResponse(
+      jobs: List<BatchJobPayload>.unmodifiable(jobs),
+      bytesWritten: rawBytesWritten is num ? rawBytesWritten.toInt() : 0,
+      error: map['error'] as String?,
+      reconnected: map['reconnected'] == true,
+    );
+  }
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'jobs': jobs.map((job) => job.toMap()).toList(),
+      'bytesWritten': bytesWritten,
+      'error': error,
+      'reconnected': reconnected,
+    };
+  }
+}
+
+/// A job to keep on the platform side for repeated printing.
+///
+/// [separator] is written after a copy when `writeRetainedJob` asks for
+/// it, e.g. a cut between copies.
+final class RetainJobPayload {
+  const RetainJobPayload({
+    required this.sessionId,
+    required this.bytes,
+    this.separator,
+  });
+
+  final String sessionId;
+  final Uint8List bytes;
+  final Uint8List? separator;
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'sessionId': sessionId,
+      'bytes': bytes,
+      'separator': separator,
+    };
+  }
+}
+
+/// Names a job kept by `retainJob`.
+final class RetainedJobPayload {
+  const RetainedJobPayload({
+    required this.sessionId,
+    required this.jobId,
+    this.withSeparator = false,
+  });
+
+  final String sessionId;
+  final String jobId;
+
+  /// Whether `writeRetainedJob` also writes the job's separator.
+  final bool withSeparator;
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'sessionId': sessionId,
+      'jobId': jobId,
+      'withSeparator': withSeparator,
+    };
+  }
+}
+
+/// Names an open job stream (`beginJob` to `commitJob`/`abortJob`).
+final class JobStreamPayload {
+  const JobStreamPayload({required this.sessionId, required this.jobId});
+
+  final String sessionId;
+  final String jobId;
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{'sessionId': sessionId, 'jobId': jobId};
+  }
+}
+
+/// Next bytes of a job stream.
+final class AppendChunkPayload {
+  const AppendChunkPayload({
+    required this.sessionId,
+    required this.jobId,
+    required this.bytes,
+  });
+
+  final String sessionId;
+  final String jobId;
+  final Uint8List bytes;
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'sessionId': sessionId,
+      'jobId': jobId,
+      'bytes': bytes,
+    };
+  }
+}
+
 final class SessionPayload {
   const SessionPayload(this.sessionId);
 
@@ -266,11 +608,15 @@ final class OpenConnectionResponse {
   const OpenConnectionResponse({
     required this.sessionId,
     required this.capabilities,
+    this.ioBackend,
   });
 
   final String sessionId;
   final CapabilityPayload capabilities;
 
+  /// Write backend the session actually uses, when the platform reports it.
+  final String? ioBackend;
+
   factory OpenConnectionResponse.fromMap(Map<String, Object?> map) {
     final rawSessionId = map['sessionId'];
     if (rawSessionId is! String || rawSessionId.isEmpty) {
@@ -290,6 +636,7 @@ final class OpenConnectionResponse {
     return OpenConnectionResponse(
       sessionId: rawSessionId,
       capabilities: CapabilityPayload.fromMap(capabilitiesMap),
+      ioBackend: map['ioBackend'] as String?,
     );
   }
 
@@ -297,17 +644,169 @@ final class OpenConnectionResponse {
     return <String, Object?>{
       'sessionId': sessionId,
       'capabilities': capabilities.toMap(),
+      'ioBackend': ioBackend,
     };
   }
 }
 
+/// One event of a streaming discovery: a device, or the end of the run.
+final class DiscoveryEventPayload {
+  const DiscoveryEventPayload({
+    required this.discoveryId,
+    this.device,
+    this.done = false,
+  });
+
+  final String discoveryId;
+  final DiscoveredDevicePayload? device;
+  final bool done;
+
+  factory DiscoveryEventPayload.fromMap(Map<String, Object?> map) {
+    final rawDevice = map['device'];
+    return DiscoveryEventPayload(
+      discoveryId: map['discoveryId'] as String? ?? '',
+      device: rawDevice is Map<Object?, Object?>
+          ? DiscoveredDevicePayload.fromMap(
+              rawDevice.map((Object? key, Object? value) {
+                return MapEntry('$key', value);
+              }),
+            )
+          : null,
+      done: map['done'] as bool? ?? false,
+    );
+  }
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'discoveryId': discoveryId,
+      'device': device?.toMap(),
+      'done': done,
+    };
+  }
+}
+
+/// Link state change of an open session, sent by the platform.
+final class ConnectionEventPayload {
+  const ConnectionEventPayload({
+    required this.sessionId,
+    required this.state,
+    this.reason,
+  });
+
+  final String sessionId;
+
+  /// `connected`, `degraded` or `lost`.
+  final String state;
+  final String? reason;
+
+  factory ConnectionEventPayload.fromMap(Map<String, Object?> map) {
+    return ConnectionEventPayload(
+      sessionId: map['sessionId'] as String? ?? '',
+      state: map['state'] as String? ?? 'connected',
+      reason: map['reason'] as String?,
+    );
+  }
+
+  Map<String, Object?> toMap() {
+    return <String, Object?>{
+      'sessionId': sessionId,
+      'state': state,
+      'reason': reason,
+    };
+  }
+}
+
+/// Writes that reach the platform's transport without a method channel
+/// round trip, e.g. through `dart:ffi`.
+///
+/// Platform packages that support it set [opener] when they register;
+/// [NativeTransportApi] only reads [instance] when created with
+/// `useDirectWriter`, so apps that never opt in never bind a writer.
+/// Sessions are still opened and closed through [NativeTransportApi].
+abstract interface class NativeDirectWriter {
+  /// Binds the platform's writer. Called once, on the first read of
+  /// [instance].
+  static NativeDirectWriter? Function()? opener;
+
+  static NativeDirectWriter? _instance;
+  static bool _opened = false;
+
+  /// Writer of the platform, or `null` when it has none.
+  static NativeDirectWriter? get instance {
+    if (!_opened) {
+      _opened = true;
+      _instance = opener?.call();
+    }
+    return _instance;
+  }
+
+  static set instance(NativeDirectWriter? writer) {
+    _opened = true;
+    _instance = writer;
+  }
+
+  /// Completes once [bytes] are written to the session's link. Throws
+  /// [PlatformException] when the session is unknown or the write fails.
+  Future<void> write(String sessionId, Uint8List bytes);
+}
+
 /// Typed host API contract (MethodChannel-compatible implementation).
 class NativeTransportApi {
-  NativeTransportApi({MethodChannel? channel})
-    : _channel =
-          channel ?? const MethodChannel('escpos_printer/native_transport');
-
+  /// [write] uses [directWriter] when given. Otherwise it uses
+  /// [NativeDirectWriter.instance] at the time of each write if
+  /// [useDirectWriter] is set, and the method channel if not.
+  NativeTransportApi({
+    MethodChannel? channel,
+    EventChannel? connectionChannel,
+    EventChannel? discoveryChannel,
+    NativeDirectWriter? directWriter,
+    bool useDirectWriter = false,
+  }) : _directWriter = directWriter,
+       _useDirectWriter = useDirectWriter,
+       _channel =
+           channel ?? const MethodChannel('escpos_printer/native_transport'),
+       _connectionChannel =
+           connectionChannel ??
+           const EventChannel('escpos_printer/connection_events'),
+       _discoveryChannel =
+           discoveryChannel ??
+           const EventChannel('escpos_printer/discovery_events');
+
+  final NativeDirectWriter? _directWriter;
+  final bool _useDirectWriter;
   final MethodChannel _channel;
+  final EventChannel _connectionChannel;
+  final EventChannel _discoveryChannel;
+
+  /// Link state changes of all open sessions. Platforms without the event
+  /// channel never emit.
+  ///
+  /// One platform stream is shared by all listeners; a second
+  /// `receiveBroadcastStream` on the same channel would replace the first.
+  Stream<ConnectionEventPayload> get connectionEvents =>
+      _connectionEvents ??= _connectionChannel
+          .receiveBroadcastStream()
+          .where((event) => event is Map<Object?, Object?>)
+          .map((event) {
+            final map = (event as Map<Object?, Object?>).map((key, value) {
+              return MapEntry('$key', value);
+            });
+            return ConnectionEventPayload.fromMap(map);
+          });
+  Stream<ConnectionEventPayload>? _connectionEvents;
+
+  /// Events of all `startDiscovery` runs, shared like [connectionEvents].
+  Stream<DiscoveryEventPayload> get discoveryEvents =>
+      _discoveryEvents ??= _discoveryChannel
+          .receiveBroadcastStream()
+          .where((event) => event is Map<Object?, Object?>)
+          .map((event) {
+            final map = (event as Map<Object?, Object?>).map((key, value) {
+              return MapEntry('$key', value);
+            });
+            return DiscoveryEventPayload.fromMap(map);
+          });
+  Stream<DiscoveryEventPayload>? _discoveryEvents;
 
   Future<OpenConnectionResponse> openConnection(
     EndpointPayload endpoint,
@@ -329,10 +828,105 @@ class NativeTransportApi {
     return OpenConnectionResponse.fromMap(map);
   }
 
+  /// Goes through the [NativeDirectWriter] when one is in use.
+  ///
+  /// A failed write throws a `write_failed` [PlatformException]. Platforms
+  /// that reconnect by themselves set `details['reconnected']` when they
+  /// reopened the session's link: the session stays open, and the write was
+  /// not sent again.
   Future<void> write(WritePayload payload) async {
+    final directWriter =
+        _directWriter ??
+        (_useDirectWriter ? NativeDirectWriter.instance : null);
+    if (directWriter != null) {
+      await directWriter.write(payload.sessionId, payload.bytes);
+      return;
+    }
     await _channel.invokeMethod<void>('write', payload.toMap());
   }
 
+  Future<WriteBatchResponse> writeBatch(WriteBatchPayload payload) async {
+    final raw = await _channel.invokeMapMethod<Object?, Object?>(
+      'writeBatch',
+      payload.toMap(),
+    );
+    if (raw == null) {
+      throw PlatformException(
+        code: 'invalid_response',
+        message: 'Empty response for writeBatch.',
+      );
+    }
+
+    final map = raw.map((Object? key, Object? value) {
+      return MapEntry('$key', value);
+    });
+    return WriteBatchResponse.fromMap(map);
+  }
+
+  /// Keeps [payload]'s bytes on the platform and returns their job ID.
+  Future<String> retainJob(RetainJobPayload payload) async {
+    final raw = await _channel.invokeMapMethod<Object?, Object?>(
+      'retainJob',
+      payload.toMap(),
+    );
+    final jobId = raw?['jobId'];
+    if (jobId is! String) {
+      throw PlatformException(
+        code: 'invalid_response',
+        message: 'Missing jobId in retainJob response.',
+      );
+    }
+    return jobId;
+  }
+
+  /// Writes one copy of a retained job. Fails like [write].
+  Future<void> writeRetainedJob(RetainedJobPayload payload) async {
+    await _channel.invokeMethod<void>('writeRetainedJob', payload.toMap());
+  }
+
+  Future<void> releaseJob(RetainedJobPayload payload) async {
+    await _channel.invokeMethod<void>('releaseJob', payload.toMap());
+  }
+
+  /// Opens a job stream on the session and returns its job ID.
+  Future<String> beginJob(SessionPayload payload) async {
+    final raw = await _channel.invokeMapMethod<Object?, Object?>(
+      'beginJob',
+      payload.toMap(),
+    );
+    final jobId = raw?['jobId'];
+    if (jobId is! String) {
+      throw PlatformException(
+        code: 'invalid_response',
+        message: 'Missing jobId in beginJob response.',
+      );
+    }
+    return jobId;
+  }
+
+  /// Completes once the platform has buffered the chunk, which waits while
+  /// its buffer is full.
+  Future<void> appendChunk(AppendChunkPayload payload) async {
+    await _channel.invokeMethod<void>('appendChunk', payload.toMap());
+  }
+
+  /// Completes once every appended byte has been written to the printer.
+  Future<void> commitJob(JobStreamPayload payload) async {
+    await _channel.invokeMethod<void>('commitJob', payload.toMap());
+  }
+
+  Future<void> abortJob(JobStreamPayload payload) async {
+    await _channel.invokeMethod<void>('abortJob', payload.toMap());
+  }
+
+  Future<Uint8List> readBytes(ReadBytesPayload payload) async {
+    final raw = await _channel.invokeMethod<Uint8List>(
+      'readBytes',
+      payload.toMap(),
+    );
+    return raw ?? Uint8List(0);
+  }
+
   Future<StatusPayload> readStatus(SessionPayload payload) async {
     final raw = await _channel.invokeMapMethod<Object?, Object?>(
       'readStatus',
@@ -399,4 +993,17 @@ class NativeTransportApi {
     }
     return List<DiscoveredDevicePayload>.unmodifiable(devices);
   }
+
+  /// Starts a discovery whose devices arrive on [discoveryEvents] under
+  /// [DiscoveryRequestPayload.discoveryId], followed by a `done` event.
+  Future<void> startDiscovery(DiscoveryRequestPayload payload) async {
+    await _channel.invokeMethod<void>('startDiscovery', payload.toMap());
+  }
+
+  /// Ends a running discovery early; the platform still sends `done`.
+  Future<void> cancelDiscovery(String discoveryId) async {
+    await _channel.invokeMethod<void>('cancelDiscovery', <String, Object?>{
+      'discoveryId': discoveryId,
+    });
+  }
 }
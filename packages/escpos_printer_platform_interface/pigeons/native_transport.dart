@@ -22,6 +22,34 @@ class WritePayload {
   const WritePayload();
 }
 
+class WriteBatchPayload {
+  const WriteBatchPayload();
+}
+
+class WriteBatchResponse {
+  const WriteBatchResponse();
+}
+
+class RetainJobPayload {
+  const RetainJobPayload();
+}
+
+class RetainedJobPayload {
+  const RetainedJobPayload();
+}
+
+class JobStreamPayload {
+  const JobStreamPayload();
+}
+
+class AppendChunkPayload {
+  const AppendChunkPayload();
+}
+
+class ReadBytesPayload {
+  const ReadBytesPayload();
+}
+
 class SessionPayload {
   const SessionPayload();
 }
@@ -37,8 +65,19 @@ class DiscoveredDevicePayload {
 abstract class NativeTransportApi {
   OpenConnectionResponse openConnection(EndpointPayload endpoint);
   void write(WritePayload payload);
+  WriteBatchResponse writeBatch(WriteBatchPayload payload);
+  String retainJob(RetainJobPayload payload);
+  void writeRetainedJob(RetainedJobPayload payload);
+  void releaseJob(RetainedJobPayload payload);
+  String beginJob(SessionPayload payload);
+  void appendChunk(AppendChunkPayload payload);
+  void commitJob(JobStreamPayload payload);
+  void abortJob(JobStreamPayload payload);
+  List<int> readBytes(ReadBytesPayload payload);
   StatusPayload readStatus(SessionPayload payload);
   void closeConnection(SessionPayload payload);
   CapabilityPayload getCapabilities(SessionPayload payload);
   List<DiscoveredDevicePayload> searchPrinters(DiscoveryRequestPayload payload);
+  void startDiscovery(DiscoveryRequestPayload payload);
+  void cancelDiscovery(String discoveryId);
 }
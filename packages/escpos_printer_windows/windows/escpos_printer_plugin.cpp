@@ -250,6 +250,67 @@ std::string LastSocketErrorText(const char *context)
     return out.str();
 }
 
+std::vector<size_t> RequireLengths(const EncodableMap &args, const char *key)
+{
+    const EncodableValue *raw = FindArg(args, key);
+    const auto *list = raw == nullptr ? nullptr : std::get_if<EncodableList>(raw);
+    if (list == nullptr)
+    {
+        throw std::runtime_error(std::string("Missing or invalid list field: ") + key);
+    }
+
+    std::vector<size_t> lengths;
+    for (const auto &value : *list)
+    {
+        int64_t length = -1;
+        if (const auto *value32 = std::get_if<int32_t>(&value))
+        {
+            length = *value32;
+        }
+        else if (const auto *value64 = std::get_if<int64_t>(&value))
+        {
+            length = *value64;
+        }
+        if (length < 0)
+        {
+            throw std::runtime_error(std::string("Invalid length in field: ") + key);
+        }
+        lengths.push_back(static_cast<size_t>(length));
+    }
+    return lengths;
+}
+
+bool WriteToSession(NativeSession *session, const uint8_t *bytes, size_t length, std::string *error)
+{
+    size_t offset = 0;
+    while (offset < length)
+    {
+        if (session->kind == SessionKind::kUsbFile)
+        {
+            DWORD written = 0;
+            BOOL ok = WriteFile(session->handle, bytes + offset, static_cast<DWORD>(length - offset), &written, nullptr);
+            if (!ok || written == 0)
+            {
+                *error = "Failed to send bytes on USB device.";
+                return false;
+            }
+            offset += written;
+        }
+        else
+        {
+            int sent = send(session->socket, reinterpret_cast<const char *>(bytes + offset), static_cast<int>(length - offset), 0);
+            if (sent <= 0)
+            {
+                *error = LastSocketErrorText("Failed to send bytes");
+                return false;
+            }
+            offset += static_cast<size_t>(sent);
+        }
+    }
+
+    return true;
+}
+
 std::string WideToUtf8(const std::wstring &input)
 {
     if (input.empty())
@@ -811,28 +872,85 @@ void EscposPrinterPlugin::HandleMethodCall(const flutter::MethodCall<flutter::En
                 return;
             }
 
-            NativeSession *session = iterator->second.get();
-            if (session->kind == SessionKind::kUsbFile)
+            std::string write_error;
+            if (!WriteToSession(iterator->second.get(), bytes.data(), bytes.size(), &write_error))
             {
-                DWORD written = 0;
-                BOOL ok = WriteFile(session->handle, bytes.data(), static_cast<DWORD>(bytes.size()), &written, nullptr);
-                if (!ok || written != bytes.size())
-                {
-                    result->Error("write_failed", "Failed to send bytes on USB device.");
-                    return;
-                }
+                result->Error("write_failed", write_error);
+                return;
             }
-            else
+
+            result->Success();
+            return;
+        }
+
+        if (method == "writeBatch")
+        {
+            if (args == nullptr)
             {
-                int sent = send(session->socket, reinterpret_cast<const char *>(bytes.data()), static_cast<int>(bytes.size()), 0);
-                if (sent <= 0 || sent != static_cast<int>(bytes.size()))
+                result->Error("invalid_args", "writeBatch requires a map payload.");
+                return;
+            }
+
+            std::string session_id = RequireString(*args, "sessionId");
+            std::vector<uint8_t> bytes = RequireBytes(*args, "bytes");
+            std::vector<size_t> job_lengths = RequireLengths(*args, "jobLengths");
+
+            size_t total = 0;
+            for (size_t job_length : job_lengths)
+            {
+                total += job_length;
+            }
+            if (total != bytes.size())
+            {
+                result->Error("invalid_args", "jobLengths do not add up to the bytes length.");
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(g_mutex);
+            auto iterator = g_sessions.find(session_id);
+            if (iterator == g_sessions.end())
+            {
+                result->Error("invalid_session", "Session not found.");
+                return;
+            }
+
+            // Jobs are written in order; the first failure marks that job "failed" and the rest "notSent".
+            EncodableList jobs;
+            std::string write_error;
+            bool failed = false;
+            size_t offset = 0;
+            size_t bytes_written = 0;
+            for (size_t job_length : job_lengths)
+            {
+                std::string status = "notSent";
+                if (!failed)
                 {
-                    result->Error("write_failed", LastSocketErrorText("Failed to send bytes"));
-                    return;
+                    if (WriteToSession(iterator->second.get(), bytes.data() + offset, job_length, &write_error))
+                    {
+                        status = "written";
+                        bytes_written += job_length;
+                    }
+                    else
+                    {
+                        status = "failed";
+                        failed = true;
+                    }
                 }
+
+                jobs.push_back(EncodableValue(EncodableMap{
+                    {EncodableValue("offset"), EncodableValue(static_cast<int64_t>(offset))},
+                    {EncodableValue("length"), EncodableValue(static_cast<int64_t>(job_length))},
+                    {EncodableValue("status"), EncodableValue(status)},
+                }));
+                offset += job_length;
             }
 
-            result->Success();
+            EncodableMap response{
+                {EncodableValue("jobs"), EncodableValue(jobs)},
+                {EncodableValue("bytesWritten"), EncodableValue(static_cast<int64_t>(bytes_written))},
+                {EncodableValue("error"), failed ? EncodableValue(write_error) : EncodableValue()},
+            };
+            result->Success(EncodableValue(response));
             return;
         }
 